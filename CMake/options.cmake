@@ -71,18 +71,35 @@ if (APPLE)
   endif (CMAKE_OSX_SYSROOT)
 endif (APPLE)
 
+if (UNIX AND NOT APPLE)
+  option (OPTION_USE_HEADLESS "draw into memory instead of using an X server" OFF)
+  mark_as_advanced (OPTION_USE_HEADLESS)
+endif (UNIX AND NOT APPLE)
+
 # find X11 libraries and headers
 set (PATH_TO_XLIBS)
 if ((NOT APPLE OR OPTION_APPLE_X11) AND NOT WIN32)
   include (FindX11)
-  if (X11_FOUND)
+  if (OPTION_USE_HEADLESS)
+    # the X11 headers are still needed for platform types, but neither the
+    # X11 libraries nor any of its extensions are used
+    if (NOT X11_INCLUDE_DIR)
+      message (FATAL_ERROR "OPTION_USE_HEADLESS requires the X11 headers")
+    endif (NOT X11_INCLUDE_DIR)
+    set (USE_HEADLESS 1)
+    foreach (ext Xinerama Xfixes Xcursor Xft Xrender Xdbe)
+      string (TOUPPER ${ext} EXT)
+      set (X11_${ext}_FOUND FALSE)
+      set (OPTION_USE_${EXT} OFF)
+    endforeach (ext)
+  elseif (X11_FOUND)
     set (USE_X11 1)
     list (APPEND FLTK_LDLIBS -lX11)
     if (X11_Xext_FOUND)
       list (APPEND FLTK_LDLIBS -lXext)
     endif (X11_Xext_FOUND)
     get_filename_component (PATH_TO_XLIBS ${X11_X11_LIB} PATH)
-  endif (X11_FOUND)
+  endif (OPTION_USE_HEADLESS)
 endif ((NOT APPLE OR OPTION_APPLE_X11) AND NOT WIN32)
 
 if (OPTION_APPLE_X11)
@@ -116,6 +133,21 @@ if (OPTION_USE_POLL)
   CHECK_FUNCTION_EXISTS(poll USE_POLL)
 endif (OPTION_USE_POLL)
 
+option (OPTION_USE_EPOLL "use epoll if available (Linux, overrides poll)" OFF)
+mark_as_advanced (OPTION_USE_EPOLL)
+
+if (OPTION_USE_EPOLL)
+  CHECK_FUNCTION_EXISTS(epoll_create1 USE_EPOLL)
+endif (OPTION_USE_EPOLL)
+
+#######################################################################
+option (OPTION_EVENT_LOOP_STATS "measure event loop latencies (see Fl_Loop_Stats)" OFF)
+mark_as_advanced (OPTION_EVENT_LOOP_STATS)
+
+if (OPTION_EVENT_LOOP_STATS)
+  set (USE_EVENT_LOOP_STATS 1)
+endif (OPTION_EVENT_LOOP_STATS)
+
 #######################################################################
 option (OPTION_BUILD_SHARED_LIBS
   "Build shared libraries (in addition to static libraries)"
@@ -232,7 +264,7 @@ if (HAVE_GL)
    option (OPTION_USE_GL "use OpenGL" ON)
 endif (HAVE_GL)
 
-if (OPTION_USE_GL)
+if (OPTION_USE_GL AND NOT USE_HEADLESS)
   if (OPTION_APPLE_X11)
     set (OPENGL_FOUND TRUE)
     set (OPENGL_LIBRARIES -L${PATH_TO_XLIBS} -lGLU -lGL)
@@ -248,7 +280,7 @@ if (OPTION_USE_GL)
   endif (OPTION_APPLE_X11)
 else ()
   set (OPENGL_FOUND FALSE)
-endif (OPTION_USE_GL)
+endif (OPTION_USE_GL AND NOT USE_HEADLESS)
 
 if (OPENGL_FOUND)
   set (CMAKE_REQUIRED_INCLUDES ${OPENGL_INCLUDE_DIR}/GL)
@@ -596,9 +628,9 @@ else(OPTION_USE_XRENDER)
 endif (OPTION_USE_XRENDER)
 
 #######################################################################
-if (X11_FOUND)
+if (X11_FOUND AND NOT USE_HEADLESS)
   option (OPTION_USE_XDBE "use lib Xdbe" ON)
-endif (X11_FOUND)
+endif (X11_FOUND AND NOT USE_HEADLESS)
 
 if (OPTION_USE_XDBE AND HAVE_XDBE_H)
   set (HAVE_XDBE 1)
@@ -609,9 +641,9 @@ endif (OPTION_USE_XDBE AND HAVE_XDBE_H)
 
 #######################################################################
 set (FL_NO_PRINT_SUPPORT FALSE)
-if (X11_FOUND AND NOT OPTION_PRINT_SUPPORT)
+if ((X11_FOUND AND NOT OPTION_PRINT_SUPPORT) OR USE_HEADLESS)
   set (FL_NO_PRINT_SUPPORT TRUE)
-endif (X11_FOUND AND NOT OPTION_PRINT_SUPPORT)
+endif ((X11_FOUND AND NOT OPTION_PRINT_SUPPORT) OR USE_HEADLESS)
 #######################################################################
 
 #######################################################################
@@ -58,6 +58,7 @@ fl_find_header (HAVE_OPENGL_GLU_H OpenGL/glu.h)
 fl_find_header (HAVE_PNG_H png.h)
 fl_find_header (HAVE_STDIO_H stdio.h)
 fl_find_header (HAVE_STRINGS_H strings.h)
+fl_find_header (HAVE_SYS_EVENTFD_H sys/eventfd.h)
 fl_find_header (HAVE_SYS_SELECT_H sys/select.h)
 fl_find_header (HAVE_SYS_STDTYPES_H sys/stdtypes.h)
 
@@ -153,7 +154,7 @@ mark_as_advanced (HAVE_LIBPNG_PNG_H HAVE_LOCALE_H HAVE_NDIR_H)
 mark_as_advanced (HAVE_OPENGL_GLU_H HAVE_PNG_H)
 mark_as_advanced (HAVE_PTHREAD_H HAVE_PTHREAD_MUTEX_RECURSIVE)
 mark_as_advanced (HAVE_STDIO_H HAVE_STRINGS_H HAVE_SYS_DIR_H)
-mark_as_advanced (HAVE_SYS_NDIR_H HAVE_SYS_SELECT_H)
+mark_as_advanced (HAVE_SYS_EVENTFD_H HAVE_SYS_NDIR_H HAVE_SYS_SELECT_H)
 mark_as_advanced (HAVE_SYS_STDTYPES_H HAVE_XDBE_H)
 mark_as_advanced (HAVE_X11_XREGION_H)
 
@@ -23,6 +23,8 @@
 #include "Fl_Screen_Driver.H"
 #include "Fl_Window_Driver.H"
 #include "Fl_System_Driver.H"
+#include "Fl_Timeout.h"
+#include "fl_loop_stats.h"
 #include <FL/Fl_Window.H>
 #include <FL/Fl_Tooltip.H>
 #include <FL/fl_draw.H>
@@ -227,6 +229,73 @@ int Fl::event_inside(const Fl_Widget *o) /*const*/ {
   return (mx >= 0 && mx < o->w() && my >= 0 && my < o->h());
 }
 
+//
+// motion history of merged mouse motion events, see Fl::OPTION_COMPRESS_MOTION
+//
+
+static int *motion_xy;          // x_root, y_root of each merged motion event
+static int motion_count, motion_alloc;
+
+// Called by the platform code before it merges motion events.
+void fl_reset_motion_history() {
+  motion_count = 0;
+}
+
+// Called by the platform code for each merged motion event, including the
+// last one that is delivered, after Fl::e_x_root and Fl::e_y_root are set.
+void fl_add_motion_history() {
+  if (motion_count >= motion_alloc) {
+    motion_alloc = motion_alloc ? 2 * motion_alloc : 32;
+    motion_xy = (int*)realloc(motion_xy, 2 * motion_alloc * sizeof(int));
+  }
+  motion_xy[2 * motion_count] = Fl::e_x_root;
+  motion_xy[2 * motion_count + 1] = Fl::e_y_root;
+  motion_count++;
+}
+
+/** Returns the number of mouse positions of the current FL_MOVE or FL_DRAG event.
+
+    If Fl::OPTION_COMPRESS_MOTION is on, several mouse motion events that
+    were queued at the same time can be merged into one FL_MOVE or FL_DRAG
+    event. Applications that need all positions, e.g. to draw a freehand
+    line, can get them with Fl::event_motion_x(i) and Fl::event_motion_y(i)
+    for i = 0 ... event_motion_count() - 1, in the order they happened.
+
+    The last position is always the one of Fl::event_x() and Fl::event_y(),
+    and the return value is 1 if no events were merged.
+
+    \see Fl::event_motion_x(int), Fl::event_motion_y(int)
+    \version 1.4.0
+*/
+int Fl::event_motion_count() {
+  // the history is only valid for the event that recorded it
+  if (!motion_count ||
+      motion_xy[2 * motion_count - 2] != e_x_root ||
+      motion_xy[2 * motion_count - 1] != e_y_root)
+    return 1;
+  return motion_count;
+}
+
+/** Returns the horizontal position of the i-th merged mouse position.
+    The position is relative to the same window as Fl::event_x().
+    \see Fl::event_motion_count()
+    \version 1.4.0
+*/
+int Fl::event_motion_x(int i) {
+  if (i < 0 || i >= event_motion_count() - 1) return e_x;
+  return e_x + motion_xy[2 * i] - e_x_root;
+}
+
+/** Returns the vertical position of the i-th merged mouse position.
+    The position is relative to the same window as Fl::event_y().
+    \see Fl::event_motion_count()
+    \version 1.4.0
+*/
+int Fl::event_motion_y(int i) {
+  if (i < 0 || i >= event_motion_count() - 1) return e_y;
+  return e_y + motion_xy[2 * i + 1] - e_y_root;
+}
+
 //
 //
 // timer support
@@ -259,6 +328,60 @@ void Fl::remove_timeout(Fl_Timeout_Handler cb, void *argp) {
   Fl::screen_driver()->remove_timeout(cb, argp);
 }
 
+/**
+ Adds a one-shot timeout callback and returns its identifier.
+
+ This works like Fl::add_timeout(), but the returned id can be used
+ to test for or remove exactly this timeout with Fl::has_timeout_id()
+ and Fl::remove_timeout_id(), even if other timeouts use the same
+ callback and data. Removing a timeout by its id is a constant time
+ operation on platforms that support it.
+
+ \returns the timeout's id, or 0 if the platform doesn't support timeout
+   ids, in which case you must use Fl::remove_timeout() instead
+
+ \see Fl::add_timeout()
+ \version 1.4.0
+ */
+Fl_Timeout_Id Fl::add_timeout_id(double time, Fl_Timeout_Handler cb, void *argp) {
+  return Fl::screen_driver()->add_timeout_id(time, cb, argp);
+}
+
+/**
+ Repeats a timeout callback and returns its identifier.
+
+ This works like Fl::repeat_timeout() and returns an id like
+ Fl::add_timeout_id().
+
+ \see Fl::repeat_timeout(), Fl::add_timeout_id()
+ \version 1.4.0
+ */
+Fl_Timeout_Id Fl::repeat_timeout_id(double time, Fl_Timeout_Handler cb, void *argp) {
+  return Fl::screen_driver()->repeat_timeout_id(time, cb, argp);
+}
+
+/**
+ Returns true if the timeout with the given id exists and has not been
+ called yet.
+
+ \see Fl::add_timeout_id()
+ \version 1.4.0
+ */
+int Fl::has_timeout_id(Fl_Timeout_Id id) {
+  return id ? Fl::screen_driver()->has_timeout_id(id) : 0;
+}
+
+/**
+ Removes the timeout with the given id. It is harmless to remove a timeout
+ that has already been called or removed.
+
+ \see Fl::add_timeout_id()
+ \version 1.4.0
+ */
+void Fl::remove_timeout_id(Fl_Timeout_Id id) {
+  if (id) Fl::screen_driver()->remove_timeout_id(id);
+}
+
 
 
 ////////////////////////////////////////////////////////////////
@@ -359,7 +482,9 @@ void Fl::run_checks()
     while (next_check) {
       Check* checkp = next_check;
       next_check = checkp->next;
+      FL_LOOP_STATS_START(t);
       (checkp->cb)(checkp->arg);
+      FL_LOOP_STATS_END(t, CHECK, checkp->cb);
     }
     next_check = first_check;
   }
@@ -446,6 +571,8 @@ void (*Fl::idle)(); // see Fl::add_idle.cxx for the add/remove functions
 double Fl::wait(double time_to_wait) {
   // delete all widgets that were listed during callbacks
   do_widget_deletion();
+  // don't block if the deletion continues in the next iteration
+  if (pending_widget_deletions()) time_to_wait = 0.0;
   return screen_driver()->wait(time_to_wait);
 }
 
@@ -607,6 +734,91 @@ void Fl::redraw() {
   for (Fl_X* i = Fl_X::first; i; i = i->next) i->w->redraw();
 }
 
+// Frame pacing, see Fl::max_fps():
+static double frame_interval = 0.0;     // minimal time between frames, 0 = off
+static double last_frame = 0.0;         // time of the last frame, see Fl_Timeout::now()
+static unsigned long frames_drawn_ = 0;
+static unsigned long frames_skipped_ = 0;
+
+// The frame timeout only wakes up Fl::wait() which will then call Fl::flush()
+static void next_frame_cb(void *) {}
+
+/**
+  Limits the rate at which Fl::flush() redraws damaged windows.
+
+  By default Fl::flush() redraws all damaged windows whenever it is called,
+  i.e. on every iteration of the event loop. If a widget is updated at a high
+  rate (for instance by a timer or by Fl::awake() handlers), it is drawn
+  as often as it is updated.
+
+  If a maximum frame rate is set, Fl::flush() collects the damage and draws
+  all damaged windows at most \p fps times per second. Damage that occurs
+  between two frames is merged and drawn in the next frame, which is
+  scheduled automatically. Hence high-rate updates only cost one draw per
+  frame. Set \p fps to the display's refresh rate to draw at most once per
+  display refresh.
+
+  \param[in] fps  maximum number of frames per second, 0 (default) to draw
+    without delay
+  \see Fl::frames_drawn(), Fl::frames_skipped()
+  \version 1.4.0
+*/
+void Fl::max_fps(double fps) {
+  frame_interval = fps > 0.0 ? 1.0 / fps : 0.0;
+  if (!frame_interval) Fl::remove_timeout(next_frame_cb);
+}
+
+/**
+  Returns the maximum frame rate set by Fl::max_fps(double), 0 if not set.
+  \version 1.4.0
+*/
+double Fl::max_fps() {
+  return frame_interval > 0.0 ? 1.0 / frame_interval : 0.0;
+}
+
+/**
+  Schedules the widget to be redrawn in the next frame.
+
+  This marks the widget as damaged like Fl_Widget::redraw() and makes sure
+  that the next frame is scheduled if a frame rate was set with Fl::max_fps().
+  Any number of calls before the next frame result in a single draw.
+  \version 1.4.0
+*/
+void Fl::redraw_next_frame(Fl_Widget *w) {
+  w->redraw();
+  if (frame_interval > 0.0 && !Fl::has_timeout(next_frame_cb)) {
+    double wait = last_frame + frame_interval - Fl_Timeout::now();
+    Fl::add_timeout(wait > 0.0 ? wait : 0.0, next_frame_cb);
+  }
+}
+
+/**
+  Returns the number of times Fl::flush() has drawn damaged windows.
+  \see Fl::max_fps(), Fl::reset_frame_stats()
+  \version 1.4.0
+*/
+unsigned long Fl::frames_drawn() {
+  return frames_drawn_;
+}
+
+/**
+  Returns the number of times Fl::flush() postponed drawing to the next frame.
+  This is the number of draws saved by Fl::max_fps().
+  \see Fl::max_fps(), Fl::reset_frame_stats()
+  \version 1.4.0
+*/
+unsigned long Fl::frames_skipped() {
+  return frames_skipped_;
+}
+
+/**
+  Resets the counters returned by Fl::frames_drawn() and Fl::frames_skipped().
+  \version 1.4.0
+*/
+void Fl::reset_frame_stats() {
+  frames_drawn_ = frames_skipped_ = 0;
+}
+
 /**
   Causes all the windows that need it to be redrawn and graphics forced
   out through the pipes.
@@ -617,9 +829,27 @@ void Fl::redraw() {
   from the main thread. If a child thread needs to trigger a redraw event,
   it should instead call Fl::awake() to get the main thread to process the
   event queue.
+
+  If a maximum frame rate was set with Fl::max_fps(), drawing may be
+  postponed to the next frame.
 */
 void Fl::flush() {
   if (damage()) {
+    if (frame_interval > 0.0) {
+      double now = Fl_Timeout::now();
+      double wait = last_frame + frame_interval - now;
+      if (wait > 0.0 && wait <= frame_interval) {
+        // too early: keep the damage and draw everything at the next frame
+        frames_skipped_++;
+        if (!Fl::has_timeout(next_frame_cb))
+          Fl::add_timeout(wait, next_frame_cb);
+        screen_driver()->flush();
+        return;
+      }
+      last_frame = now;
+    }
+    FL_LOOP_STATS_START(t);
+    frames_drawn_++;
     damage_ = 0;
     for (Fl_X* i = Fl_X::first; i; i = i->next) {
       Fl_Window* wi = i->w;
@@ -635,6 +865,7 @@ void Fl::flush() {
         i->region = 0;
       }
     }
+    FL_LOOP_STATS_END(t, FLUSH, 0);
   }
   screen_driver()->flush();
 }
@@ -972,11 +1203,21 @@ void fl_fix_focus() {
 // FL_LEAVE or FL_UNFOCUS events to the widget.  This appears to not be
 // desirable behavior and caused flwm to crash.
 
+// Set by Fl_Group::clear() while it deletes its children: nothing needs
+// to be done for a child that contains none of these widgets.
+int fl_quick_throw_focus = 0;
+
 void fl_throw_focus(Fl_Widget *o) {
 #ifdef DEBUG
   printf("fl_throw_focus(o=%p)\n", o);
 #endif // DEBUG
 
+  if (fl_quick_throw_focus &&
+      !o->contains(Fl::pushed()) && !o->contains(fl_selection_requestor) &&
+      !o->contains(Fl::belowmouse()) && !o->contains(Fl::focus()) &&
+      o != fl_xfocus && o != Fl_Tooltip::current() && o != fl_xmousewin)
+    return;
+
   if (o->contains(Fl::pushed())) Fl::pushed_ = 0;
   if (o->contains(fl_selection_requestor)) fl_selection_requestor = 0;
   if (o->contains(Fl::belowmouse())) Fl::belowmouse_ = 0;
@@ -1417,7 +1658,7 @@ void Fl_Widget::redraw_label() {
       // If the label is not inside the widget, compute the location of
       // the label and redraw the window within that bounding box...
       int W = 0, H = 0;
-      label_.measure(W, H);
+      measure_label(W, H);
       W += 5; // Add a little to the size of the label to cover overflow
       H += 5;
 
@@ -1525,6 +1766,7 @@ void Fl_Widget::damage(uchar fl, int X, int Y, int W, int H) {
 
 static int        num_dwidgets = 0, alloc_dwidgets = 0;
 static Fl_Widget  **dwidgets = 0;
+static double     deletion_budget = 0.0; // see Fl::widget_deletion_budget()
 
 
 /**
@@ -1568,15 +1810,16 @@ void Fl::delete_widget(Fl_Widget *wi) {
 
   if (num_dwidgets >= alloc_dwidgets) {
     Fl_Widget **temp;
+    int n = alloc_dwidgets ? 2 * alloc_dwidgets : 16;
 
-    temp = new Fl_Widget *[alloc_dwidgets + 10];
+    temp = new Fl_Widget *[n];
     if (alloc_dwidgets) {
       memcpy(temp, dwidgets, alloc_dwidgets * sizeof(Fl_Widget *));
       delete[] dwidgets;
     }
 
     dwidgets = temp;
-    alloc_dwidgets += 10;
+    alloc_dwidgets = n;
   }
 
   dwidgets[num_dwidgets] = wi;
@@ -1593,21 +1836,147 @@ void Fl::delete_widget(Fl_Widget *wi) {
     you call Fl::wait(). The previously scheduled widgets are deleted in the
     same order they were scheduled by calling Fl::delete_widget().
 
+    If a time budget was set with Fl::widget_deletion_budget(double), this
+    stops deleting widgets when the budget is used up. The remaining widgets
+    are deleted by the next calls.
+
     \see Fl::delete_widget(Fl_Widget *wi)
 */
 void Fl::do_widget_deletion() {
   if (!num_dwidgets) return;
 
-  for (int i = 0; i < num_dwidgets; i ++)
-    delete dwidgets[i];
+  double end = deletion_budget > 0.0 ? Fl_Timeout::now() + deletion_budget : 0.0;
+  int i;
+  for (i = 0; i < num_dwidgets; ) {
+    delete dwidgets[i++];
+    if (end && i < num_dwidgets && Fl_Timeout::now() >= end) break;
+  }
 
-  num_dwidgets = 0;
+  num_dwidgets -= i;
+  if (num_dwidgets)
+    memmove(dwidgets, dwidgets + i, num_dwidgets * sizeof(Fl_Widget *));
 }
 
 
-static Fl_Widget ***widget_watch = 0;
-static int num_widget_watch = 0;
-static int max_widget_watch = 0;
+/**
+  Sets the time per event loop iteration for the deletion of widgets.
+
+  By default all widgets scheduled with Fl::delete_widget() are deleted
+  at once by the next call of Fl::wait(). Deleting a large number of
+  widgets can take a noticeable time, during which the application does
+  not respond.
+
+  If a time budget is set, Fl::wait() stops deleting widgets when the
+  budget is used up, and doesn't block until all scheduled widgets have
+  been deleted. Deletion is thus spread over several iterations of the
+  event loop, and events are handled in between. At least one widget is
+  deleted per iteration. A group or window is deleted with all its
+  children in one step: schedule the children of a very large group
+  separately to spread their deletion too.
+
+  \param[in] seconds maximum time per event loop iteration,
+    0 (default) to delete all scheduled widgets at once
+  \see Fl::pending_widget_deletions()
+  \version 1.4.0
+*/
+void Fl::widget_deletion_budget(double seconds) {
+  deletion_budget = seconds > 0.0 ? seconds : 0.0;
+}
+
+/**
+  Returns the time budget for the deletion of widgets.
+  \see Fl::widget_deletion_budget(double)
+  \version 1.4.0
+*/
+double Fl::widget_deletion_budget() {
+  return deletion_budget;
+}
+
+/**
+  Returns the number of widgets that are scheduled for deletion.
+  \see Fl::delete_widget(), Fl::widget_deletion_budget(double)
+  \version 1.4.0
+*/
+int Fl::pending_widget_deletions() {
+  return num_dwidgets;
+}
+
+
+// The widget watch list is hashed twice: by the address of the watched
+// pointer for Fl::watch_widget_pointer() and Fl::release_widget_pointer(),
+// and by the widget it points to for Fl::clear_widget_pointer(), which is
+// called by every widget destructor. Entries are chained by their index in
+// widget_watch[], unused entries are linked in a free list.
+
+struct Fl_Widget_Watch {
+  Fl_Widget **wp;               // the watched widget pointer
+  const Fl_Widget *w;           // the widget it points to, NULL if cleared
+  int next_wp;                  // next entry in the pointer chain or free list
+  int next_w;                   // next entry in the widget chain
+};
+
+static Fl_Widget_Watch *widget_watch = 0;
+static int num_widget_watch = 0;        // entries in use
+static int max_widget_watch = 0;        // allocated entries, a power of 2
+static int free_widget_watch = -1;      // first unused entry
+static int *widget_watch_wp = 0;        // first entry of each pointer chain
+static int *widget_watch_w = 0;         // first entry of each widget chain
+
+static int widget_watch_bucket(const void *p) {
+  unsigned long v = (unsigned long)(fl_intptr_t)p;
+  v ^= v >> 16;
+  v *= 0x45d9f3bUL;
+  v ^= v >> 16;
+  return (int)(v & (max_widget_watch - 1));
+}
+
+static void link_widget_watch(int i) {
+  int b = widget_watch_bucket(widget_watch[i].wp);
+  widget_watch[i].next_wp = widget_watch_wp[b];
+  widget_watch_wp[b] = i;
+  if (widget_watch[i].w) {
+    b = widget_watch_bucket(widget_watch[i].w);
+    widget_watch[i].next_w = widget_watch_w[b];
+    widget_watch_w[b] = i;
+  }
+}
+
+// Removes entry i from the chain of its widget.
+static void unlink_widget_watch(int i) {
+  int *p = widget_watch_w + widget_watch_bucket(widget_watch[i].w);
+  while (*p != i) p = &widget_watch[*p].next_w;
+  *p = widget_watch[i].next_w;
+  widget_watch[i].w = 0;
+}
+
+// Doubles the number of entries and rebuilds the hash tables.
+static void grow_widget_watch() {
+  int i, old = max_widget_watch;
+  max_widget_watch = old ? 2 * old : 16;
+  widget_watch = (Fl_Widget_Watch*)realloc(widget_watch, sizeof(Fl_Widget_Watch)*max_widget_watch);
+  widget_watch_wp = (int*)realloc(widget_watch_wp, sizeof(int)*max_widget_watch);
+  widget_watch_w = (int*)realloc(widget_watch_w, sizeof(int)*max_widget_watch);
+  for (i = 0; i < max_widget_watch; i++) widget_watch_wp[i] = widget_watch_w[i] = -1;
+  for (i = 0; i < old; i++) link_widget_watch(i); // all entries are in use
+  for (i = max_widget_watch - 1; i >= old; i--) {
+    widget_watch[i].next_wp = free_widget_watch;
+    free_widget_watch = i;
+  }
+}
+
+// Returns the entry of a watched pointer, or -1. If prev is not NULL, it
+// is set to the previous entry of the pointer chain, or -1.
+static int find_widget_watch(Fl_Widget **wp, int *prev = 0) {
+  if (!num_widget_watch) return -1;
+  int p = -1;
+  for (int i = widget_watch_wp[widget_watch_bucket(wp)]; i >= 0; p = i, i = widget_watch[i].next_wp) {
+    if (widget_watch[i].wp == wp) {
+      if (prev) *prev = p;
+      return i;
+    }
+  }
+  return -1;
+}
 
 
 /**
@@ -1646,6 +2015,10 @@ static int max_widget_watch = 0;
    This works, because all widgets call Fl::clear_widget_pointer() in their
    destructors.
 
+   The watch list remembers the widget the pointer points to when it is
+   added. If you assign another widget to a watched pointer, call
+   Fl::watch_widget_pointer() again to watch the new widget.
+
    \see Fl::release_widget_pointer()
    \see Fl::clear_widget_pointer()
 
@@ -1658,18 +2031,27 @@ static int max_widget_watch = 0;
 void Fl::watch_widget_pointer(Fl_Widget *&w)
 {
   Fl_Widget **wp = &w;
-  int i;
-  for (i=0; i<num_widget_watch; ++i) {
-    if (widget_watch[i]==wp) return;
-  }
-  if (num_widget_watch==max_widget_watch) {
-    max_widget_watch += 8;
-    widget_watch = (Fl_Widget***)realloc(widget_watch, sizeof(Fl_Widget**)*max_widget_watch);
+  int i = find_widget_watch(wp);
+  if (i >= 0) { // already watched, but the pointer may have been changed
+    if (widget_watch[i].w) unlink_widget_watch(i);
+    widget_watch[i].w = w;
+    if (w) {
+      int b = widget_watch_bucket(w);
+      widget_watch[i].next_w = widget_watch_w[b];
+      widget_watch_w[b] = i;
+    }
+    return;
   }
-  widget_watch[num_widget_watch++] = wp;
+  if (free_widget_watch < 0) grow_widget_watch();
+  i = free_widget_watch;
+  free_widget_watch = widget_watch[i].next_wp;
+  widget_watch[i].wp = wp;
+  widget_watch[i].w = w;
+  link_widget_watch(i);
+  num_widget_watch++;
 #ifdef DEBUG_WATCH
   printf ("\nwatch_widget_pointer:   (%d/%d) %8p => %8p\n",
-    num_widget_watch,num_widget_watch,wp,*wp);
+    i+1,num_widget_watch,wp,*wp);
   fflush(stdout);
 #endif // DEBUG_WATCH
 }
@@ -1688,25 +2070,22 @@ void Fl::watch_widget_pointer(Fl_Widget *&w)
 void Fl::release_widget_pointer(Fl_Widget *&w)
 {
   Fl_Widget **wp = &w;
-  int i,j=0;
-  for (i=0; i<num_widget_watch; ++i) {
-    if (widget_watch[i]!=wp) {
-      if (j<i) widget_watch[j] = widget_watch[i]; // fill gap
-      j++;
-    }
+  int prev, i = find_widget_watch(wp, &prev);
+  if (i < 0) return;
 #ifdef DEBUG_WATCH
-    else { // found widget pointer
-      printf("release_widget_pointer: (%d/%d) %8p => %8p\n",
-             i+1, num_widget_watch, wp, *wp);
-    }
+  printf("release_widget_pointer: (%d/%d) %8p => %8p\n",
+         i+1, num_widget_watch, wp, *wp);
 #endif //DEBUG_WATCH
-  }
-  num_widget_watch = j;
+  if (widget_watch[i].w) unlink_widget_watch(i);
+  if (prev < 0) widget_watch_wp[widget_watch_bucket(wp)] = widget_watch[i].next_wp;
+  else widget_watch[prev].next_wp = widget_watch[i].next_wp;
+  widget_watch[i].next_wp = free_widget_watch;
+  free_widget_watch = i;
+  num_widget_watch--;
 #ifdef DEBUG_WATCH
   printf ("                        num_widget_watch = %d\n\n",num_widget_watch);
   fflush(stdout);
 #endif // DEBUG_WATCH
-  return;
 }
 
 
@@ -1718,8 +2097,10 @@ void Fl::release_widget_pointer(Fl_Widget *&w)
 
   \note Internal use only !
 
-  This method searches the widget watch list for pointers to the widget and
-  clears each pointer that points to it. Widget pointers can be added to the
+  This method looks up the pointers to the widget in the widget watch list
+  and clears each pointer that still points to it. The watch list is hashed
+  by widget, so this takes constant time on average, independent of the
+  number of watched pointers. Widget pointers can be added to the
   widget watch list by calling Fl::watch_widget_pointer() or by using the
   helper class Fl_Widget_Tracker (recommended).
 
@@ -1728,11 +2109,16 @@ void Fl::release_widget_pointer(Fl_Widget *&w)
 */
 void Fl::clear_widget_pointer(Fl_Widget const *w)
 {
-  if (w==0L) return;
-  int i;
-  for (i=0; i<num_widget_watch; ++i) {
-    if (widget_watch[i] && *widget_watch[i]==w) {
-      *widget_watch[i] = 0L;
+  if (w==0L || !num_widget_watch) return;
+  int *p = widget_watch_w + widget_watch_bucket(w);
+  while (*p >= 0) {
+    Fl_Widget_Watch &e = widget_watch[*p];
+    if (e.w == w) { // remove the entry from the widget chain
+      if (*e.wp == w) *e.wp = 0L;
+      e.w = 0L;
+      *p = e.next_w;
+    } else {
+      p = &e.next_w;
     }
   }
 }
@@ -1795,6 +2181,8 @@ bool Fl::option(Fl_Option opt)
 
       opt_prefs.get("ShowZoomFactor", tmp, 1);                  // default: on
       options_[OPTION_SHOW_SCALING] = tmp;
+      opt_prefs.get("CompressMotion", tmp, 0);                  // default: off
+      options_[OPTION_COMPRESS_MOTION] = tmp;
     }
     { // next, check the user preferences
       // override system options only, if the option is set ( >= 0 )
@@ -1819,6 +2207,8 @@ bool Fl::option(Fl_Option opt)
 
       opt_prefs.get("ShowZoomFactor", tmp, -1);
       if (tmp >= 0) options_[OPTION_SHOW_SCALING] = tmp;
+      opt_prefs.get("CompressMotion", tmp, -1);
+      if (tmp >= 0) options_[OPTION_COMPRESS_MOTION] = tmp;
     }
     { // now, if the developer has registered this app, we could ask for per-application preferences
     }
@@ -1954,6 +2344,11 @@ int Fl::clipboard_contains(const char *type)
  Under UNIX/Linux/MacOS <I>any</I> file descriptor can be monitored (files,
  devices, pipes, sockets, etc.). Due to limitations in Microsoft Windows,
  Windows applications can only monitor sockets.
+
+ If FLTK was built with the epoll() backend (CMake option OPTION_USE_EPOLL,
+ Linux only) the bit FL_EDGE_TRIGGERED can be added to \p when. The callback
+ is then only called when the file descriptor \e becomes ready and must read
+ or write until the operation would block. Other backends ignore this bit.
  */
 void Fl::add_fd(int fd, int when, Fl_FD_Handler cb, void *d)
 {
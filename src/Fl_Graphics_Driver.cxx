@@ -38,6 +38,8 @@ const Fl_Graphics_Driver::matrix Fl_Graphics_Driver::m0 = {1, 0, 0, 1, 0, 0};
 /** Used by the Windows platform to print Fl_Pixmap objects. */
 unsigned Fl_Graphics_Driver::need_pixmap_bg_color = 0;
 
+unsigned Fl_Graphics_Driver::font_generation_ = 0;
+
 /** Constructor */
 Fl_Graphics_Driver::Fl_Graphics_Driver()
 {
@@ -52,6 +54,8 @@ Fl_Graphics_Driver::Fl_Graphics_Driver()
   scale_ = 1;
   p_size = 0;
   p = NULL;
+  static unsigned last_serial = 0;
+  serial_ = ++last_serial;
 };
 
 /** Return the graphics driver used when drawing to the platform's display */
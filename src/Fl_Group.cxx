@@ -21,10 +21,13 @@
 
 #include <FL/Fl_Group.H>
 #include "Fl_Window_Driver.H"
+#include "Fl_Spatial_Index.h"
 #include <FL/Fl_Rect.H>
+#include <FL/Fl_Device.H>
 #include <FL/fl_draw.H>
 
 #include <stdlib.h> // malloc etc.
+#include <string.h> // memmove()
 
 Fl_Group* Fl_Group::current_;
 
@@ -45,10 +48,40 @@ Fl_Widget*const* Fl_Group::array() const {
   Searches the child array for the widget and returns the index.
 
   Returns children() if the widget is NULL or not found.
+
+  Every child remembers its index, so this takes constant time unless
+  many children before it were added or removed since the last call. Then
+  the indexes of the children from the first change to the end are updated.
 */
 int Fl_Group::find(const Fl_Widget* o) const {
+  if (!o || o->parent_ != this) return children_;
+  // a stale parent_ may point at a group without children, then array()
+  // has no first or last child to look at
+  if (children_ <= 0) return children_;
   Fl_Widget*const* a = array();
-  int i; for (i=0; i < children_; i++) if (*a++ == o) break;
+  int i = o->index_;
+  if (i < children_ && a[i] == o) return i;
+  // cheap tests for the first and last child, e.g. for re-parenting loops
+  Fl_Widget *w = (Fl_Widget*)o;
+  if (a[0] == o) return w->index_ = 0;
+  if (a[children_-1] == o) return w->index_ = children_-1;
+  // a few children before it were added or removed: look near the old index
+  if (i >= children_) i = children_-1;
+  for (int d = 1; d <= 32; d++) {
+    if (i-d >= 0 && a[i-d] == o) return w->index_ = i-d;
+    if (i+d < children_ && a[i+d] == o) return w->index_ = i+d;
+  }
+  // update the indexes that may have changed
+  for (i = num_indexed_; i < children_; i++) a[i]->index_ = i;
+  num_indexed_ = children_;
+  i = o->index_;
+  if (i < children_ && a[i] == o) return i;
+  // a subclass rearranged array(), e.g. Fl_Scroll::fix_scrollbar_order()
+  for (i = 0; i < children_; i++) {
+    a[i]->index_ = i;
+    if (a[i] == o) break;
+  }
+  num_indexed_ = i;
   return i;
 }
 
@@ -87,6 +120,7 @@ Fl_Group *Fl_Group::current() {return current_;}
 void Fl_Group::current(Fl_Group *g) {current_ = g;}
 
 extern Fl_Widget* fl_oldfocus; // set by Fl::focus
+extern int fl_quick_throw_focus; // in Fl.cxx
 
 // For back-compatibility, we must adjust all events sent to child
 // windows so they are relative to that window.
@@ -141,12 +175,44 @@ static int navkey() {
   return 0;
 }
 
+// Number of children under the mouse that handle() collects from the
+// spatial index: if there are more, all children are tested.
+#define MAX_HITS 64
+
+/*
+  Returns the children that may contain the mouse position in list, in
+  child order: with a spatial index these are stored in hits, otherwise
+  list is array() and all children are returned.
+*/
+int Fl_Group::children_at_event(Fl_Widget*const*& list, Fl_Widget** hits) {
+  list = array();
+  if (!layout_ || !layout_->spatial_index) return children_;
+  const int *idx;
+  int n = layout_->spatial_index->find(this, Fl::event_x(), Fl::event_y(), idx);
+  if (n > MAX_HITS) return children_;
+  for (int i = 0; i < n; i++) hits[i] = list[idx[i]];
+  list = hits;
+  return n;
+}
+
 int Fl_Group::handle(int event) {
 
   Fl_Widget*const* a = array();
   int i;
   Fl_Widget* o;
 
+  // the children that may be under the mouse, see spatial_index(int)
+  Fl_Widget* hits[MAX_HITS];
+  Fl_Widget*const* b = a;
+  int nb = children();
+  switch (event) {
+  case FL_SHORTCUT: case FL_ENTER: case FL_MOVE: case FL_DND_ENTER:
+  case FL_DND_DRAG: case FL_PUSH: case FL_RELEASE: case FL_DRAG:
+  case FL_MOUSEWHEEL:
+    nb = children_at_event(b, hits);
+    break;
+  }
+
   switch (event) {
 
   case FL_FOCUS:
@@ -172,8 +238,8 @@ int Fl_Group::handle(int event) {
     return navigation(navkey());
 
   case FL_SHORTCUT:
-    for (i = children(); i--;) {
-      o = a[i];
+    for (i = nb; i--;) {
+      o = b[i];
       if (o->takesevents() && Fl::event_inside(o) && send(o,FL_SHORTCUT))
         return 1;
     }
@@ -187,8 +253,8 @@ int Fl_Group::handle(int event) {
 
   case FL_ENTER:
   case FL_MOVE:
-    for (i = children(); i--;) {
-      o = a[i];
+    for (i = nb; i--;) {
+      o = b[i];
       if (o->visible() && Fl::event_inside(o)) {
         if (o->contains(Fl::belowmouse())) {
           return send(o,FL_MOVE);
@@ -203,8 +269,8 @@ int Fl_Group::handle(int event) {
 
   case FL_DND_ENTER:
   case FL_DND_DRAG:
-    for (i = children(); i--;) {
-      o = a[i];
+    for (i = nb; i--;) {
+      o = b[i];
       if (o->takesevents() && Fl::event_inside(o)) {
         if (o->contains(Fl::belowmouse())) {
           return send(o,FL_DND_DRAG);
@@ -218,8 +284,8 @@ int Fl_Group::handle(int event) {
     return 0;
 
   case FL_PUSH:
-    for (i = children(); i--;) {
-      o = a[i];
+    for (i = nb; i--;) {
+      o = b[i];
       if (o->takesevents() && Fl::event_inside(o)) {
         Fl_Widget_Tracker wp(o);
         if (send(o,FL_PUSH)) {
@@ -236,8 +302,8 @@ int Fl_Group::handle(int event) {
     if (o == this) return 0;
     else if (o) send(o,event);
     else {
-      for (i = children(); i--;) {
-        o = a[i];
+      for (i = nb; i--;) {
+        o = b[i];
         if (o->takesevents() && Fl::event_inside(o)) {
           if (send(o,event)) return 1;
         }
@@ -246,8 +312,8 @@ int Fl_Group::handle(int event) {
     return 0;
 
   case FL_MOUSEWHEEL:
-    for (i = children(); i--;) {
-      o = a[i];
+    for (i = nb; i--;) {
+      o = b[i];
       if (o->takesevents() && Fl::event_inside(o) && send(o,FL_MOUSEWHEEL))
         return 1;
     }
@@ -361,11 +427,11 @@ Fl_Group::Fl_Group(int X,int Y,int W,int H,const char *l)
 : Fl_Widget(X,Y,W,H,l) {
   align(FL_ALIGN_TOP);
   children_ = 0;
+  num_indexed_ = 0;
   array_ = 0;
   savedfocus_ = 0;
   resizable_ = this;
-  bounds_ = 0; // this is allocated when first resize() is done
-  sizes_ = 0; // see bounds_ (FLTK 1.3 compatibility)
+  layout_ = 0; // this is allocated when first resize() is done
 
   // Subclasses may want to construct child objects as part of their
   // constructor, so make sure they are add()'d to this object.
@@ -412,9 +478,14 @@ void Fl_Group::clear() {
       a[i] = a[j];
       a[j] = temp;
     }
+    num_indexed_ = 0;
   }
 #endif // REVERSE_CHILDREN
 
+  // The children don't need to reset the focus etc. when they are
+  // deleted unless one of these widgets is inside them, see fl_throw_focus()
+  fl_quick_throw_focus++;
+
   while (children_) {                   // delete all children
     int idx = children_-1;              // last child's index
     Fl_Widget* w = child(idx);          // last child widget
@@ -431,6 +502,9 @@ void Fl_Group::clear() {
     }
   }
 
+  fl_quick_throw_focus--;
+  if (layout_ && layout_->spatial_index) layout_->spatial_index->invalidate();
+
   if (pushed != this) Fl::pushed(pushed); // reset pushed() widget
 
 }
@@ -453,6 +527,9 @@ Fl_Group::~Fl_Group() {
   if (current_ == this)
     end();
   clear();
+  init_sizes();
+  if (layout_) delete layout_->spatial_index;
+  delete layout_;
 }
 
 /**
@@ -471,7 +548,10 @@ void Fl_Group::insert(Fl_Widget &o, int index) {
     }
     g->remove(n);
   }
+  if (index > children_) index = children_;
   o.parent_ = this;
+  o.index_ = index; // the children after it may have to be renumbered
+  if (index <= num_indexed_) num_indexed_ = index + 1;
   if (children_ == 0) { // use array pointer to point at single child
     child1_ = &o;
   } else if (children_ == 1) { // go from 1 to 2 children
@@ -483,8 +563,9 @@ void Fl_Group::insert(Fl_Widget &o, int index) {
     if (!(children_ & (children_-1))) // double number of children
       array_ = (Fl_Widget**)realloc((void*)array_,
                                     2*children_*sizeof(Fl_Widget*));
-    int j; for (j = children_; j > index; j--) array_[j] = array_[j-1];
-    array_[j] = &o;
+    memmove(array_ + index + 1, array_ + index,
+            (children_ - index) * sizeof(Fl_Widget*));
+    array_[index] = &o;
   }
   children_++;
   init_sizes();
@@ -517,12 +598,14 @@ void Fl_Group::remove(int index) {
   // remove the widget from the group
 
   children_--;
+  if (index < num_indexed_) num_indexed_ = index;
   if (children_ == 1) { // go from 2 to 1 child
     Fl_Widget *t = array_[!index];
     free((void*)array_);
     child1_ = t;
   } else if (children_ > 1) { // delete from array
-    for (; index < children_; index++) array_[index] = array_[index+1];
+    memmove(array_ + index, array_ + index + 1,
+            (children_ - index) * sizeof(Fl_Widget*));
   }
   init_sizes();
 }
@@ -535,10 +618,9 @@ void Fl_Group::remove(int index) {
   This method differs from the clear() method in that it only affects
   a single widget and does not delete it from memory.
 
-  \note If you have the child's index anyway, use remove(int index)
-  instead, because this doesn't need a child lookup in the group's
-  table of children. This can be much faster, if there are lots of
-  children.
+  \note The child lookup with find() takes constant time in most cases,
+  but removing a child moves all children after it in the group's table
+  of children. Removing the last child is fastest.
 */
 void Fl_Group::remove(Fl_Widget &o) {
   if (!children_) return;
@@ -611,10 +693,28 @@ int Fl_Group::delete_child(int index) {
   \see sizes() (deprecated)
 */
 void Fl_Group::init_sizes() {
-  delete[] bounds_;
-  bounds_ = 0;
-  delete[] sizes_;      // FLTK 1.3 compatibility
-  sizes_ = 0;           // FLTK 1.3 compatibility
+  if (!layout_) return;
+  delete[] layout_->bounds;
+  layout_->bounds = 0;
+  delete[] layout_->sizes;      // FLTK 1.3 compatibility
+  layout_->sizes = 0;           // FLTK 1.3 compatibility
+  if (layout_->spatial_index) {
+    layout_->spatial_index->invalidate();
+  } else {
+    delete layout_;
+    layout_ = 0;
+  }
+}
+
+// Returns the layout data, allocating it if needed.
+Fl_Group::Layout *Fl_Group::layout() {
+  if (!layout_) {
+    layout_ = new Layout;
+    layout_->bounds = 0;
+    layout_->sizes = 0;
+    layout_->spatial_index = 0;
+  }
+  return layout_;
 }
 
 /**
@@ -660,8 +760,8 @@ void Fl_Group::init_sizes() {
       lots of unnecessary dependencies on Fl_Rect.H.
 */
 Fl_Rect* Fl_Group::bounds() {
-  if (!bounds_) {
-    Fl_Rect* p = bounds_ = new Fl_Rect[children_+2];
+  if (!layout()->bounds) {
+    Fl_Rect* p = layout_->bounds = new Fl_Rect[children_+2];
     // first thing in bounds array is the group's size:
     if (as_window())
       p[0] = Fl_Rect(w(),h()); // x = y = 0
@@ -688,7 +788,7 @@ Fl_Rect* Fl_Group::bounds() {
       *p++ = Fl_Rect(*a++);
     }
   }
-  return bounds_;
+  return layout_->bounds;
 }
 
 /** Returns the internal array of widget sizes and positions.
@@ -719,17 +819,17 @@ Fl_Rect* Fl_Group::bounds() {
 */
 int* Fl_Group::sizes()
 {
-  if (sizes_) return sizes_;
-  // allocate new sizes_ array and copy bounds_ over to sizes_
-  int* pi = sizes_ = new int[4*(children_+2)];
+  if (layout()->sizes) return layout_->sizes;
+  // allocate new sizes array and copy bounds over to sizes
   Fl_Rect *rb = bounds();
+  int* pi = layout_->sizes = new int[4*(children_+2)];
   for (int i = 0; i < children_+2; i++, rb++) {
     *pi++ = rb->x();
     *pi++ = rb->r();
     *pi++ = rb->y();
     *pi++ = rb->b();
   }
-  return sizes_;
+  return layout_->sizes;
 }
 
 /**
@@ -739,6 +839,9 @@ int* Fl_Group::sizes()
   all its children according to the rules documented for
   Fl_Group::resizable(Fl_Widget*)
 
+  Children whose position and size would not change are skipped, i.e.
+  their resize() method is not called.
+
   \sa Fl_Group::resizable(Fl_Widget*)
   \sa Fl_Group::resizable()
   \sa Fl_Widget::resize(int,int,int,int)
@@ -753,10 +856,16 @@ void Fl_Group::resize(int X, int Y, int W, int H) {
   Fl_Rect* p = bounds(); // save initial sizes and positions
 
   Fl_Widget::resize(X, Y, W, H); // make new xywh values visible for children
+  if (layout_->spatial_index) layout_->spatial_index->invalidate();
+
+  // Children whose position and size don't change are not resized, so
+  // that subtrees that keep their layout are not traversed. When the
+  // screen is rescaled all children must be resized anyway.
+  int rescale = Fl_Window::is_a_rescale();
 
-  if ((!resizable() || (dw==0 && dh==0 )) && !Fl_Window::is_a_rescale()) {
+  if ((!resizable() || (dw==0 && dh==0 )) && !rescale) {
 
-    if (!as_window()) {
+    if (!as_window() && (dx || dy)) {
       Fl_Widget*const* a = array();
       for (int i=children_; i--;) {
         Fl_Widget* o = *a++;
@@ -825,7 +934,9 @@ void Fl_Group::resize(int X, int Y, int W, int H) {
 
 #endif // old / new (1.4.0++) widget resizing code
 
-      o->resize(L+dx, T+dy, R-L, B-T);
+      if (rescale || o->x() != L+dx || o->y() != T+dy ||
+          o->w() != R-L || o->h() != B-T)
+        o->resize(L+dx, T+dy, R-L, B-T);
     }
   }
 }
@@ -847,19 +958,80 @@ void Fl_Group::draw_children() {
                  h() - Fl::box_dh(box()));
   }
 
+  const int *list; // the children that may be visible, see spatial_index(int)
+  int n = children_in_clip(list);
+
   if (damage() & ~FL_DAMAGE_CHILD) { // redraw the entire thing:
-    for (int i=children_; i--;) {
-      Fl_Widget& o = **a++;
-      draw_child(o);
-      draw_outside_label(o);
+    if (n >= 0) {
+      for (int i=0; i<n; i++) {
+        Fl_Widget& o = *a[list[i]];
+        draw_child(o);
+        draw_outside_label(o);
+      }
+    } else {
+      for (int i=children_; i--;) {
+        Fl_Widget& o = **a++;
+        draw_child(o);
+        draw_outside_label(o);
+      }
     }
   } else {      // only redraw the children that need it:
-    for (int i=children_; i--;) update_child(**a++);
+    if (n >= 0) {
+      for (int i=0; i<n; i++) update_child(*a[list[i]]);
+    } else {
+      for (int i=children_; i--;) update_child(**a++);
+    }
   }
 
   if (clip_children()) fl_pop_clip();
 }
 
+/*
+  Returns the children that may be visible in the current clip region in
+  list, in child order, or -1 if all children must be drawn.
+*/
+int Fl_Group::children_in_clip(const int*& list) {
+  if (!layout_ || !layout_->spatial_index) return -1;
+  // clipping to the window is known only when drawing to the display
+  if (Fl_Surface_Device::surface() != Fl_Display_Device::display_device()) return -1;
+  Fl_Window *win = as_window() ? as_window() : window();
+  if (!win) return -1;
+  int X, Y, W, H;
+  fl_clip_box(0, 0, win->w(), win->h(), X, Y, W, H);
+  return layout_->spatial_index->find(this, X, Y, W, H, list);
+}
+
+/**
+  Enables or disables a spatial index of the children.
+
+  By default handle() tests all children to find the widget under the
+  mouse, and draw_children() tests all children against the clip region.
+  This costs time proportional to the number of children for every mouse
+  event and every redraw, which can be noticeable for groups with
+  thousands of children.
+
+  With a spatial index, the children are sorted into the cells of a grid,
+  so that only the children near the mouse or in the clip region are
+  tested. The index is updated when children are added, removed or
+  resized, and when the group is resized. Call init_sizes() if you move
+  children in other ways, for instance by setting their position in a
+  derived class.
+
+  Children that draw their label outside of their bounds are drawn
+  whenever the group draws its children, because the label extents are
+  not known to the index.
+
+  \param[in] on 1 to create the index, 0 to delete it
+  \version 1.4.0
+*/
+void Fl_Group::spatial_index(int on) {
+  if (on && !spatial_index()) layout()->spatial_index = new Fl_Spatial_Index;
+  else if (!on && spatial_index()) {
+    delete layout_->spatial_index;
+    layout_->spatial_index = 0;
+  }
+}
+
 void Fl_Group::draw() {
   if (damage() & ~FL_DAMAGE_CHILD) { // redraw the entire thing:
     draw_box();
@@ -0,0 +1,301 @@
+//
+// Headless display driver access for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <config.h>
+#include <FL/Fl_Headless.H>
+#include <FL/Fl.H>
+#include <FL/Fl_Window.H>
+#include <FL/fl_utf8.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#if USE_HEADLESS
+
+#include "Fl_Timeout.h"
+#include "Fl_Window_Driver.H"
+#include "drivers/Headless/Fl_Headless_Screen_Driver.H"
+#include "drivers/Headless/Fl_Headless_System_Driver.H"
+#include "drivers/Headless/Fl_Headless_Window_Driver.H"
+#include "drivers/Headless/Fl_Headless_Graphics_Driver.H"
+
+extern Fl_Window *fl_xmousewin; // in Fl.cxx
+
+static int buttons;             // FL_BUTTON1 ... FL_BUTTON3 of pressed buttons
+static int push_x, push_y;      // where the last button was pressed
+static double push_time;        // and when
+
+/** Returns 1 if FLTK uses the headless display driver. */
+int Fl_Headless::available() {
+  return 1;
+}
+
+/**
+  Sets the size of the emulated screen.
+  The default size is 1024 x 768 pixels. Call this before showing windows.
+*/
+void Fl_Headless::screen_size(int W, int H) {
+  Fl_Headless_Screen_Driver::screen_w = W;
+  Fl_Headless_Screen_Driver::screen_h = H;
+}
+
+/**
+  Returns the framebuffer of a shown window.
+
+  Pixels are stored row by row as 0xAARRGGBB values. Subwindows draw into
+  the framebuffer of their top-level window, so for a subwindow the
+  framebuffer of its top-level window is returned.
+  \param[in] win a shown window
+  \param[out] W, H size of the framebuffer
+  \return the pixels or NULL if the window is not shown
+*/
+const unsigned *Fl_Headless::framebuffer(const Fl_Window *win, int &W, int &H) {
+  Fl_Headless_Buffer *b = win ?
+    ((Fl_Headless_Window_Driver*)Fl_Window_Driver::driver(win))->buffer() : 0;
+  if (!b) {
+    W = H = 0;
+    return 0;
+  }
+  W = b->w;
+  H = b->h;
+  return b->pixels;
+}
+
+/**
+  Writes the framebuffer of a window to a binary PPM file.
+  \return 0 on success, -1 on error
+*/
+int Fl_Headless::write_ppm(const Fl_Window *win, const char *filename) {
+  int W, H;
+  const unsigned *p = framebuffer(win, W, H);
+  if (!p) return -1;
+  FILE *f = fl_fopen(filename, "wb");
+  if (!f) return -1;
+  fprintf(f, "P6\n%d %d\n255\n", W, H);
+  for (int i = 0; i < W * H; i++) {
+    unsigned c = p[i];
+    putc((c >> 16) & 0xff, f);
+    putc((c >> 8) & 0xff, f);
+    putc(c & 0xff, f);
+  }
+  return fclose(f) ? -1 : 0;
+}
+
+/**
+  Returns how often a window was drawn.
+  The count includes partial redraws after damage() and is kept while the
+  window is hidden and shown again.
+*/
+unsigned long Fl_Headless::frames(const Fl_Window *win) {
+  return ((Fl_Headless_Window_Driver*)Fl_Window_Driver::driver(win))->frames();
+}
+
+/**
+  Enables or disables virtual time.
+
+  With virtual time Fl::wait() doesn't sleep until the next timeout is due,
+  but advances the clock used for timeouts to its deadline and returns.
+  Animations and other timeouts then run as fast as possible, and their
+  timing no longer depends on the speed of the machine.
+  Enable virtual time before adding timeouts.
+*/
+void Fl_Headless::virtual_time(int on) {
+  if (on && !Fl_Headless_Screen_Driver::virtual_time)
+    Fl_Headless_Screen_Driver::virtual_clock = Fl_Timeout::now();
+  Fl_Headless_Screen_Driver::virtual_time = on ? 1 : 0;
+}
+
+/** Returns 1 if virtual time is enabled. */
+int Fl_Headless::virtual_time() {
+  return Fl_Headless_Screen_Driver::virtual_time;
+}
+
+/** Returns the current time in seconds of the clock used for timeouts. */
+double Fl_Headless::time() {
+  return Fl_Headless_Screen_Driver::now();
+}
+
+/**
+  Advances the virtual clock.
+  Timeouts that expire are called by the next Fl::wait().
+  Does nothing if virtual time is not enabled.
+*/
+void Fl_Headless::advance(double seconds) {
+  if (Fl_Headless_Screen_Driver::virtual_time && seconds > 0)
+    Fl_Headless_Screen_Driver::virtual_clock += seconds;
+}
+
+// Sends a mouse event to the window at window coordinates x, y.
+static int send_mouse(Fl_Window *win, int event, int x, int y) {
+  Fl::e_x = x;
+  Fl::e_y = y;
+  Fl::e_x_root = win->x() + x;
+  Fl::e_y_root = win->y() + y;
+  Fl::e_state = (Fl::e_state & ~FL_BUTTONS) | buttons;
+  Fl_Headless_Screen_Driver::mouse_x = Fl::e_x_root;
+  Fl_Headless_Screen_Driver::mouse_y = Fl::e_y_root;
+  if (fl_xmousewin != win) Fl::handle(FL_ENTER, win);
+  return Fl::handle(event, win);
+}
+
+/**
+  Moves the mouse to x, y in the window.
+  Sends FL_DRAG instead of FL_MOVE if a mouse button is pressed.
+  \return the return value of Fl::handle()
+*/
+int Fl_Headless::move(Fl_Window *win, int x, int y) {
+  if (Fl::e_is_click && (abs(x - push_x) > 5 || abs(y - push_y) > 5))
+    Fl::e_is_click = 0;
+  return send_mouse(win, FL_MOVE, x, y);
+}
+
+/**
+  Presses a mouse button at x, y in the window.
+  Repeated presses of the same button within half a second increment
+  Fl::event_clicks().
+  \return the return value of Fl::handle()
+*/
+int Fl_Headless::push(Fl_Window *win, int x, int y, int button) {
+  if (button < 1 || button > 3) return 0;
+  double t = Fl_Headless_Screen_Driver::now();
+  Fl::e_keysym = FL_Button + button;
+  if (Fl::e_is_click == Fl::e_keysym && t - push_time < 0.5 &&
+      abs(x - push_x) <= 5 && abs(y - push_y) <= 5) {
+    Fl::e_clicks++;
+  } else {
+    Fl::e_clicks = 0;
+    Fl::e_is_click = Fl::e_keysym;
+  }
+  push_x = x; push_y = y; push_time = t;
+  buttons |= FL_BUTTON(button);
+  return send_mouse(win, FL_PUSH, x, y);
+}
+
+/**
+  Releases a mouse button at x, y in the window.
+  \return the return value of Fl::handle()
+*/
+int Fl_Headless::release(Fl_Window *win, int x, int y, int button) {
+  if (button < 1 || button > 3) return 0;
+  Fl::e_keysym = FL_Button + button;
+  buttons &= ~FL_BUTTON(button);
+  return send_mouse(win, FL_RELEASE, x, y);
+}
+
+/**
+  Moves the mouse to x, y in the window and clicks a mouse button.
+  \return the return value of Fl::handle() for the FL_PUSH event
+*/
+int Fl_Headless::click(Fl_Window *win, int x, int y, int button) {
+  move(win, x, y);
+  int ret = push(win, x, y, button);
+  release(win, x, y, button);
+  return ret;
+}
+
+/**
+  Turns the mouse wheel at the current mouse position.
+  \return the return value of Fl::handle()
+*/
+int Fl_Headless::mousewheel(Fl_Window *win, int dx, int dy) {
+  Fl::e_dx = dx;
+  Fl::e_dy = dy;
+  return send_mouse(win, FL_MOUSEWHEEL, Fl::e_x, Fl::e_y);
+}
+
+/**
+  Presses and releases a key.
+
+  Sends FL_KEYBOARD and FL_KEYUP to the window. While FL_KEYBOARD is
+  handled, Fl::event_key(keysym) returns true.
+  \param[in] win the window that has the keyboard focus
+  \param[in] keysym the FLTK key code, e.g. 'a' or FL_Enter
+  \param[in] text the UTF-8 text of the key, by default the ASCII
+    character of keysym for printable keys, and empty otherwise
+  \param[in] state modifiers like FL_SHIFT or FL_CTRL
+  \return the return value of Fl::handle() for the FL_KEYBOARD event
+*/
+int Fl_Headless::key(Fl_Window *win, int keysym, const char *text, int state) {
+  static char buffer[32];
+  if (text) {
+    strncpy(buffer, text, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = 0;
+  } else {
+    buffer[0] = (keysym >= ' ' && keysym < 0x7f) ? (char)keysym : 0;
+    buffer[1] = 0;
+  }
+  Fl::e_keysym = Fl::e_original_keysym = keysym;
+  Fl::e_text = buffer;
+  Fl::e_length = (int)strlen(buffer);
+  Fl::e_state = (Fl::e_state & FL_BUTTONS) | state;
+  Fl_Headless_System_Driver::key_state(keysym, 1);
+  int ret = Fl::handle(FL_KEYBOARD, win);
+  Fl_Headless_System_Driver::key_state(keysym, 0);
+  Fl::e_keysym = Fl::e_original_keysym = keysym;
+  Fl::handle(FL_KEYUP, win);
+  return ret;
+}
+
+/**
+  Types UTF-8 text, one key() per character.
+  Uppercase ASCII letters are typed with FL_SHIFT, and the characters
+  '\\n', '\\t' and '\\b' are typed as FL_Enter, FL_Tab and FL_BackSpace.
+  \return the number of characters that were handled
+*/
+int Fl_Headless::type(Fl_Window *win, const char *text) {
+  int handled = 0;
+  const char *end = text + strlen(text);
+  while (text < end) {
+    int len;
+    unsigned ucs = fl_utf8decode(text, end, &len);
+    char c[8];
+    memcpy(c, text, len);
+    c[len] = 0;
+    int keysym = (int)ucs, state = 0;
+    if (ucs == '\n') { keysym = FL_Enter; strcpy(c, "\r"); }
+    else if (ucs == '\t') keysym = FL_Tab;
+    else if (ucs == '\b') keysym = FL_BackSpace;
+    else if (ucs < 0x80 && isupper(ucs)) { keysym = tolower(ucs); state = FL_SHIFT; }
+    if (key(win, keysym, c, state)) handled++;
+    text += len;
+  }
+  return handled;
+}
+
+#else // !USE_HEADLESS
+
+int Fl_Headless::available() { return 0; }
+void Fl_Headless::screen_size(int W, int H) {}
+const unsigned *Fl_Headless::framebuffer(const Fl_Window *win, int &W, int &H) {
+  W = H = 0;
+  return 0;
+}
+int Fl_Headless::write_ppm(const Fl_Window *win, const char *filename) { return -1; }
+unsigned long Fl_Headless::frames(const Fl_Window *win) { return 0; }
+void Fl_Headless::virtual_time(int on) {}
+int Fl_Headless::virtual_time() { return 0; }
+double Fl_Headless::time() { return 0.0; }
+void Fl_Headless::advance(double seconds) {}
+int Fl_Headless::move(Fl_Window *win, int x, int y) { return 0; }
+int Fl_Headless::push(Fl_Window *win, int x, int y, int button) { return 0; }
+int Fl_Headless::release(Fl_Window *win, int x, int y, int button) { return 0; }
+int Fl_Headless::click(Fl_Window *win, int x, int y, int button) { return 0; }
+int Fl_Headless::mousewheel(Fl_Window *win, int dx, int dy) { return 0; }
+int Fl_Headless::key(Fl_Window *win, int keysym, const char *text, int state) { return 0; }
+int Fl_Headless::type(Fl_Window *win, const char *text) { return 0; }
+
+#endif // USE_HEADLESS
@@ -275,10 +275,10 @@ int Fl_Input::kf_undo() {
   return undo();
 }
 
-// Redo. (currently unimplemented.. toggles undo() instead)
+// Redo.
 int Fl_Input::kf_redo() {
   if (readonly()) { fl_beep(); return 1; }
-  return kf_undo();                     // currently we don't support multilevel undo
+  return redo();
 }
 
 // Do a copy operation
@@ -23,6 +23,7 @@
 #include <math.h>
 #include <FL/fl_utf8.h>
 #include "flstring.h"
+#include "Fl_Undo_Journal.h"
 #include <stdlib.h>
 #include <ctype.h>
 
@@ -721,26 +722,6 @@ int Fl_Input_::copy(int clipboard) {
 
 #define MAXFLOATSIZE 40
 
-static char* undobuffer;
-static int undobufferlength;
-static Fl_Input_* undowidget;
-static int undoat;      // points after insertion
-static int undocut;     // number of characters deleted there
-static int undoinsert;  // number of characters inserted
-static int yankcut;     // length of valid contents of buffer, even if undocut=0
-
-static void undobuffersize(int n) {
-  if (n > undobufferlength) {
-    if (undobuffer) {
-      do {undobufferlength *= 2;} while (undobufferlength < n);
-      undobuffer = (char*)realloc(undobuffer, undobufferlength);
-    } else {
-      undobufferlength = n+9;
-      undobuffer = (char*)malloc(undobufferlength);
-    }
-  }
-}
-
 /**
  Append text at the end.
 
@@ -856,47 +837,24 @@ int Fl_Input_::replace(int b, int e, const char* text, int ilen) {
   ilen = nlen;
 
   put_in_buffer(size_+ilen);
+  if (!undo_) undo_ = new Fl_Undo_Journal;
 
   if (e>b) {
-    if (undowidget == this && b == undoat) {
-      undobuffersize(undocut+(e-b));
-      memcpy(undobuffer+undocut, value_+b, e-b);
-      undocut += e-b;
-    } else if (undowidget == this && e == undoat && !undoinsert) {
-      undobuffersize(undocut+(e-b));
-      memmove(undobuffer+(e-b), undobuffer, undocut);
-      memcpy(undobuffer, value_+b, e-b);
-      undocut += e-b;
-    } else if (undowidget == this && e == undoat && (e-b)<undoinsert) {
-      undoinsert -= e-b;
-    } else {
-      undobuffersize(e-b);
-      memcpy(undobuffer, value_+b, e-b);
-      undocut = e-b;
-      undoinsert = 0;
-    }
+    memcpy(undo_->removed(b, e), value_+b, e-b);
     memmove(buffer+b, buffer+e, size_-e+1);
     size_ -= e-b;
-    undowidget = this;
-    undoat = b;
-    if (input_type() == FL_SECRET_INPUT) yankcut = 0; else yankcut = undocut;
   }
 
   if (ilen) {
-    if (undowidget == this && b == undoat)
-      undoinsert += ilen;
-    else {
-      undocut = 0;
-      undoinsert = ilen;
-    }
     memmove(buffer+b+ilen, buffer+b, size_-b+1);
     memcpy(buffer+b, text, ilen);
     size_ += ilen;
+    undo_->inserted(b, text, ilen);
   }
-  undowidget = this;
   om = mark_;
   op = position_;
-  mark_ = position_ = undoat = b+ilen;
+  int cursor = b+ilen;
+  mark_ = position_ = cursor;
 
   // Insertions into the word at the end of the line will cause it to
   // wrap to the next line, so we must indicate that the changes may start
@@ -920,7 +878,7 @@ int Fl_Input_::replace(int b, int e, const char* text, int ilen) {
 
   minimal_update(b);
 
-  mark_ = position_ = undoat;
+  mark_ = position_ = cursor;
 
   set_changed();
   if (when()&FL_WHEN_CHANGED) do_callback();
@@ -930,40 +888,69 @@ int Fl_Input_::replace(int b, int e, const char* text, int ilen) {
 /**
   Undoes previous changes to the text buffer.
 
-  This call undoes a number of previous calls to replace().
+  This call undoes the last call to replace() that was not undone yet,
+  and can be repeated to undo earlier calls. Adjacent insertions and
+  deletions, e.g. typing, are undone together up to the end of a line.
 
   \return non-zero if any change was made.
+  \see redo(), can_undo()
 */
 int Fl_Input_::undo() {
   was_up_down = 0;
-  if ( undowidget != this || (!undocut && !undoinsert) ) return 0;
+  return undo_step(0);
+}
 
-  int ilen = undocut;
-  int xlen = undoinsert;
-  int b = undoat-xlen;
-  int b1 = b;
+/**
+  Redoes the last changes that were undone.
 
-  put_in_buffer(size_+ilen);
+  This call redoes the changes of the last call to undo(). Any other
+  change of the text forgets the changes that could be redone.
 
-  if (ilen) {
-    memmove(buffer+b+ilen, buffer+b, size_-b+1);
-    memcpy(buffer+b, undobuffer, ilen);
-    size_ += ilen;
-    b += ilen;
-  }
+  \return non-zero if any change was made.
+  \see undo(), can_redo()
+*/
+int Fl_Input_::redo() {
+  was_up_down = 0;
+  return undo_step(1);
+}
 
-  if (xlen) {
-    undobuffersize(xlen);
-    memcpy(undobuffer, buffer+b, xlen);
-    memmove(buffer+b, buffer+b+xlen, size_-xlen-b+1);
-    size_ -= xlen;
-  }
+/**
+  Checks if there are changes that undo() can undo.
+  \return non-zero if undo() would change the text
+*/
+int Fl_Input_::can_undo() const {
+  return undo_ && undo_->can_undo();
+}
+
+/**
+  Checks if there are changes that redo() can redo.
+  \return non-zero if redo() would change the text
+*/
+int Fl_Input_::can_redo() const {
+  return undo_ && undo_->can_redo();
+}
+
+/** \internal
+  Replaces the text of the next change in the undo journal, after saving
+  the text that is replaced in the journal.
+*/
+int Fl_Input_::undo_step(int redo) {
+  Fl_Undo_Journal::Step s;
+  if (!undo_ || !undo_->start(redo, s)) return 0;
+
+  int b = s.pos;
+  int b1 = b;
+
+  put_in_buffer(size_+s.insert_len);
+
+  memcpy(undo_->removed(b, b+s.remove), buffer+b, s.remove);
+  memmove(buffer+b+s.insert_len, buffer+b+s.remove, size_-b-s.remove+1);
+  memcpy(buffer+b, s.insert, s.insert_len);
+  size_ += s.insert_len-s.remove;
+  undo_->finish();
 
-  undocut = xlen;
-  if (xlen) yankcut = xlen;
-  undoinsert = ilen;
-  undoat = b;
-  mark_ = b /* -ilen */;
+  b += s.insert_len;
+  mark_ = b;
   position_ = b;
 
   if (wrap())
@@ -986,8 +973,11 @@ int Fl_Input_::undo() {
 */
 int Fl_Input_::copy_cuts() {
   // put the yank buffer into the X clipboard
-  if (!yankcut || input_type()==FL_SECRET_INPUT) return 0;
-  Fl::copy(undobuffer, yankcut, 1);
+  if (!undo_ || input_type()==FL_SECRET_INPUT) return 0;
+  int len;
+  const char *cut = undo_->last_cut(len);
+  if (!len) return 0;
+  Fl::copy(cut, len, 1);
   return 1;
 }
 
@@ -1142,6 +1132,7 @@ Fl_Input_::Fl_Input_(int X, int Y, int W, int H, const char* l)
   textfont_ = FL_HELVETICA;
   textcolor_ = FL_FOREGROUND_COLOR;
   cursor_color_ = FL_FOREGROUND_COLOR; // was FL_BLUE
+  undo_ = 0;
   mark_ = position_ = size_ = 0;
   bufsize = 0;
   buffer  = 0;
@@ -1215,7 +1206,7 @@ void Fl_Input_::put_in_buffer(int len) {
 */
 int Fl_Input_::static_value(const char* str, int len) {
   clear_changed();
-  if (undowidget == this) undowidget = 0;
+  if (undo_) undo_->clear();
   if (str == value_ && len == size_) return 0;
   if (len) { // non-empty new value:
     if (xscroll_ || yscroll_) {
@@ -1316,7 +1307,7 @@ void Fl_Input_::resize(int X, int Y, int W, int H) {
   from the parent Fl_Group.
 */
 Fl_Input_::~Fl_Input_() {
-  if (undowidget == this) undowidget = 0;
+  delete undo_;
   if (bufsize) free((void*)buffer);
 }
 
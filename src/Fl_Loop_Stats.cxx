@@ -0,0 +1,346 @@
+//
+// Event loop statistics for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <config.h>
+#include <FL/Fl_Loop_Stats.H>
+#include <FL/platform_types.h>
+#include "Fl_Timeout.h"
+#include <stdlib.h>
+
+static const char *phase_names[Fl_Loop_Stats::PHASES] = {
+  "event", "fd", "timeout", "check", "idle", "awake", "flush", "wait"
+};
+
+#if USE_EVENT_LOOP_STATS
+
+// Bucket 0 counts durations below 1 µs, bucket i (i > 0) durations
+// from 2^(i-1) µs up to 2^i µs. The last bucket counts everything else.
+
+struct Phase_Stats {
+  unsigned long count;
+  double total;
+  double max;
+  unsigned long hist[Fl_Loop_Stats::BUCKETS];
+};
+
+struct Callback_Stats {
+  int phase;
+  void *func;
+  unsigned long count;
+  double total;
+  double max;
+};
+
+static int stats_enabled = 1;
+static Phase_Stats phases[Fl_Loop_Stats::PHASES];
+static Callback_Stats *cb_stats = 0;   // open addressing hash table
+static int cb_alloc = 0;               // size of cb_stats (power of 2)
+static int cb_count = 0;               // used entries
+
+static int bucket(double seconds) {
+  double us = seconds * 1000000.0;
+  int b = 0;
+  while (us >= 1.0 && b < Fl_Loop_Stats::BUCKETS - 1) { us /= 2.0; b++; }
+  return b;
+}
+
+static Callback_Stats *find_callback(int phase, void *func) {
+  if (cb_count * 2 >= cb_alloc) { // grow and rehash
+    Callback_Stats *old = cb_stats;
+    int old_alloc = cb_alloc;
+    cb_alloc = cb_alloc ? cb_alloc * 2 : 64;
+    cb_stats = (Callback_Stats *)calloc(cb_alloc, sizeof(Callback_Stats));
+    for (int i = 0; i < old_alloc; i++) {
+      if (!old[i].count) continue;
+      fl_uintptr_t h = ((fl_uintptr_t)old[i].func >> 2) * 31 + old[i].phase;
+      int j = (int)(h & (cb_alloc - 1));
+      while (cb_stats[j].count) j = (j + 1) & (cb_alloc - 1);
+      cb_stats[j] = old[i];
+    }
+    free(old);
+  }
+  fl_uintptr_t h = ((fl_uintptr_t)func >> 2) * 31 + phase;
+  int j = (int)(h & (cb_alloc - 1));
+  while (cb_stats[j].count) {
+    if (cb_stats[j].func == func && cb_stats[j].phase == phase) return cb_stats + j;
+    j = (j + 1) & (cb_alloc - 1);
+  }
+  cb_stats[j].phase = phase;
+  cb_stats[j].func = func;
+  cb_count++;
+  return cb_stats + j;
+}
+
+#endif // USE_EVENT_LOOP_STATS
+
+/**
+  Returns 1 if FLTK was built with event loop statistics, 0 otherwise.
+*/
+int Fl_Loop_Stats::available() {
+  return USE_EVENT_LOOP_STATS;
+}
+
+/**
+  Enables or disables taking measurements (enabled by default).
+  This has no effect if the statistics are not available().
+*/
+void Fl_Loop_Stats::enable(int on) {
+#if USE_EVENT_LOOP_STATS
+  stats_enabled = on;
+#endif
+}
+
+/**
+  Returns 1 if measurements are taken, 0 otherwise.
+*/
+int Fl_Loop_Stats::enabled() {
+#if USE_EVENT_LOOP_STATS
+  return stats_enabled;
+#else
+  return 0;
+#endif
+}
+
+/**
+  Clears all statistics.
+*/
+void Fl_Loop_Stats::reset() {
+#if USE_EVENT_LOOP_STATS
+  for (int i = 0; i < PHASES; i++) {
+    Phase_Stats &p = phases[i];
+    p.count = 0;
+    p.total = p.max = 0.0;
+    for (int b = 0; b < BUCKETS; b++) p.hist[b] = 0;
+  }
+  free(cb_stats);
+  cb_stats = 0;
+  cb_alloc = cb_count = 0;
+#endif
+}
+
+/**
+  Returns a short name of the given phase, for instance "timeout".
+*/
+const char *Fl_Loop_Stats::phase_name(Phase phase) {
+  return (phase >= 0 && phase < PHASES) ? phase_names[phase] : "";
+}
+
+/**
+  Returns the number of measurements of the given phase.
+*/
+unsigned long Fl_Loop_Stats::count(Phase phase) {
+#if USE_EVENT_LOOP_STATS
+  if (phase >= 0 && phase < PHASES) return phases[phase].count;
+#endif
+  return 0;
+}
+
+/**
+  Returns the total time in seconds spent in the given phase.
+*/
+double Fl_Loop_Stats::total(Phase phase) {
+#if USE_EVENT_LOOP_STATS
+  if (phase >= 0 && phase < PHASES) return phases[phase].total;
+#endif
+  return 0.0;
+}
+
+/**
+  Returns the longest single measurement in seconds of the given phase.
+*/
+double Fl_Loop_Stats::max(Phase phase) {
+#if USE_EVENT_LOOP_STATS
+  if (phase >= 0 && phase < PHASES) return phases[phase].max;
+#endif
+  return 0.0;
+}
+
+/**
+  Returns the number of measurements of the given phase in a histogram bucket.
+  Bucket 0 counts durations below 1 µs, bucket \p b counts durations
+  below bucket_limit(b) that are not counted by bucket \p b - 1.
+  \see bucket_limit()
+*/
+unsigned long Fl_Loop_Stats::histogram(Phase phase, int bucket) {
+#if USE_EVENT_LOOP_STATS
+  if (phase >= 0 && phase < PHASES && bucket >= 0 && bucket < BUCKETS)
+    return phases[phase].hist[bucket];
+#endif
+  return 0;
+}
+
+/**
+  Returns the upper limit in seconds of the durations counted by a bucket.
+  The last bucket has no upper limit, 1e20 is returned.
+*/
+double Fl_Loop_Stats::bucket_limit(int bucket) {
+  if (bucket < 0) return 0.0;
+  if (bucket >= BUCKETS - 1) return 1e20;
+  return (double)(1UL << bucket) / 1000000.0;
+}
+
+/**
+  Returns an estimate of the given percentile of the durations of a phase.
+  The result is the upper limit of the histogram bucket that contains the
+  percentile, i.e. \p percent percent of all measurements took at most
+  this time. For instance percentile(TIMEOUT, 99) returns the time in
+  seconds that 99% of all timeout callbacks didn't exceed.
+*/
+double Fl_Loop_Stats::percentile(Phase phase, double percent) {
+#if USE_EVENT_LOOP_STATS
+  if (phase < 0 || phase >= PHASES || !phases[phase].count) return 0.0;
+  double limit = phases[phase].count * percent / 100.0;
+  unsigned long n = 0;
+  for (int b = 0; b < BUCKETS - 1; b++) {
+    n += phases[phase].hist[b];
+    if (n >= limit) {
+      double l = bucket_limit(b);
+      return l < phases[phase].max ? l : phases[phase].max;
+    }
+  }
+  return phases[phase].max;
+#else
+  return 0.0;
+#endif
+}
+
+/**
+  Returns the number of callback functions that have been measured.
+  \see callback()
+*/
+int Fl_Loop_Stats::callbacks() {
+#if USE_EVENT_LOOP_STATS
+  return cb_count;
+#else
+  return 0;
+#endif
+}
+
+/**
+  Gets the statistics of a callback function.
+  Callback functions are counted separately for each phase. For system
+  events and Fl::flush() the function is NULL.
+  \param[in] index  0 ... callbacks() - 1, the order is unspecified
+  \param[out] phase  the phase in which the function was called
+  \param[out] func  the address of the function
+  \param[out] count  the number of calls
+  \param[out] total  the total time in seconds spent in the function
+  \param[out] max  the longest call in seconds
+  \return 1 if \p index is valid, 0 otherwise
+*/
+int Fl_Loop_Stats::callback(int index, Phase &phase, void *&func,
+                            unsigned long &count, double &total, double &max) {
+#if USE_EVENT_LOOP_STATS
+  for (int i = 0; i < cb_alloc; i++) {
+    if (!cb_stats[i].count) continue;
+    if (index-- == 0) {
+      phase = (Phase)cb_stats[i].phase;
+      func = cb_stats[i].func;
+      count = cb_stats[i].count;
+      total = cb_stats[i].total;
+      max = cb_stats[i].max;
+      return 1;
+    }
+  }
+#endif
+  return 0;
+}
+
+/**
+  Writes all statistics in human readable form to a file.
+*/
+void Fl_Loop_Stats::dump(FILE *out) {
+  if (!available()) {
+    fprintf(out, "FLTK event loop statistics are not available.\n");
+    return;
+  }
+  fprintf(out, "%-8s %10s %12s %12s %12s %12s %12s\n",
+          "phase", "count", "total [ms]", "mean [us]", "p50 [us]", "p99 [us]", "max [us]");
+  for (int i = 0; i < PHASES; i++) {
+    Phase p = (Phase)i;
+    unsigned long n = count(p);
+    fprintf(out, "%-8s %10lu %12.3f %12.3f %12.3f %12.3f %12.3f\n", phase_name(p), n,
+            total(p) * 1000.0, n ? total(p) / n * 1000000.0 : 0.0,
+            percentile(p, 50) * 1000000.0, percentile(p, 99) * 1000000.0,
+            max(p) * 1000000.0);
+  }
+  fprintf(out, "\nhistograms (upper bucket limit [us]: count)\n");
+  for (int i = 0; i < PHASES; i++) {
+    Phase p = (Phase)i;
+    if (!count(p)) continue;
+    fprintf(out, "%-8s", phase_name(p));
+    for (int b = 0; b < BUCKETS; b++) {
+      unsigned long h = histogram(p, b);
+      if (!h) continue;
+      if (b < BUCKETS - 1) fprintf(out, " %.0f:%lu", bucket_limit(b) * 1000000.0, h);
+      else fprintf(out, " inf:%lu", h);
+    }
+    fprintf(out, "\n");
+  }
+  fprintf(out, "\ncallbacks\n%-8s %-18s %10s %12s %12s\n",
+          "phase", "function", "count", "total [ms]", "max [us]");
+  Phase phase;
+  void *func;
+  unsigned long n;
+  double tot, mx;
+  for (int i = 0; callback(i, phase, func, n, tot, mx); i++) {
+    if (!func) continue;
+    fprintf(out, "%-8s %-18p %10lu %12.3f %12.3f\n",
+            phase_name(phase), func, n, tot * 1000.0, mx * 1000000.0);
+  }
+}
+
+/**
+  Writes all statistics in human readable form to a file.
+  \return 0 on success, -1 if the file could not be opened
+*/
+int Fl_Loop_Stats::dump(const char *filename) {
+  FILE *out = fopen(filename, "w");
+  if (!out) return -1;
+  dump(out);
+  fclose(out);
+  return 0;
+}
+
+/**
+  Returns the start time of a measurement, or -1 if disabled (internal).
+*/
+double Fl_Loop_Stats::start_() {
+#if USE_EVENT_LOOP_STATS
+  if (stats_enabled) return Fl_Timeout::now();
+#endif
+  return -1.0;
+}
+
+/**
+  Records a measurement started by start_() (internal).
+*/
+void Fl_Loop_Stats::record_(Phase phase, void *func, double start) {
+#if USE_EVENT_LOOP_STATS
+  if (start < 0.0 || phase < 0 || phase >= PHASES) return;
+  double t = Fl_Timeout::now() - start;
+  if (t < 0.0) t = 0.0;
+  Phase_Stats &p = phases[phase];
+  p.count++;
+  p.total += t;
+  if (t > p.max) p.max = t;
+  p.hist[bucket(t)]++;
+  Callback_Stats *c = find_callback(phase, func);
+  c->count++;
+  c->total += t;
+  if (t > c->max) c->max = t;
+#endif
+}
@@ -57,12 +57,8 @@ static const Fl_Text_Display::Style_Table_Entry builtin_stable[] = {
 static const int  builtin_stable_size = sizeof(builtin_stable);
 static const char builtin_normal_index = 17;        // the reset style index used by \033[0m
 
-// Count how many times character 'c' appears in string 's'
-static int strcnt(const char *s, char c) {
-  int count = 0;
-  while ( *s ) { if ( *s++ == c ) ++count; }
-  return count;
-}
+// Time between two batches of streamed text if Fl::max_fps() is not set
+#define PENDING_INTERVAL (1.0/60.0)
 
 // Vertical scrollbar callback intercept
 void Fl_Simple_Terminal::vscroll_cb2(Fl_Widget *w, void*) {
@@ -86,6 +82,12 @@ Fl_Simple_Terminal::Fl_Simple_Terminal(int X,int Y,int W,int H,const char *l) :
   lines = 0;                    // note: lines!=mNBufferLines when lines are wrapping
   scrollaway = false;
   scrolling = false;
+  streaming_ = false;
+  pend_text_ = 0;
+  pend_style_ = 0;
+  pend_len_ = 0;
+  pend_size_ = 0;
+  pend_lines_ = 0;
   // These defaults similar to typical DOS/unix terminals
   textfont(FL_COURIER);
   color(FL_BLACK);
@@ -96,8 +98,10 @@ Fl_Simple_Terminal::Fl_Simple_Terminal(int X,int Y,int W,int H,const char *l) :
   cursor_style(Fl_Text_Display::BLOCK_CURSOR);
   // Setup text buffer
   buf = new Fl_Text_Buffer();
+  buf->canUndo(0);              // nothing to undo, don't keep the trimmed lines
   buffer(buf);
   sbuf = new Fl_Text_Buffer();  // allocate whether we use it or not
+  sbuf->canUndo(0);
   // XXX: We use WRAP_AT_BOUNDS to prevent the hscrollbar from /always/
   //      being present, an annoying UI bug in Fl_Text_Display.
   wrap_mode(Fl_Text_Display::WRAP_AT_BOUNDS, 0);
@@ -117,9 +121,12 @@ Fl_Simple_Terminal::Fl_Simple_Terminal(int X,int Y,int W,int H,const char *l) :
  for the terminal, including text buffer, style buffer, etc.
 */
 Fl_Simple_Terminal::~Fl_Simple_Terminal() {
+  Fl::remove_timeout(pending_cb, (void*)this);
   buffer(0);    // disassociate buffer /before/ we delete it
   if ( buf  ) { delete buf;  buf  = 0; }
   if ( sbuf ) { delete sbuf; sbuf = 0; }
+  free(pend_text_);
+  free(pend_style_);
 }
 
 /**
@@ -183,6 +190,7 @@ int Fl_Simple_Terminal::history_lines() const {
 */
 void Fl_Simple_Terminal::history_lines(int maxlines) {
   history_lines_ = maxlines;
+  flush_pending();
   enforce_history_lines();
 }
 
@@ -365,6 +373,49 @@ int Fl_Simple_Terminal::current_style_index() const {
   return current_style_index_;
 }
 
+/**
+ Get the state of the streaming flag.
+
+ \see streaming(bool)
+*/
+bool Fl_Simple_Terminal::streaming() const {
+  return streaming_;
+}
+
+/**
+ Enable/disable the streaming mode for high-volume output, such as the
+ log of a busy process that appends thousands of lines per second.
+
+ In streaming mode, append(), printf() and vprintf() only parse the new
+ text and collect it. The collected text is added to the terminal once
+ per frame, i.e. every 1/Fl::max_fps() seconds, or every 1/60 second if
+ no frame rate was set. So the display is updated and redrawn only once
+ for all the lines appended in between, and lines that history_lines()
+ would trim right away are never added at all. text() includes the
+ collected text, history_lines(int) adds it first, and flush_pending()
+ adds it immediately. Drawing the widget doesn't add it, so the buffers
+ are never changed while the widget is drawn.
+
+ The text and the styles are kept in the Fl_Text_Buffer::PIECE_TABLE
+ storage in streaming mode. Like in a ring buffer, trimming the oldest
+ lines of the history doesn't move the remaining text, and the memory of
+ the trimmed lines is released once more than half of the stored text was
+ trimmed.
+
+ The default is 'false'.
+
+ \see flush_pending(), history_lines(int)
+*/
+void Fl_Simple_Terminal::streaming(bool val) {
+  if ( streaming_ == val ) return; // no change
+  flush_pending();
+  streaming_ = val;
+  Fl_Text_Buffer::Storage storage = val ? Fl_Text_Buffer::PIECE_TABLE
+                                        : Fl_Text_Buffer::GAP_BUFFER;
+  buf->storage(storage);
+  sbuf->storage(storage);
+}
+
 /**
  Set a user defined style table, which controls the font colors,
  faces, weights and sizes available for the terminal's text content.
@@ -491,10 +542,54 @@ void Fl_Simple_Terminal::enforce_stay_at_bottom() {
 void Fl_Simple_Terminal::enforce_history_lines() {
   if ( history_lines() > -1 && lines > history_lines() ) {
     int trimlines = lines - history_lines();
-    remove_lines(0, trimlines);                         // remove lines from top
+    int buflines = lines - pend_lines_;                 // pending lines are not in the buffer yet
+    if ( trimlines > buflines ) trimlines = buflines;
+    if ( trimlines > 0 ) remove_lines(0, trimlines);    // remove lines from top
   }
 }
 
+/**
+ Adds the text collected by append() in streaming mode to the terminal.
+
+ This is called automatically once per frame, and by the methods that
+ need all of the text. Call it to show the text right away, e.g. before
+ a long computation. Outside of streaming mode append() adds the text
+ immediately, so there is nothing to do.
+
+ \see streaming(bool)
+*/
+void Fl_Simple_Terminal::flush_pending() {
+  Fl::remove_timeout(pending_cb, (void*)this);
+  if ( pend_len_ == 0 ) return;
+  const char *ntp = pend_text_;
+  const char *nsp = pend_style_;
+  enforce_history_lines();                      // trim the lines already in the buffer
+  if ( history_lines() > -1 && lines > history_lines() ) {
+    // More new lines than the history can hold: drop what is left in the
+    // buffer (no complete line) and the oldest of the new lines
+    int skip = lines - history_lines();
+    buf->text("");
+    sbuf->text("");
+    for ( int i = 0; i < skip; i++ ) {
+      const char *nl = (const char*)memchr(ntp, '\n', pend_len_ - (ntp - pend_text_));
+      ntp = nl + 1;
+    }
+    nsp += ntp - pend_text_;
+    lines -= skip;
+  }
+  buf->append(ntp);             // new text memory
+  if ( ansi() )
+    sbuf->append(nsp);          // new style memory
+  pend_len_ = 0;
+  pend_lines_ = 0;
+  enforce_stay_at_bottom();
+}
+
+// Adds the text collected in streaming mode once per frame
+void Fl_Simple_Terminal::pending_cb(void *data) {
+  ((Fl_Simple_Terminal*)data)->flush_pending();
+}
+
 /**
  Appends new string 's' to terminal.
 
@@ -509,21 +604,27 @@ void Fl_Simple_Terminal::enforce_history_lines() {
  \see printf(), vprintf(), text(), clear()
 */
 void Fl_Simple_Terminal::append(const char *s, int len) {
+  if ( len < 0 ) len = (int)strlen(s);
+  // Make room for the new text (after ansi codes parsed+removed) and its style
+  if ( pend_len_ + len >= pend_size_ ) {
+    int size = pend_size_ ? pend_size_ : 1024;
+    while ( size <= pend_len_ + len ) size *= 2;
+    pend_text_  = (char*)realloc(pend_text_, size);
+    pend_style_ = (char*)realloc(pend_style_, size);
+    pend_size_ = size;
+  }
+  char *ntp = pend_text_ + pend_len_;       // new text
+  char *nsp = pend_style_ + pend_len_;      // new style
+  const char *end = s + len;
+  const char *sp = s;
   // Remove ansi codes and adjust style buffer accordingly.
   if ( ansi() ) {
     int nstyles = stable_size_ / STE_SIZE;
-    if ( len < 0 ) len = (int)strlen(s);
-    // New text buffer (after ansi codes parsed+removed)
-    char *ntm = (char*)malloc(len+1);       // new text memory
-    char *ntp = ntm;
-    char *nsm = (char*)malloc(len+1);       // new style memory
-    char *nsp = nsm;
     // ANSI values
     char astyle = 'A'+current_style_index_; // the running style index
     const char *esc = 0;
-    const char *sp = s;
     // Walk user's string looking for codes, modify new text/style text as needed
-    while ( *sp ) {
+    while ( sp < end && *sp ) {
       if ( *sp == 033 ) {        // "\033.."
         esc = sp++;
         switch (*sp) {
@@ -552,9 +653,9 @@ void Fl_Simple_Terminal::append(const char *s, int len) {
                       // unsupported
                       break;
                     case 2:       // \033[2J -- clear entire screen
-                      clear();    // clear text buffer
-                      ntp = ntm;  // clear text contents accumulated so far
-                      nsp = nsm;  // clear style contents ""
+                      clear();    // clear text buffer and pending text
+                      ntp = pend_text_;   // clear text contents accumulated so far
+                      nsp = pend_style_;  // clear style contents ""
                       break;
                   }
                   ++sp;
@@ -585,27 +686,36 @@ void Fl_Simple_Terminal::append(const char *s, int len) {
         }         // switch
       }           // \033
       else {
-        // Non-ANSI character?
-        if ( *sp == '\n' ) ++lines; // keep track of #lines
-        *ntp++ = *sp++;             // pass char thru
-        *nsp++ = astyle;            // use current style
+        // Non-ANSI characters? Pass them thru up to the next escape
+        const char *run = sp;
+        while ( sp < end && *sp && *sp != 033 ) {
+          if ( *sp == '\n' ) { ++lines; ++pend_lines_; } // keep track of #lines
+          ++sp;
+        }
+        memcpy(ntp, run, sp - run);
+        memset(nsp, astyle, sp - run);      // use current style
+        ntp += sp - run;
+        nsp += sp - run;
       }
     } // while
-    *ntp = 0;
-    *nsp = 0;
-    //::printf("  RESULT: ntm='%s'\n", ntm);
-    //::printf("  RESULT: nsm='%s'\n", nsm);
-    buf->append(ntm);           // new text memory
-    sbuf->append(nsm);          // new style memory
-    free(ntm);
-    free(nsm);
   } else {
     // non-ansi buffer
-    buf->append(s);
-    lines += ::strcnt(s, '\n');  // count total line feeds in string added
+    while ( sp < end && *sp ) {
+      if ( *sp == '\n' ) { ++lines; ++pend_lines_; } // count total line feeds in string added
+      ++sp;
+    }
+    memcpy(ntp, s, sp - s);
+    ntp += sp - s;
+  }
+  pend_len_ = (int)(ntp - pend_text_);
+  pend_text_[pend_len_] = 0;
+  pend_style_[pend_len_] = 0;
+  if ( !streaming_ ) {
+    flush_pending();
+  } else if ( pend_len_ > 0 && !Fl::has_timeout(pending_cb, (void*)this) ) {
+    double fps = Fl::max_fps();
+    Fl::add_timeout(fps > 0.0 ? 1.0/fps : PENDING_INTERVAL, pending_cb, (void*)this);
   }
-  enforce_history_lines();
-  enforce_stay_at_bottom();
 }
 
 /**
@@ -633,10 +743,17 @@ void Fl_Simple_Terminal::text(const char *s, int len) {
  Returns entire text content of the terminal as a single string.
 
  This includes the screen history, as well as the visible
- onscreen content.
+ onscreen content. In streaming mode it also includes the text that
+ was not added to the terminal yet, see flush_pending().
 */
 const char* Fl_Simple_Terminal::text() const {
-  return buf->text();
+  char *t = buf->text();
+  if ( pend_len_ > 0 ) {
+    int len = buf->length();
+    t = (char*)realloc(t, len + pend_len_ + 1);
+    memcpy(t + len, pend_text_, pend_len_ + 1);        // includes the trailing 0
+  }
+  return t;
 }
 
 /**
@@ -687,7 +804,6 @@ void Fl_Simple_Terminal::vprintf(const char *fmt, va_list ap) {
   ::vsnprintf(buffer, 1024, fmt, ap);
   buffer[1024-1] = 0;   // XXX: MICROSOFT
   append(buffer);
-  enforce_history_lines();
 }
 
 /**
@@ -697,27 +813,33 @@ void Fl_Simple_Terminal::clear() {
   buf->text("");
   sbuf->text("");
   lines = 0;
+  pend_len_ = 0;                // drop text not yet added in streaming mode
+  pend_lines_ = 0;
 }
 
 /**
  Remove the specified range of lines from the terminal, starting
  with line 'start' and removing 'count' lines.
 
- This method is used to enforce the history limit.
+ This method is used to enforce the history limit. Lines are counted
+ by their line feeds, wrapped lines count as one line. In streaming mode,
+ only the lines that were added to the terminal can be removed, see
+ flush_pending().
 
  \param start -- starting line to remove
  \param count -- number of lines to remove
 */
 void Fl_Simple_Terminal::remove_lines(int start, int count) {
-  int spos = skip_lines(0, start, true);
-  int epos = skip_lines(spos, count, true);
+  int spos = buf->skip_lines(0, start);
+  int epos = buf->skip_lines(spos, count);
+  int removed = buf->count_lines(spos, epos);
   if ( ansi() ) {
     buf->remove(spos, epos);
     sbuf->remove(spos, epos);
   } else {
     buf->remove(spos, epos);
   }
-  lines -= count;
+  lines -= removed;
   if ( lines < 0 ) lines = 0;
 }
 
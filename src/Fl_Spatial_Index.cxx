@@ -0,0 +1,209 @@
+//
+// Internal spatial index of group children for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Spatial_Index.h"
+#include <FL/Fl_Group.H>
+#include <math.h>
+#include <stdlib.h>
+
+// Aim at this many children per cell, and don't use more cells per side
+#define CHILDREN_PER_CELL 2
+#define MAX_CELLS 256
+
+// Makes sure that the array has room for n values.
+static int *grow(int *a, int &alloc, int n) {
+  if (n > alloc) {
+    alloc = n > 2 * alloc ? n : 2 * alloc;
+    a = (int*)realloc(a, alloc * sizeof(int));
+  }
+  return a;
+}
+
+// Returns 1 if the widget may draw its label outside of its bounds.
+static int outside_label(const Fl_Widget *o) {
+  if (!(o->align() & 15) || (o->align() & FL_ALIGN_INSIDE)) return 0;
+  return (o->label() && *o->label()) || o->image();
+}
+
+static int compare_int(const void *a, const void *b) {
+  return *(const int*)a - *(const int*)b;
+}
+
+Fl_Spatial_Index::Fl_Spatial_Index()
+: valid_(0), left_(0), top_(0), cell_w_(1), cell_h_(1), cols_(0), rows_(0),
+  start_(0), cells_(0), always_(0), num_always_(0), labels_(0), num_labels_(0),
+  alloc_cells_(0), alloc_start_(0), alloc_always_(0), alloc_labels_(0),
+  result_(0), alloc_result_(0), mark_(0), alloc_mark_(0), query_(0)
+{
+}
+
+Fl_Spatial_Index::~Fl_Spatial_Index() {
+  free(start_);
+  free(cells_);
+  free(always_);
+  free(labels_);
+  free(result_);
+  free(mark_);
+}
+
+void Fl_Spatial_Index::build(const Fl_Group *g) {
+  int n = g->children();
+  Fl_Widget *const *a = g->array();
+  int i;
+
+  // the grid covers the bounding box of all children that can be hit
+  int L = 0, T = 0, R = 0, B = 0, found = 0;
+  for (i = 0; i < n; i++) {
+    const Fl_Widget *o = a[i];
+    if (o->w() <= 0 || o->h() <= 0) continue;
+    if (!found || o->x() < L) L = o->x();
+    if (!found || o->y() < T) T = o->y();
+    if (!found || o->x() + o->w() > R) R = o->x() + o->w();
+    if (!found || o->y() + o->h() > B) B = o->y() + o->h();
+    found = 1;
+  }
+  int side = (int)sqrt((double)n / CHILDREN_PER_CELL);
+  if (side < 1) side = 1;
+  if (side > MAX_CELLS) side = MAX_CELLS;
+  left_ = L;
+  top_ = T;
+  cell_w_ = (R - L + side - 1) / side; if (cell_w_ < 1) cell_w_ = 1;
+  cell_h_ = (B - T + side - 1) / side; if (cell_h_ < 1) cell_h_ = 1;
+  cols_ = found ? (R - L + cell_w_ - 1) / cell_w_ : 0;
+  rows_ = found ? (B - T + cell_h_ - 1) / cell_h_ : 0;
+  int num_cells = cols_ * rows_;
+  // children that would be listed in more cells than this are in always_
+  int max_cells = num_cells / 4 > 4 ? num_cells / 4 : 4;
+
+  // count the children of each cell, then fill the cells in child order
+  start_ = grow(start_, alloc_start_, num_cells + 1);
+  for (i = 0; i <= num_cells; i++) start_[i] = 0;
+  num_always_ = num_labels_ = 0;
+  int pass, total = 0;
+  for (pass = 0; pass < 2; pass++) {
+    for (i = 0; i < n; i++) {
+      const Fl_Widget *o = a[i];
+      if (pass == 0 && outside_label(o)) {
+        labels_ = grow(labels_, alloc_labels_, num_labels_ + 1);
+        labels_[num_labels_++] = i;
+      }
+      if (o->w() <= 0 || o->h() <= 0) continue;
+      int c0 = (o->x() - left_) / cell_w_, c1 = (o->x() + o->w() - 1 - left_) / cell_w_;
+      int r0 = (o->y() - top_) / cell_h_, r1 = (o->y() + o->h() - 1 - top_) / cell_h_;
+      if ((c1 - c0 + 1) * (r1 - r0 + 1) > max_cells) {
+        if (pass == 0) {
+          always_ = grow(always_, alloc_always_, num_always_ + 1);
+          always_[num_always_++] = i;
+        }
+        continue;
+      }
+      for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+          int cell = r * cols_ + c;
+          if (pass == 0) start_[cell + 1]++;
+          else cells_[start_[cell]++] = i;
+        }
+      }
+    }
+    if (pass == 0) { // turn the counts into the start of each cell
+      for (i = 0; i < num_cells; i++) start_[i + 1] += start_[i];
+      total = start_[num_cells];
+      cells_ = grow(cells_, alloc_cells_, total);
+    }
+  }
+  // the fill pass advanced start_[i] to the start of cell i+1
+  for (i = num_cells; i > 0; i--) start_[i] = start_[i - 1];
+  start_[0] = 0;
+
+  if (n > alloc_mark_) {
+    free(mark_);
+    alloc_mark_ = n;
+    mark_ = (unsigned*)calloc(n, sizeof(unsigned));
+    query_ = 0;
+  }
+  valid_ = 1;
+}
+
+int Fl_Spatial_Index::result_size(int n) {
+  result_ = grow(result_, alloc_result_, n);
+  return n;
+}
+
+int Fl_Spatial_Index::find(const Fl_Group *g, int X, int Y, const int *&list) {
+  if (!valid_) build(g);
+  const int *c = 0, *c_end = 0;
+  int c0 = X - left_, r0 = Y - top_;
+  if (c0 >= 0 && r0 >= 0) {
+    c0 /= cell_w_;
+    r0 /= cell_h_;
+    if (c0 < cols_ && r0 < rows_) {
+      int cell = r0 * cols_ + c0;
+      c = cells_ + start_[cell];
+      c_end = cells_ + start_[cell + 1];
+    }
+  }
+  // merge the cell with always_, both are in ascending order
+  result_size((int)(c_end - c) + num_always_);
+  int n = 0;
+  const int *al = always_, *al_end = always_ + num_always_;
+  while (c < c_end || al < al_end) {
+    if (al == al_end || (c < c_end && *c < *al)) result_[n++] = *c++;
+    else result_[n++] = *al++;
+  }
+  list = result_;
+  return n;
+}
+
+int Fl_Spatial_Index::find(const Fl_Group *g, int X, int Y, int W, int H, const int *&list) {
+  if (!valid_) build(g);
+  int n = 0, i;
+  if (++query_ == 0) { // wrapped around: reset all marks
+    for (i = 0; i < alloc_mark_; i++) mark_[i] = 0;
+    query_ = 1;
+  }
+  int c0 = X - left_, c1 = X + W - 1 - left_;
+  int r0 = Y - top_, r1 = Y + H - 1 - top_;
+  c0 = c0 < 0 ? 0 : c0 / cell_w_;
+  r0 = r0 < 0 ? 0 : r0 / cell_h_;
+  c1 = c1 < 0 ? -1 : c1 / cell_w_; if (c1 >= cols_) c1 = cols_ - 1;
+  r1 = r1 < 0 ? -1 : r1 / cell_h_; if (r1 >= rows_) r1 = rows_ - 1;
+  if (W <= 0 || H <= 0) c1 = r1 = -1;
+  for (int r = r0; r <= r1; r++) {
+    for (int c = c0; c <= c1; c++) {
+      int cell = r * cols_ + c;
+      result_size(n + start_[cell + 1] - start_[cell]);
+      for (i = start_[cell]; i < start_[cell + 1]; i++) {
+        int k = cells_[i];
+        if (mark_[k] != query_) {
+          mark_[k] = query_;
+          result_[n++] = k;
+        }
+      }
+    }
+  }
+  result_size(n + num_always_ + num_labels_);
+  for (i = 0; i < num_always_; i++) {
+    int k = always_[i];
+    if (mark_[k] != query_) { mark_[k] = query_; result_[n++] = k; }
+  }
+  for (i = 0; i < num_labels_; i++) {
+    int k = labels_[i];
+    if (mark_[k] != query_) { mark_[k] = query_; result_[n++] = k; }
+  }
+  if (n > 1) qsort(result_, n, sizeof(int), compare_int);
+  list = result_;
+  return n;
+}
@@ -0,0 +1,74 @@
+//
+// Internal spatial index of group children for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/*
+  This internal (undocumented) class sorts the children of an Fl_Group
+  into the cells of a uniform grid over their bounding box, so that the
+  children at a point or in a rectangle can be found without testing all
+  children. See Fl_Group::spatial_index(int).
+
+  Each cell lists the indexes of the children that intersect it in
+  ascending order. Children that cover a large part of the grid are kept
+  in a separate list that is part of every result. Children that draw
+  their label outside of their bounds are part of every rectangle query,
+  because the size of the label is not known without measuring it.
+
+  The index is rebuilt lazily by the first query after invalidate(), which
+  Fl_Group calls when children are added, removed, moved or resized.
+  Queries return child indexes in ascending order; the returned array is
+  valid until the next query.
+*/
+
+#ifndef FL_SPATIAL_INDEX_H
+#define FL_SPATIAL_INDEX_H
+
+class Fl_Group;
+
+class Fl_Spatial_Index {
+
+  int valid_;                 // 0 if build() must be called
+  int left_, top_;            // top left corner of the grid
+  int cell_w_, cell_h_;       // cell size
+  int cols_, rows_;           // number of cells
+  int *start_;                // cell i lists cells_[start_[i] .. start_[i+1]-1]
+  int *cells_;                // child indexes of all cells
+  int *always_;               // children that are part of every result
+  int num_always_;
+  int *labels_;               // children with labels outside of their bounds
+  int num_labels_;
+  int alloc_cells_, alloc_start_, alloc_always_, alloc_labels_;
+  int *result_;               // the last result
+  int alloc_result_;
+  unsigned *mark_;            // per child: number of the last query it was found by
+  int alloc_mark_;
+  unsigned query_;            // number of the current query
+
+  void build(const Fl_Group *g);
+  int result_size(int n);
+
+public:
+  Fl_Spatial_Index();
+  ~Fl_Spatial_Index();
+
+  void invalidate() { valid_ = 0; }
+
+  // children whose bounds contain the point X, Y, and children in always_
+  int find(const Fl_Group *g, int X, int Y, const int *&list);
+  // children whose bounds intersect the rectangle, always_ and labels_
+  int find(const Fl_Group *g, int X, int Y, int W, int H, const int *&list);
+};
+
+#endif // FL_SPATIAL_INDEX_H
@@ -16,6 +16,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <FL/fl_utf8.h>
 #include <FL/fl_string.h>
 #include "flstring.h"
@@ -23,6 +24,15 @@
 #include <FL/Fl.H>
 #include <FL/Fl_Text_Buffer.H>
 #include <FL/fl_ask.H>
+#include "Fl_Text_Piece_Table.h"
+#include "Fl_Text_Line_Index.h"
+#include "Fl_Undo_Journal.h"
+#include "Fl_System_Driver.H"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define FL_TEXT_SSE2 1
+#endif
 
 
 /*
@@ -67,32 +77,125 @@ static int min(int i1, int i2)
 #endif
 
 
-static char *undobuffer;
-static int undobufferlength;
-static Fl_Text_Buffer *undowidget;
-static int undoat;              // points after insertion
-static int undocut;             // number of characters deleted there
-static int undoinsert;          // number of characters inserted
-static int undoyankcut;         // length of valid contents of buffer, even if undocut=0
+/*
+ Byte scanning kernels for contiguous text. Searching forward uses
+ memchr(), which the C libraries implement with vector instructions.
+ Counting and searching backward use SSE2 where it is available, which
+ is always the case on x86-64, and plain loops elsewhere.
+ */
 
 /*
- Resize the undo buffer to match at least the requested size.
+ Count the bytes c in p[0] .. p[n-1].
  */
-static void undobuffersize(int n)
+static int count_byte(const char *p, int n, char c)
 {
-  if (n > undobufferlength) {
-    if (undobuffer) {
-      do {
-        undobufferlength *= 2;
-      } while (undobufferlength < n);
-      undobuffer = (char *) realloc(undobuffer, undobufferlength);
-    } else {
-      undobufferlength = n + 9;
-      undobuffer = (char *) malloc(undobufferlength);
+  int count = 0;
+#if FL_TEXT_SSE2
+  const __m128i cc = _mm_set1_epi8(c);
+  while (n >= 16) {
+    // the 8 bit counters of acc can count up to 255 blocks
+    int blocks = min(n / 16, 255);
+    __m128i acc = _mm_setzero_si128();
+    for (int i = 0; i < blocks; i++, p += 16)
+      acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) p), cc));
+    __m128i sum = _mm_sad_epu8(acc, _mm_setzero_si128());
+    count += _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+    n -= blocks * 16;
+  }
+#endif
+  for (; n > 0; n--)
+    if (*p++ == c)
+      count++;
+  return count;
+}
+
+
+/*
+ Return the address of the last byte c in p[0] .. p[n-1], or NULL.
+ */
+static const char *rfind_byte(const char *p, int n, char c)
+{
+#if FL_TEXT_SSE2
+  const __m128i cc = _mm_set1_epi8(c);
+  while (n >= 16) {
+    int mask = _mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + n - 16)), cc));
+    if (mask) {
+#  if defined(__GNUC__)
+      return p + n - 16 + (31 - __builtin_clz(mask));
+#  else
+      int i = 15;
+      while (!(mask & (1 << i)))
+        i--;
+      return p + n - 16 + i;
+#  endif
     }
+    n -= 16;
   }
+#endif
+  while (n > 0)
+    if (p[--n] == c)
+      return p + n;
+  return NULL;
 }
 
+
+/*
+ The changes since begin_transaction(). The changed range starts at start
+ and ends tail bytes before the end of the text. deleted holds the text of
+ the range before the transaction: all text outside of the range is still
+ unchanged, so the range grows by copying the bytes it takes in before an
+ edit changes them.
+ */
+struct Fl_Text_Transaction {
+  int depth;            // nesting depth of begin_transaction()
+  int start;            // start of the changed range, or -1 if none
+  int tail;             // number of unchanged bytes after the range
+  char *deleted;        // old text of the range
+  int deletedLength;
+  int deletedSize;      // allocated size of deleted
+  void extend(const Fl_Text_Buffer *buf, int from, int to);
+};
+
+
+/*
+ Grow the changed range to include from...to of the current text.
+ */
+void Fl_Text_Transaction::extend(const Fl_Text_Buffer *buf, int from, int to)
+{
+  int length = buf->length();
+  if (start < 0) {
+    start = from;
+    tail = length - from;
+  }
+  int end = length - tail;
+  int pre = from < start ? start - from : 0;
+  int post = to > end ? to - end : 0;
+  if (!pre && !post)
+    return;
+
+  if (deletedLength + pre + post >= deletedSize) {
+    deletedSize = 2 * (deletedLength + pre + post) + 64;
+    deleted = (char *) realloc(deleted, deletedSize);
+  }
+  if (pre) {
+    char *t = buf->text_range(from, start);
+    memmove(deleted + pre, deleted, deletedLength);
+    memcpy(deleted, t, pre);
+    free(t);
+    start = from;
+  }
+  if (post) {
+    char *t = buf->text_range(end, to);
+    memcpy(deleted + pre + deletedLength, t, post);
+    free(t);
+    tail = length - to;
+  }
+  deletedLength += pre + post;
+  deleted[deletedLength] = 0;
+}
+
+
 static void def_transcoding_warning_action(Fl_Text_Buffer *text)
 {
   fl_alert("%s", text->file_encoding_warning_message);
@@ -108,6 +211,10 @@ Fl_Text_Buffer::Fl_Text_Buffer(int requestedSize, int preferredGapSize)
   mBuf = (char *) malloc(requestedSize + mPreferredGapSize);
   mGapStart = 0;
   mGapEnd = requestedSize + mPreferredGapSize;
+  mPieces = NULL;
+  mLineIndex = new Fl_Text_Line_Index(this);
+  mUndo = new Fl_Undo_Journal;
+  mTransaction = NULL;
   mTabDist = 8;
   mPrimary.mSelected = 0;
   mPrimary.mStart = mPrimary.mEnd = 0;
@@ -134,6 +241,13 @@ Fl_Text_Buffer::Fl_Text_Buffer(int requestedSize, int preferredGapSize)
 Fl_Text_Buffer::~Fl_Text_Buffer()
 {
   free(mBuf);
+  delete mPieces;
+  delete mLineIndex;
+  delete mUndo;
+  if (mTransaction) {
+    free(mTransaction->deleted);
+    delete mTransaction;
+  }
   if (mNModifyProcs != 0) {
     delete[]mModifyProcs;
     delete[]mCbArgs;
@@ -151,13 +265,75 @@ Fl_Text_Buffer::~Fl_Text_Buffer()
  */
 char *Fl_Text_Buffer::text() const {
   char *t = (char *) malloc(mLength + 1);
-  memcpy(t, mBuf, mGapStart);
-  memcpy(t+mGapStart, mBuf+mGapEnd, mLength - mGapStart);
+  if (mPieces) {
+    mPieces->copy(0, mLength, t);
+  } else {
+    memcpy(t, mBuf, mGapStart);
+    memcpy(t+mGapStart, mBuf+mGapEnd, mLength - mGapStart);
+  }
   t[mLength] = '\0';
   return t;
 }
 
 
+/**
+ Selects how the text is stored.
+
+ The default is the GAP_BUFFER storage: the text is kept in one memory
+ block with a gap at the position of the last edit. Typing and other
+ edits near the gap are fast, but an edit far away from the gap moves all
+ text between the two positions, and the whole text needs one contiguous
+ memory block.
+
+ The PIECE_TABLE storage keeps the text as pieces in a balanced tree.
+ Inserting and removing text anywhere takes O(log n) time in the number
+ of pieces, and the text is stored in blocks of moderate size. Reading
+ the text byte by byte is slightly slower. Use it for very large texts,
+ e.g. log files, and set it before loading the text.
+
+ The current text is kept. All methods of Fl_Text_Buffer work the same
+ with both kinds of storage, except that the text at address(int) is
+ contiguous only up to the end of its piece.
+
+ \param s the new storage
+ \see storage()
+ */
+void Fl_Text_Buffer::storage(Storage s)
+{
+  if (s == storage())
+    return;
+  if (s == PIECE_TABLE) {
+    mPieces = new Fl_Text_Piece_Table;
+    mPieces->insert(0, mBuf, mGapStart);
+    mPieces->insert(mGapStart, mBuf + mGapEnd, mLength - mGapStart);
+    free((void *) mBuf);
+    mBuf = NULL;
+    mGapStart = mGapEnd = 0;
+  } else {
+    mBuf = (char *) malloc(mLength + mPreferredGapSize);
+    mPieces->copy(0, mLength, mBuf);
+    mGapStart = mLength;
+    mGapEnd = mLength + mPreferredGapSize;
+    delete mPieces;
+    mPieces = NULL;
+  }
+}
+
+
+/*
+ Return the address of a position in the piece table, or the address of
+ an empty string at the end of the text.
+ */
+const char *Fl_Text_Buffer::piece_address(int pos) const
+{
+  static char end_of_text[1];
+  if (pos < 0 || pos >= mLength)
+    return end_of_text;
+  int start, len;
+  return mPieces->piece(pos, start, len) + pos - start;
+}
+
+
 /*
  Set the text buffer to a new string.
  */
@@ -174,15 +350,23 @@ void Fl_Text_Buffer::text(const char *t)
   /* Save information for redisplay, and get rid of the old buffer */
   const char *deletedText = text();
   int deletedLength = mLength;
-  free((void *) mBuf);
-
-  /* Start a new buffer with a gap of mPreferredGapSize at the end */
   int insertedLength = (int) strlen(t);
-  mBuf = (char *) malloc(insertedLength + mPreferredGapSize);
   mLength = insertedLength;
-  mGapStart = insertedLength;
-  mGapEnd = mGapStart + mPreferredGapSize;
-  memcpy(mBuf, t, insertedLength);
+
+  if (mPieces) {
+    mPieces->clear();
+    mPieces->insert(0, t, insertedLength);
+  } else {
+    /* Start a new buffer with a gap of mPreferredGapSize at the end */
+    free((void *) mBuf);
+    mBuf = (char *) malloc(insertedLength + mPreferredGapSize);
+    mGapStart = insertedLength;
+    mGapEnd = mGapStart + mPreferredGapSize;
+    memcpy(mBuf, t, insertedLength);
+  }
+  mLineIndex->clear();
+  mLineIndex->insert(0, insertedLength);
+  mUndo->clear();
 
   /* Zero all of the existing selections */
   update_selections(0, deletedLength, 0);
@@ -221,7 +405,9 @@ char *Fl_Text_Buffer::text_range(int start, int end) const {
   s = (char *) malloc(copiedLength + 1);
 
   /* Copy the text from the buffer to the returned string */
-  if (end <= mGapStart) {
+  if (mPieces) {
+    mPieces->copy(start, end, s);
+  } else if (end <= mGapStart) {
     memcpy(s, mBuf + start, copiedLength);
   } else if (start >= mGapStart) {
     memcpy(s, mBuf + start + (mGapEnd - mGapStart), copiedLength);
@@ -256,6 +442,8 @@ unsigned int Fl_Text_Buffer::char_at(int pos) const {
 char Fl_Text_Buffer::byte_at(int pos) const {
   if (pos < 0 || pos >= mLength)
     return '\0';
+  if (mPieces)
+    return mPieces->byte_at(pos);
   const char *src = address(pos);
   return *src;
 }
@@ -413,6 +601,22 @@ void Fl_Text_Buffer::copy(Fl_Text_Buffer * fromBuf, int fromStart,
 
   int copiedLength = fromEnd - fromStart;
 
+  /* copy() calls no callbacks, but a transaction reports the copied text */
+  if (mTransaction)
+    mTransaction->extend(this, toPos, toPos);
+
+  if (mPieces) {
+    char *t = fromBuf->text_range(fromStart, fromEnd);
+    mPieces->insert(toPos, t, copiedLength);
+    if (mCanUndo)
+      mUndo->inserted(toPos, t, copiedLength);
+    free(t);
+    mLength += copiedLength;
+    mLineIndex->insert(toPos, copiedLength);
+    update_selections(toPos, 0, copiedLength);
+    return;
+  }
+
   /* Prepare the buffer to receive the new text.  If the new text fits in
    the current buffer, just move the gap (if necessary) to where
    the text should be inserted.  If the new text is too large, reallocate
@@ -424,7 +628,9 @@ void Fl_Text_Buffer::copy(Fl_Text_Buffer * fromBuf, int fromStart,
     move_gap(toPos);
 
   /* Insert the new text (toPos now corresponds to the start of the gap) */
-  if (fromEnd <= fromBuf->mGapStart) {
+  if (fromBuf->mPieces) {
+    fromBuf->mPieces->copy(fromStart, fromEnd, &mBuf[toPos]);
+  } else if (fromEnd <= fromBuf->mGapStart) {
     memcpy(&mBuf[toPos], &fromBuf->mBuf[fromStart], copiedLength);
   } else if (fromStart >= fromBuf->mGapStart) {
     memcpy(&mBuf[toPos],
@@ -438,62 +644,139 @@ void Fl_Text_Buffer::copy(Fl_Text_Buffer * fromBuf, int fromStart,
   }
   mGapStart += copiedLength;
   mLength += copiedLength;
+  mLineIndex->insert(toPos, copiedLength);
   update_selections(toPos, 0, copiedLength);
+  if (mCanUndo)
+    mUndo->inserted(toPos, &mBuf[toPos], copiedLength);
 }
 
 
 /*
- Take the previous changes and undo them. Return the previous
- cursor position in cursorPos. Returns 1 if the undo was applied.
+ Undo the last edit. Return the cursor position after the edit in
+ cursorPos. Returns 1 if the undo was applied.
  CursorPos will be at a character boundary.
  */
 int Fl_Text_Buffer::undo(int *cursorPos)
 {
-  if (undowidget != this || (!undocut && !undoinsert && !mCanUndo))
-    return 0;
+  return undo_step(0, cursorPos);
+}
 
-  int ilen = undocut;
-  int xlen = undoinsert;
-  int b = undoat - xlen;
-
-  if (xlen && undoyankcut && !ilen) {
-    ilen = undoyankcut;
-  }
-
-  if (xlen && ilen) {
-    undobuffersize(ilen + 1);
-    undobuffer[ilen] = 0;
-    char *tmp = fl_strdup(undobuffer);
-    replace(b, undoat, tmp);
-    if (cursorPos)
-      *cursorPos = mCursorPosHint;
-    free(tmp);
-  } else if (xlen) {
-    remove(b, undoat);
-    if (cursorPos)
-      *cursorPos = mCursorPosHint;
-  } else if (ilen) {
-    undobuffersize(ilen + 1);
-    undobuffer[ilen] = 0;
-    insert(undoat, undobuffer);
-    if (cursorPos)
-      *cursorPos = mCursorPosHint;
-    undoyankcut = 0;
-  }
 
+/*
+ Redo the last undone edit. Return the cursor position after the edit in
+ cursorPos. Returns 1 if the redo was applied.
+ */
+int Fl_Text_Buffer::redo(int *cursorPos)
+{
+  return undo_step(1, cursorPos);
+}
+
+
+/*
+ Replace the text of the next edit of the undo journal, and of the edits
+ grouped with it. remove_() copies the replaced text to the journal, and
+ insert_() does not record anything while the journal is stepping.
+ */
+int Fl_Text_Buffer::undo_step(int redo, int *cursorPos)
+{
+  Fl_Undo_Journal::Step s;
+  if (!mUndo->start(redo, s))
+    return 0;
+  begin_transaction();
+  for (;;) {
+    replace(s.pos, s.pos + s.remove, s.insert);
+    mUndo->finish();
+    if (!mUndo->joined(redo) || !mUndo->start(redo, s))
+      break;
+  }
+  end_transaction();
+  if (cursorPos)
+    *cursorPos = mCursorPosHint;
   return 1;
 }
 
 
+int Fl_Text_Buffer::can_undo() const
+{
+  return mUndo->can_undo();
+}
+
+
+int Fl_Text_Buffer::can_redo() const
+{
+  return mUndo->can_redo();
+}
+
+
 /*
  Set a flag if undo function will work.
  */
 void Fl_Text_Buffer::canUndo(char flag)
 {
   mCanUndo = flag;
-  // disabling undo also clears the last undo operation!
-  if (!mCanUndo && undowidget==this)
-    undowidget = 0;
+  // disabling undo also clears the undo journal!
+  if (!mCanUndo)
+    mUndo->clear();
+}
+
+
+void Fl_Text_Buffer::undo_memory(int bytes)
+{
+  mUndo->max_memory(bytes);
+}
+
+
+int Fl_Text_Buffer::undo_memory() const
+{
+  return mUndo->max_memory();
+}
+
+
+/*
+ Start deferring the callbacks and collecting the changed range.
+ */
+void Fl_Text_Buffer::begin_transaction()
+{
+  if (!mTransaction) {
+    mTransaction = new Fl_Text_Transaction;
+    mTransaction->depth = 0;
+    mTransaction->start = -1;
+    mTransaction->tail = 0;
+    mTransaction->deleted = NULL;
+    mTransaction->deletedLength = 0;
+    mTransaction->deletedSize = 0;
+    mUndo->begin_group();
+  }
+  mTransaction->depth++;
+}
+
+
+/*
+ Report the changed range of the outermost transaction.
+ */
+void Fl_Text_Buffer::end_transaction()
+{
+  Fl_Text_Transaction *t = mTransaction;
+  if (!t || --t->depth > 0)
+    return;
+  mTransaction = NULL;
+  mUndo->end_group();
+
+  int start = t->start;
+  int nDeleted = t->deletedLength;
+  int nInserted = start < 0 ? 0 : mLength - t->tail - start;
+  const char *deletedText = nDeleted ? t->deleted : NULL;
+  /* the pre-delete callbacks are not called: the old text is gone */
+  if (nInserted || nDeleted)
+    call_modify_callbacks(start, nDeleted, nInserted, 0, deletedText);
+  free(t->deleted);
+  delete t;
+}
+
+
+int Fl_Text_Buffer::in_transaction() const
+{
+  return mTransaction ? mTransaction->depth : 0;
 }
 
 
@@ -948,40 +1231,151 @@ int Fl_Text_Buffer::skip_displayed_characters(int lineStartPos, int nChars)
 }
 
 
+/*
+ Lines that are found by scanning the text. Beyond this distance, the
+ line index is used.
+ */
+#define LINE_SCAN_LIMIT 4096
+
+
+/*
+ Return the address of a position and the contiguous text around it.
+ */
+const char *Fl_Text_Buffer::span(int pos, int &start, int &end) const
+{
+  if (mPieces) {
+    int len;
+    const char *p = mPieces->piece(pos, start, len);
+    end = start + len;
+    return p + pos - start;
+  }
+  if (pos < mGapStart) {
+    start = 0;
+    end = mGapStart;
+    return mBuf + pos;
+  }
+  start = mGapStart;
+  end = mLength;
+  return mBuf + pos + mGapEnd - mGapStart;
+}
+
+
+/*
+ Count the newlines between two positions.
+ */
+int Fl_Text_Buffer::count_lines_(int startPos, int endPos) const
+{
+  int pos = startPos;
+  int lineCount = 0;
+  while (pos < endPos) {
+    int start, end;
+    const char *p = span(pos, start, end);
+    end = min(end, endPos);
+    lineCount += count_byte(p, end - pos, '\n');
+    pos = end;
+  }
+  return lineCount;
+}
+
+
+/*
+ Scan forward for newlines.
+ */
+int Fl_Text_Buffer::skip_lines_(int startPos, int endPos, int nLines,
+                                int *nFound) const
+{
+  int pos = startPos;
+  int lineCount = 0;
+  while (pos < endPos) {
+    int start, end;
+    const char *p = span(pos, start, end) - pos;
+    end = min(end, endPos);
+    while (pos < end) {
+      const char *q = (const char *) memchr(p + pos, '\n', end - pos);
+      if (!q) {
+        pos = end;
+        break;
+      }
+      pos = (int) (q - p) + 1;
+      if (++lineCount >= nLines) {
+        *nFound = lineCount;
+        return pos;
+      }
+    }
+  }
+  *nFound = lineCount;
+  return pos;
+}
+
+
+/*
+ Scan backward for newlines.
+ */
+int Fl_Text_Buffer::rewind_lines_(int startPos, int endPos, int nLines) const
+{
+  int pos = startPos - 1;
+  int lineCount = 0;
+  while (pos >= endPos) {
+    int start, end;
+    const char *p = span(pos, start, end) - pos;
+    start = max(start, endPos);
+    while (pos >= start) {
+      const char *q = rfind_byte(p + start, pos - start + 1, '\n');
+      if (!q) {
+        pos = start - 1;
+        break;
+      }
+      pos = (int) (q - p);
+      if (++lineCount >= nLines)
+        return pos + 1;
+      pos--;
+    }
+  }
+  return endPos;
+}
+
+
+/*
+ Compare the text at a position with a string.
+ */
+bool Fl_Text_Buffer::match_(int pos, const char *text, int len) const
+{
+  if (pos < 0 || pos + len > mLength)
+    return false;
+  while (len > 0) {
+    int start, end;
+    const char *p = span(pos, start, end);
+    int n = min(end - pos, len);
+    if (memcmp(p, text, n))
+      return false;
+    pos += n;
+    text += n;
+    len -= n;
+  }
+  return true;
+}
+
+
 /*
  Count the number of newline characters between start and end.
  startPos and endPos must be at a character boundary.
- This function is optimized for speed by not using UTF-8 calls.
  */
 int Fl_Text_Buffer::count_lines(int startPos, int endPos) const {
   IS_UTF8_ALIGNED2(this, (startPos))
   IS_UTF8_ALIGNED2(this, (endPos))
 
-  int gapLen = mGapEnd - mGapStart;
-  int lineCount = 0;
+  if (endPos < startPos || endPos > mLength)
+    endPos = mLength;
+  if (endPos - startPos > LINE_SCAN_LIMIT)
+    return mLineIndex->line(endPos) - mLineIndex->line(startPos);
 
-  int pos = startPos;
-  while (pos < mGapStart)
-  {
-    if (pos == endPos)
-      return lineCount;
-    if (mBuf[pos++] == '\n')
-      lineCount++;
-  }
-  while (pos < mLength) {
-    if (pos == endPos)
-      return lineCount;
-    if (mBuf[pos++ + gapLen] == '\n')
-      lineCount++;
-  }
-  return lineCount;
+  return count_lines_(startPos, endPos);
 }
 
 
 /*
  Skip to the first character, n lines ahead.
  StartPos must be at a character boundary.
- This function is optimized for speed by not using UTF-8 calls.
  */
 int Fl_Text_Buffer::skip_lines(int startPos, int nLines)
 {
@@ -990,26 +1384,13 @@ int Fl_Text_Buffer::skip_lines(int startPos, int nLines)
   if (nLines == 0)
     return startPos;
 
-  int gapLen = mGapEnd - mGapStart;
-  int pos = startPos;
-  int lineCount = 0;
-  while (pos < mGapStart) {
-    if (mBuf[pos++] == '\n') {
-      lineCount++;
-      if (lineCount == nLines) {
-        IS_UTF8_ALIGNED2(this, (pos))
-        return pos;
-      }
-    }
-  }
-  while (pos < mLength) {
-    if (mBuf[pos++ + gapLen] == '\n') {
-      lineCount++;
-      if (lineCount >= nLines) {
-        IS_UTF8_ALIGNED2(this, (pos))
-        return pos;
-      }
-    }
+  /* Nearby lines are found faster by scanning the text */
+  int end = min(mLength, startPos + LINE_SCAN_LIMIT);
+  int lineCount;
+  int pos = skip_lines_(startPos, end, nLines, &lineCount);
+  if (lineCount < nLines && end < mLength) {
+    int n = mLineIndex->line(startPos) + nLines;
+    pos = n > mLineIndex->lines() ? mLength : mLineIndex->position(n);
   }
   IS_UTF8_ALIGNED2(this, (pos))
   return pos;
@@ -1019,37 +1400,25 @@ int Fl_Text_Buffer::skip_lines(int startPos, int nLines)
 /*
  Skip to the first character, n lines back.
  StartPos must be at a character boundary.
- This function is optimized for speed by not using UTF-8 calls.
  */
 int Fl_Text_Buffer::rewind_lines(int startPos, int nLines)
 {
   IS_UTF8_ALIGNED2(this, (startPos))
 
-  int pos = startPos - 1;
-  if (pos <= 0)
+  if (startPos - 1 <= 0)
     return 0;
+  if (startPos > mLength)
+    startPos = mLength;
 
-  int gapLen = mGapEnd - mGapStart;
-  int lineCount = -1;
-  while (pos >= mGapStart) {
-    if (mBuf[pos + gapLen] == '\n') {
-      if (++lineCount >= nLines) {
-        IS_UTF8_ALIGNED2(this, (pos+1))
-        return pos + 1;
-      }
-    }
-    pos--;
-  }
-  while (pos >= 0) {
-    if (mBuf[pos] == '\n') {
-      if (++lineCount >= nLines) {
-        IS_UTF8_ALIGNED2(this, (pos+1))
-        return pos + 1;
-      }
-    }
-    pos--;
+  /* Nearby lines are found faster by scanning the text */
+  int end = max(0, startPos - LINE_SCAN_LIMIT);
+  int pos = rewind_lines_(startPos, end, nLines + 1);
+  if (pos == end && end > 0) {
+    int n = mLineIndex->line(startPos) - nLines;
+    pos = n < 1 ? 0 : mLineIndex->position(n);
   }
-  return 0;
+  IS_UTF8_ALIGNED2(this, (pos))
+  return pos;
 }
 
 
@@ -1066,23 +1435,34 @@ int Fl_Text_Buffer::search_forward(int startPos, const char *searchString,
     return 0;
   int bp;
   const char *sp;
-  if (matchCase) {
-    while (startPos < length()) {
-      bp = startPos;
-      sp = searchString;
-      for (;;) {
-        char c = *sp;
-        // we reached the end of the "needle", so we found the string!
-        if (!c) {
-          *foundPos = startPos;
-          return 1;
-        }
-        int l = fl_utf8len1(c);
-        if (memcmp(sp, address(bp), l))
-          break;
-        sp += l; bp += l;
+  if (matchCase && *searchString) {
+    /* Find the first byte of the string and compare the rest. The first
+     byte of a UTF-8 character is never found inside another character. */
+    int len = (int) strlen(searchString);
+    int last = mLength - len;
+    if (startPos < 0)
+      startPos = 0;
+    while (startPos <= last) {
+      int start, end;
+      const char *p = span(startPos, start, end) - startPos;
+      end = min(end, last + 1);
+      const char *q = (const char *) memchr(p + startPos, *searchString,
+                                            end - startPos);
+      if (!q) {
+        startPos = end;
+        continue;
       }
-      startPos = next_char(startPos);
+      startPos = (int) (q - p);
+      if (match_(startPos, searchString, len)) {
+        *foundPos = startPos;
+        return 1;
+      }
+      startPos++;
+    }
+  } else if (matchCase) {
+    if (startPos < length()) {
+      *foundPos = startPos;
+      return 1;
     }
   } else {
     while (startPos < length()) {
@@ -1118,23 +1498,30 @@ int Fl_Text_Buffer::search_backward(int startPos, const char *searchString,
     return 0;
   int bp;
   const char *sp;
-  if (matchCase) {
+  if (matchCase && *searchString) {
+    /* Find the first byte of the string backwards and compare the rest */
+    int len = (int) strlen(searchString);
+    if (startPos > mLength - len)
+      startPos = mLength - len;
     while (startPos >= 0) {
-      bp = startPos;
-      sp = searchString;
-      for (;;) {
-        char c = *sp;
-        // we reached the end of the "needle", so we found the string!
-        if (!c) {
-          *foundPos = startPos;
-          return 1;
-        }
-        int l = fl_utf8len1(c);
-        if (memcmp(sp, address(bp), l))
-          break;
-        sp += l; bp += l;
+      int start, end;
+      const char *p = span(startPos, start, end) - startPos;
+      const char *q = rfind_byte(p + start, startPos - start + 1, *searchString);
+      if (!q) {
+        startPos = start - 1;
+        continue;
       }
-      startPos = prev_char(startPos);
+      startPos = (int) (q - p);
+      if (match_(startPos, searchString, len)) {
+        *foundPos = startPos;
+        return 1;
+      }
+      startPos--;
+    }
+  } else if (matchCase) {
+    if (startPos >= 0) {
+      *foundPos = startPos;
+      return 1;
     }
   } else {
     while (startPos >= 0) {
@@ -1161,6 +1548,29 @@ int Fl_Text_Buffer::search_backward(int startPos, const char *searchString,
 }
 
 
+/*
+ Replace all occurrences of a string in one transaction.
+ */
+int Fl_Text_Buffer::replace_all(const char *searchString,
+                                const char *replaceString, int matchCase)
+{
+  int searchLength = (int) strlen(searchString);
+  int replaceLength = (int) strlen(replaceString);
+  if (!searchLength)
+    return 0;
+
+  int n = 0, pos = 0, foundPos;
+  begin_transaction();
+  while (search_forward(pos, searchString, &foundPos, matchCase)) {
+    replace(foundPos, foundPos + searchLength, replaceString);
+    pos = foundPos + replaceLength;
+    n++;
+  }
+  end_transaction();
+  return n;
+}
+
+
 
 /*
  Insert a string into the buffer.
@@ -1173,33 +1583,29 @@ int Fl_Text_Buffer::insert_(int pos, const char *text)
 
   int insertedLength = (int) strlen(text);
 
-  /* Prepare the buffer to receive the new text.  If the new text fits in
-   the current buffer, just move the gap (if necessary) to where
-   the text should be inserted.  If the new text is too large, reallocate
-   the buffer with a gap large enough to accomodate the new text and a
-   gap of mPreferredGapSize */
-  if (insertedLength > mGapEnd - mGapStart)
-    reallocate_with_gap(pos, insertedLength + mPreferredGapSize);
-  else if (pos != mGapStart)
-    move_gap(pos);
-
-  /* Insert the new text (pos now corresponds to the start of the gap) */
-  memcpy(&mBuf[pos], text, insertedLength);
-  mGapStart += insertedLength;
+  if (mPieces) {
+    mPieces->insert(pos, text, insertedLength);
+  } else {
+    /* Prepare the buffer to receive the new text.  If the new text fits in
+     the current buffer, just move the gap (if necessary) to where
+     the text should be inserted.  If the new text is too large, reallocate
+     the buffer with a gap large enough to accomodate the new text and a
+     gap of mPreferredGapSize */
+    if (insertedLength > mGapEnd - mGapStart)
+      reallocate_with_gap(pos, insertedLength + mPreferredGapSize);
+    else if (pos != mGapStart)
+      move_gap(pos);
+
+    /* Insert the new text (pos now corresponds to the start of the gap) */
+    memcpy(&mBuf[pos], text, insertedLength);
+    mGapStart += insertedLength;
+  }
   mLength += insertedLength;
+  mLineIndex->insert(pos, insertedLength);
   update_selections(pos, 0, insertedLength);
 
-  if (mCanUndo) {
-    if (undowidget == this && undoat == pos && undoinsert) {
-      undoinsert += insertedLength;
-    } else {
-      undoinsert = insertedLength;
-      undoyankcut = (undoat == pos) ? undocut : 0;
-    }
-    undoat = pos + insertedLength;
-    undocut = 0;
-    undowidget = this;
-  }
+  if (mCanUndo)
+    mUndo->inserted(pos, text, insertedLength);
 
   return insertedLength;
 }
@@ -1211,37 +1617,36 @@ int Fl_Text_Buffer::insert_(int pos, const char *text)
  */
 void Fl_Text_Buffer::remove_(int start, int end)
 {
-  /* if the gap is not contiguous to the area to remove, move it there */
-
-  if (mCanUndo) {
-    if (undowidget == this && undoat == end && undocut) {
-      undobuffersize(undocut + end - start + 1);
-      memmove(undobuffer + end - start, undobuffer, undocut);
-      undocut += end - start;
-    } else {
-      undocut = end - start;
-      undobuffersize(undocut);
-    }
-    undoat = start;
-    undoinsert = 0;
-    undoyankcut = 0;
-    undowidget = this;
+  /* the undo journal keeps the text that is removed */
+  char *undoText = mCanUndo ? mUndo->removed(start, end) : NULL;
+
+  /* the line index scans the text that is removed */
+  mLineIndex->remove(start, end);
+
+  if (mPieces) {
+    if (undoText)
+      mPieces->copy(start, end, undoText);
+    mPieces->remove(start, end);
+    mLength -= end - start;
+    update_selections(start, end - start, 0);
+    return;
   }
 
+  /* if the gap is not contiguous to the area to remove, move it there */
   if (start > mGapStart) {
-    if (mCanUndo)
-      memcpy(undobuffer, mBuf + (mGapEnd - mGapStart) + start,
+    if (undoText)
+      memcpy(undoText, mBuf + (mGapEnd - mGapStart) + start,
              end - start);
     move_gap(start);
   } else if (end < mGapStart) {
-    if (mCanUndo)
-      memcpy(undobuffer, mBuf + start, end - start);
+    if (undoText)
+      memcpy(undoText, mBuf + start, end - start);
     move_gap(end);
   } else {
     int prelen = mGapStart - start;
-    if (mCanUndo) {
-      memcpy(undobuffer, mBuf + start, prelen);
-      memcpy(undobuffer + prelen, mBuf + mGapEnd, end - start - prelen);
+    if (undoText) {
+      memcpy(undoText, mBuf + start, prelen);
+      memcpy(undoText + prelen, mBuf + mGapEnd, end - start - prelen);
     }
   }
 
@@ -1389,6 +1794,12 @@ void Fl_Text_Buffer::call_modify_callbacks(int pos, int nDeleted,
                                            int nInserted, int nRestyled,
                                            const char *deletedText) const {
   IS_UTF8_ALIGNED2(this, pos)
+  if (mTransaction) {
+    /* call_predelete_callbacks() added text changes to the range */
+    if (!nInserted && !nDeleted)
+      mTransaction->extend(this, pos, pos + nRestyled);
+    return;
+  }
   for (int i = 0; i < mNModifyProcs; i++)
     (*mModifyProcs[i]) (pos, nInserted, nDeleted, nRestyled,
                         deletedText, mCbArgs[i]);
@@ -1400,6 +1811,12 @@ void Fl_Text_Buffer::call_modify_callbacks(int pos, int nDeleted,
  Unicode safe.
  */
 void Fl_Text_Buffer::call_predelete_callbacks(int pos, int nDeleted) const {
+  /* every change of the text calls this first, while the text that is
+   deleted is still there */
+  if (mTransaction) {
+    mTransaction->extend(this, pos, pos + nDeleted);
+    return;
+  }
   for (int i = 0; i < mNPredeleteProcs; i++)
     (*mPredeleteProcs[i]) (pos, nDeleted, mPredeleteCbArgs[i]);
 }
@@ -1568,6 +1985,22 @@ int Fl_Text_Buffer::findchar_forward(int startPos, unsigned searchChar,
   if (startPos<0)
     startPos = 0;
 
+  /* ASCII characters are never part of a UTF-8 sequence: search the bytes */
+  if (searchChar < 0x80) {
+    while (startPos < mLength) {
+      int start, end;
+      const char *p = span(startPos, start, end);
+      const char *q = (const char *) memchr(p, searchChar, end - startPos);
+      if (q) {
+        *foundPos = startPos + (int) (q - p);
+        return 1;
+      }
+      startPos = end;
+    }
+    *foundPos = mLength;
+    return 0;
+  }
+
   for ( ; startPos<mLength; startPos = next_char(startPos)) {
     if (searchChar == char_at(startPos)) {
       *foundPos = startPos;
@@ -1594,6 +2027,22 @@ int Fl_Text_Buffer::findchar_backward(int startPos, unsigned int searchChar,
   if (startPos > mLength)
     startPos = mLength;
 
+  /* ASCII characters are never part of a UTF-8 sequence: search the bytes */
+  if (searchChar < 0x80) {
+    while (startPos > 0) {
+      int start, end;
+      const char *p = span(startPos - 1, start, end) - (startPos - 1);
+      const char *q = rfind_byte(p + start, startPos - start, (char) searchChar);
+      if (q) {
+        *foundPos = (int) (q - p);
+        return 1;
+      }
+      startPos = start;
+    }
+    *foundPos = 0;
+    return 0;
+  }
+
   for (startPos = prev_char(startPos); startPos>=0; startPos = prev_char(startPos)) {
     if (searchChar == char_at(startPos)) {
       *foundPos = startPos;
@@ -1797,6 +2246,90 @@ const char *Fl_Text_Buffer::file_encoding_warning_message =
 }
 
 
+/*
+ Return true if the text is UTF-8 without null bytes, so that it can be
+ used without transcoding.
+ */
+static bool is_utf8(const char *p, int len)
+{
+  const char *e = p + len;
+  char multibyte[8];
+  while (p < e) {
+    unsigned char c = *p;
+    if (c && c < 0x80) {
+      p++;
+      continue;
+    }
+    if (!c)
+      return false;
+    int l = fl_utf8len1(*p), lp;
+    if (p + l > e)
+      return false;
+    unsigned u = fl_utf8decode(p, p + l, &lp);
+    if (lp != l || fl_utf8encode(u, multibyte) != l)
+      return false;
+    p += l;
+  }
+  return true;
+}
+
+
+/**
+ Loads a text file into the buffer without copying it.
+
+ The file is mapped into memory and the buffer uses the PIECE_TABLE
+ storage, whose pieces point into the mapping. The text is not copied
+ when it is edited: edits only add pieces around the parts of the file
+ that are still used. This makes loading large files, e.g. logs, fast and
+ keeps the memory of the text shared with the file system cache.
+
+ The file must be UTF-8 encoded without null bytes, which is checked
+ when it is mapped. If it is not, or if the system can't map it (e.g. on
+ Windows, or if it is not a regular file), this calls loadfile() instead,
+ still with the PIECE_TABLE storage. The undo information is cleared.
+
+ The file must not be changed while the buffer uses it, and the text must
+ not be changed through the address() of a position. On systems that map
+ the file, such as Linux and macOS, truncating the file while it is
+ mapped, e.g. by log rotation, raises SIGBUS when the buffer reads text
+ beyond the new end of the file. Rotate such files by renaming them.
+
+ \param file the UTF-8 encoded name of the file
+ \return the same values as insertfile()
+ \see storage(Storage)
+ */
+int Fl_Text_Buffer::mapfile(const char *file)
+{
+  size_t size = 0;
+  const char *addr = Fl::system_driver()->map_file(file, &size);
+  if (addr && (size > INT_MAX || !is_utf8(addr, (int) size))) {
+    Fl::system_driver()->unmap_file(addr, size);
+    addr = NULL;
+  }
+  if (!addr) {
+    storage(PIECE_TABLE);
+    int e = loadfile(file);
+    mUndo->clear();
+    return e;
+  }
+
+  select(0, length());
+  remove_selection();
+  storage(PIECE_TABLE);
+
+  call_predelete_callbacks(0, 0);
+  mPieces->insert_mapped(0, addr, size);
+  mLength = (int) size;
+  mLineIndex->insert(0, mLength);
+  update_selections(0, 0, mLength);
+  mUndo->clear();
+  input_file_was_transcoded = false;
+  mCursorPosHint = mLength;
+  call_modify_callbacks(0, 0, mLength, 0, NULL);
+  return 0;
+}
+
+
 /*
  Write text to file.
  Unicode safe.
@@ -133,11 +133,29 @@ Fl_Text_Display::Fl_Text_Display(int X, int Y, int W, int H, const char* l)
   mUnfinishedStyle = 0;
   mUnfinishedHighlightCB = 0;
   mHighlightCBArg = 0;
+  mRestyleCB = 0;
+  mRestyleCBArg = 0;
+  mRestyleChunk = 0;
+  mRestyleRanges = 0;
+  mNRestyleRanges = 0;
+  mRestyleRangesSize = 0;
+  mLineLayout = 0;
+  mNLayoutLines = 0;
+  mLayoutLinesSize = 0;
+  mLayoutMargin = 0;
+  mLayoutFont = 0;
+  mLayoutFontSize = 0;
+  mLayoutTabDistance = 0;
+  mLayoutScale = 0;
+  mLayoutFontGeneration = 0;
   mMaxsize = 0;
   mSuppressResync = 0;
   mNLinesDeleted = 0;
   mModifyingTabDistance = 0;    // XXX: UNUSED
   mColumnScale = 0;
+  mFixedFontWidth = -1;
+  mFixedFontDriver = 0;
+  mFixedFontGeneration = 0;
   mCursor_color = FL_FOREGROUND_COLOR;
 
   mHScrollBar = new Fl_Scrollbar(0,0,1,1);
@@ -198,11 +216,16 @@ Fl_Text_Display::~Fl_Text_Display() {
     Fl::remove_timeout(scroll_timer_cb, this);
     scroll_direction = 0;
   }
+  if (mRestyleRanges) {
+    Fl::remove_idle(restyle_idle_cb, this);
+    free(mRestyleRanges);
+  }
   if (mBuffer) {
     mBuffer->remove_modify_callback(buffer_modified_cb, this);
     mBuffer->remove_predelete_callback(buffer_predelete_cb, this);
   }
   if (mLineStarts) delete[] mLineStarts;
+  if (mLineLayout) free(mLineLayout);
   if (linenumber_format_) {
     free((void*)linenumber_format_);
     linenumber_format_ = 0;
@@ -354,6 +377,10 @@ void Fl_Text_Display::buffer( Fl_Text_Buffer *buf ) {
   if ( mBuffer != 0 ) {
     // we must provide a copy of the buffer that we are deleting!
     char *deletedText = mBuffer->text();
+    if (mContinuousWrap) {      // all lines are deleted
+      mNLinesDeleted = mNBufferLines;
+      mSuppressResync = 1;
+    }
     buffer_modified_cb( 0, 0, mBuffer->length(), 0, deletedText, this );
     free(deletedText);
     mNBufferLines = 0;
@@ -421,12 +448,245 @@ void Fl_Text_Display::highlight_data(Fl_Text_Buffer *styleBuffer,
   mUnfinishedHighlightCB = unfinishedHighlightCB;
   mHighlightCBArg = cbArg;
   mColumnScale = 0;
+  mFixedFontWidth = -1;
+  layout_clear();
 
   mStyleBuffer->canUndo(0);
   damage(FL_DAMAGE_EXPOSE);
 }
 
 
+// Replaces the styles from start to end with n bytes of style fill, or
+// removes the styles after start + n if n < end - start.
+static void replace_styles(Fl_Text_Buffer *styleBuffer, int start, int end,
+                           int n, char fill) {
+  if (n < 0) {
+    styleBuffer->remove(start + n, end);
+    return;
+  }
+  char *style = (char *)malloc(n + 1);
+  memset(style, fill ? fill : 'A', n);
+  style[n] = '\0';
+  styleBuffer->replace(start, end, style);
+  free(style);
+}
+
+
+/**
+ \brief Restyle the text in chunks from the idle loop.
+
+ Instead of restyling the whole text synchronously in a modify callback of
+ the text buffer, the display keeps track of the ranges of text that need
+ to be restyled. When the text is changed, the display inserts or removes
+ the same number of bytes in the style buffer and marks the changed lines
+ as dirty. Whenever FLTK is idle, it calls \p restyleCB for at most
+ \p chunkSize bytes of dirty text, starting with the dirty text that is
+ visible, and repaints the visible lines that were restyled. Typing thus
+ only restyles the lines near the cursor, and a large file is shown before
+ all of it is highlighted.
+
+ \p restyleCB(start, end, cbArg) must write the styles of the text from
+ \p start, which is always the start of a line, to at least \p end into
+ the style buffer, and return the position where it stopped, usually the
+ end of a line. If the style at that position depends on the new styles
+ (for instance, a comment was opened), the callback calls restyle() for
+ the following text, so that restyling continues until the styles no
+ longer change. The callback must not change the text buffer.
+
+ The style buffer and style table must be set with highlight_data(), and
+ the style buffer must not be changed by a modify callback of the text
+ buffer, since the display does that itself. Use \p unfinishedStyle as the
+ style of the inserted text that is not yet restyled, and pass NULL for the
+ unfinished highlight callback. All text is marked as dirty by this call.
+
+ Restyling runs in the main thread, because neither the buffers nor the
+ widgets may be used from other threads.
+
+ \param restyleCB restyles a part of the text, NULL turns incremental
+   highlighting off
+ \param cbArg the argument passed to \p restyleCB
+ \param chunkSize the number of bytes to restyle in one idle call
+
+ \see restyle(), restyle_pending()
+ */
+void Fl_Text_Display::highlight_incremental(Restyle_Cb restyleCB, void *cbArg,
+                                            int chunkSize) {
+  mRestyleCB = restyleCB;
+  mRestyleCBArg = cbArg;
+  mRestyleChunk = chunkSize > 0 ? chunkSize : 1;
+  mNRestyleRanges = 0;
+  if (!restyleCB || !mBuffer || !mStyleBuffer) {
+    Fl::remove_idle(restyle_idle_cb, this);
+    return;
+  }
+  int len = mBuffer->length();
+  if (mStyleBuffer->length() != len)
+    replace_styles(mStyleBuffer, mStyleBuffer->length(), mStyleBuffer->length(),
+                   len - mStyleBuffer->length(), mUnfinishedStyle);
+  restyle(0, len);
+}
+
+
+/**
+ \brief Mark a range of text to be restyled.
+
+ With incremental highlighting, the text from \p start to \p end will be
+ passed to the restyle callback the next time FLTK is idle.
+
+ \param start the start of the range
+ \param end the end of the range
+ \see highlight_incremental()
+ */
+void Fl_Text_Display::restyle(int start, int end) {
+  if (!mRestyleCB || !mBuffer) return;
+  if (start < 0) start = 0;
+  if (end > mBuffer->length()) end = mBuffer->length();
+  if (start >= end) return;
+  if (mNRestyleRanges + 1 > mRestyleRangesSize) {
+    mRestyleRangesSize = 2 * mRestyleRangesSize + 8;
+    mRestyleRanges = (int *)realloc(mRestyleRanges,
+                                    2 * mRestyleRangesSize * sizeof(int));
+  }
+  if (!Fl::has_idle(restyle_idle_cb, this))
+    Fl::add_idle(restyle_idle_cb, this);
+  // merge all ranges that overlap or touch start..end
+  int *r = mRestyleRanges, n = mNRestyleRanges;
+  int i = 0;
+  while (i < n && r[2 * i + 1] < start) i++;
+  int j = i;
+  for (; j < n && r[2 * j] <= end; j++) {
+    start = min(start, r[2 * j]);
+    end = max(end, r[2 * j + 1]);
+  }
+  memmove(r + 2 * i + 2, r + 2 * j, (n - j) * 2 * sizeof(int));
+  r[2 * i] = start;
+  r[2 * i + 1] = end;
+  mNRestyleRanges = n - (j - i) + 1;
+}
+
+
+/**
+ \brief Removes a range of text that was restyled from the dirty ranges.
+ \param start the start of the restyled text
+ \param end the end of the restyled text
+ */
+void Fl_Text_Display::restyled(int start, int end) {
+  int *r = mRestyleRanges, n = mNRestyleRanges, k = 0;
+  for (int i = 0; i < n; i++) {
+    int a = r[2 * i], b = r[2 * i + 1];
+    if (a < start && b > end) {
+      // split the range, it is the only one that overlaps start..end
+      if (n + 1 > mRestyleRangesSize) {
+        mRestyleRangesSize = 2 * mRestyleRangesSize + 8;
+        r = mRestyleRanges = (int *)realloc(mRestyleRanges,
+                                            2 * mRestyleRangesSize * sizeof(int));
+      }
+      memmove(r + 2 * i + 2, r + 2 * i, (n - i) * 2 * sizeof(int));
+      r[2 * i + 1] = start;
+      r[2 * i + 2] = end;
+      mNRestyleRanges = n + 1;
+      return;
+    }
+    if (b <= start || a >= end) {
+      r[2 * k] = a;
+      r[2 * k + 1] = b;
+      k++;
+      continue;
+    }
+    if (a < start) {
+      r[2 * k] = a;
+      r[2 * k + 1] = start;
+      k++;
+    } else if (b > end) {
+      r[2 * k] = end;
+      r[2 * k + 1] = b;
+      k++;
+    }
+  }
+  mNRestyleRanges = k;
+}
+
+
+/**
+ \brief Updates the style buffer and the dirty ranges after a text change.
+
+ Inserts or removes the same number of bytes in the style buffer unless
+ that was already done, for instance by another display that shares the
+ style buffer, moves the dirty ranges after the change, and marks the
+ changed lines as dirty.
+
+ \param pos the position of the change
+ \param nInserted the number of bytes inserted
+ \param nDeleted the number of bytes deleted
+ */
+void Fl_Text_Display::restyle_modified(int pos, int nInserted, int nDeleted) {
+  if (!mStyleBuffer) return;
+  int len = mBuffer->length(), styleLen = mStyleBuffer->length();
+  if (styleLen == len - nInserted + nDeleted) {
+    replace_styles(mStyleBuffer, pos, pos + nDeleted, nInserted, mUnfinishedStyle);
+  } else if (styleLen != len) {
+    // a new text buffer was set
+    replace_styles(mStyleBuffer, styleLen, styleLen, len - styleLen, mUnfinishedStyle);
+    mNRestyleRanges = 0;
+    restyle(0, len);
+    return;
+  }
+  int *r = mRestyleRanges, n = mNRestyleRanges, k = 0;
+  for (int i = 0; i < n; i++) {
+    int a = r[2 * i], b = r[2 * i + 1];
+    if (a >= pos + nDeleted) a += nInserted - nDeleted; else if (a > pos) a = pos;
+    if (b >= pos + nDeleted) b += nInserted - nDeleted; else if (b > pos) b = pos;
+    if (a < b) {
+      r[2 * k] = a;
+      r[2 * k + 1] = b;
+      k++;
+    }
+  }
+  mNRestyleRanges = k;
+  restyle(mBuffer->line_start(pos),
+          min(len, mBuffer->line_end(pos + nInserted) + 1));
+}
+
+
+/**
+ \brief Restyles a chunk of the dirty text, starting with the visible text.
+ */
+void Fl_Text_Display::restyle_chunk() {
+  if (!mRestyleCB || !mBuffer || !mStyleBuffer)
+    mNRestyleRanges = 0;
+  int budget = mRestyleChunk;
+  while (mNRestyleRanges > 0 && budget > 0) {
+    int *r = mRestyleRanges, i;
+    for (i = 0; i < mNRestyleRanges; i++)
+      if (r[2 * i + 1] > mFirstChar && r[2 * i] <= mLastChar) break;
+    if (i == mNRestyleRanges) i = 0;
+    int start = mBuffer->line_start(r[2 * i]);
+    int end = min(r[2 * i + 1], r[2 * i] + budget);
+    if (mBuffer->utf8_align(end) < end)
+      end = mBuffer->next_char(mBuffer->utf8_align(end));
+    int stop = mRestyleCB(start, end, mRestyleCBArg);
+    stop = min(max(stop, end), mBuffer->length());
+    restyled(start, stop);
+    layout_invalidate(start, stop);
+    budget -= stop - start;
+    // repaint only the restyled lines that are visible
+    if (stop > mFirstChar && start <= mLastChar)
+      redisplay_range_(max(start, mFirstChar), min(stop, mLastChar));
+  }
+  if (mNRestyleRanges == 0)
+    Fl::remove_idle(restyle_idle_cb, this);
+}
+
+
+/**
+ \brief Idle callback of incremental highlighting.
+ \param cbArg the text display
+ */
+void Fl_Text_Display::restyle_idle_cb(void *cbArg) {
+  ((Fl_Text_Display *)cbArg)->restyle_chunk();
+}
+
+
 
 /**
  \brief Find the longest line of all visible lines.
@@ -464,6 +724,7 @@ void Fl_Text_Display::resize(int X, int Y, int W, int H) {
 
   Fl_Widget::resize(X,Y,W,H);
   mColumnScale = 0; // force recomputation of the width of a column when display is rescaled
+  mFixedFontWidth = -1;
   recalc_display();
 }
 
@@ -724,10 +985,35 @@ void Fl_Text_Display::draw_text( int left, int top, int width, int height ) {
 
  This function will trigger a damage event and later a redraw of parts of
  the widget.
+
+ Call this after changing the style buffer, so that the restyled lines
+ are measured again in continuous wrap mode.
  \param startpos index of first character needing redraw
  \param endpos index after last character needing redraw
  */
 void Fl_Text_Display::redisplay_range(int startpos, int endpos) {
+  /* the restyled text may have a different width, so forget its layout,
+   or all of it if the text was changed and this display not told yet */
+  if (mNLayoutLines && mBuffer) {
+    if (mNLayoutLines != mBuffer->count_lines(0, mBuffer->length()) + 1)
+      layout_clear();
+    else
+      layout_invalidate(min(startpos, mBuffer->length()),
+                        min(endpos, mBuffer->length()));
+  }
+  redisplay_range_(startpos, endpos);
+}
+
+
+/**
+ \brief Marks text from start to end as needing a redraw.
+
+ Same as redisplay_range(), but keeps the line layout, because the styles
+ did not change.
+ \param startpos index of first character needing redraw
+ \param endpos index after last character needing redraw
+ */
+void Fl_Text_Display::redisplay_range_(int startpos, int endpos) {
   IS_UTF8_ALIGNED2(buffer(), startpos)
   IS_UTF8_ALIGNED2(buffer(), endpos)
 
@@ -841,12 +1127,12 @@ void Fl_Text_Display::insert_position( int newPos ) {
   mCursorPreferredXPos = -1;
 
   /* erase the cursor at its previous position */
-  redisplay_range(buffer()->prev_char_clipped(mCursorPos), buffer()->next_char(mCursorPos));
+  redisplay_range_(buffer()->prev_char_clipped(mCursorPos), buffer()->next_char(mCursorPos));
 
   mCursorPos = newPos;
 
   /* draw cursor at its new position */
-  redisplay_range(buffer()->prev_char_clipped(mCursorPos), buffer()->next_char(mCursorPos));
+  redisplay_range_(buffer()->prev_char_clipped(mCursorPos), buffer()->next_char(mCursorPos));
 }
 
 
@@ -860,7 +1146,7 @@ void Fl_Text_Display::insert_position( int newPos ) {
 void Fl_Text_Display::show_cursor(int b) {
   mCursorOn = b;
   if (!buffer()) return;
-  redisplay_range(buffer()->prev_char_clipped(mCursorPos), buffer()->next_char(mCursorPos));
+  redisplay_range_(buffer()->prev_char_clipped(mCursorPos), buffer()->next_char(mCursorPos));
 }
 
 
@@ -916,6 +1202,7 @@ void Fl_Text_Display::wrap_mode(int wrap, int wrapMargin) {
     case WRAP_NONE:
       mWrapMarginPix = 0;
       mContinuousWrap = 0;
+      layout_clear();
       break;
     case WRAP_AT_COLUMN:
     default:
@@ -1411,6 +1698,30 @@ int Fl_Text_Display::count_lines(int startPos, int endPos,
   if (!mContinuousWrap)
     return buffer()->count_lines(startPos, endPos);
 
+  /* Lines of the buffer that are completely inside the range are counted
+   with the line layout, so that only the first and the last line need to
+   be measured, if at all */
+  Fl_Text_Buffer *buf = buffer();
+  int lineEnd = buf->line_end(startPos);
+  if (endPos > lineEnd) {
+    layout_check();
+    int line = buf->count_lines(0, startPos);
+    int lastLine = line + buf->count_lines(startPos, endPos);
+    int lastStart = buf->line_start(endPos);
+    int n;
+    if (startPos == 0 || buf->byte_at(startPos - 1) == '\n')
+      n = layout_wraps(line, startPos);
+    else
+      n = count_lines(startPos, lineEnd, startPosIsLineStart);
+    for (line++; line < lastLine; line++)
+      n += layout_wraps(line, -1) + 1;
+    if (endPos < buf->length() && buf->byte_at(endPos) == '\n')
+      n += layout_wraps(lastLine, lastStart) + 1;
+    else
+      n += count_lines(lastStart, endPos, true) + 1;
+    return n;
+  }
+
   wrapped_line_counter(buffer(), startPos, endPos, INT_MAX,
                        startPosIsLineStart, 0, &retPos, &retLines, &retLineStart,
                        &retLineEnd);
@@ -1453,6 +1764,32 @@ int Fl_Text_Display::skip_lines(int startPos, int nLines,
   if (nLines == 0)
     return startPos;
 
+  /* Skip whole lines of the buffer with the line layout, and measure only
+   the line where skipping ends */
+  Fl_Text_Buffer *buf = buffer();
+  int lineEnd = buf->line_end(startPos);
+  if (lineEnd < buf->length()) {
+    layout_check();
+    int line = buf->count_lines(0, startPos);
+    int n;
+    if (startPos == 0 || buf->byte_at(startPos - 1) == '\n')
+      n = layout_wraps(line, startPos);
+    else
+      n = count_lines(startPos, lineEnd, startPosIsLineStart);
+    if (nLines > n) {
+      nLines -= n + 1;
+      for (line++; nLines > 0 && line < mNLayoutLines - 1; line++) {
+        n = layout_wraps(line, -1);
+        if (nLines <= n) break;
+        nLines -= n + 1;
+      }
+      startPos = buf->skip_lines(0, line);
+      if (nLines == 0)
+        return startPos;
+      startPosIsLineStart = true;
+    }
+  }
+
   /* use the common line counting routine to count forward */
   wrapped_line_counter(buffer(), startPos, buffer()->length(),
                        nLines, startPosIsLineStart, 0,
@@ -1556,11 +1893,17 @@ int Fl_Text_Display::rewind_lines(int startPos, int nLines) {
   if (!mContinuousWrap)
     return buf->rewind_lines(startPos, nLines);
 
+  /* whole lines before the first one are counted with the line layout */
+  layout_check();
+  int line = buf->count_lines(0, startPos);
   pos = startPos;
-  for (;;) {
+  for (;; line--) {
     lineStart = buf->line_start(pos);
-    wrapped_line_counter(buf, lineStart, pos, INT_MAX, true, 0,
-                         &retPos, &retLines, &retLineStart, &retLineEnd, false);
+    if (pos == startPos)
+      wrapped_line_counter(buf, lineStart, pos, INT_MAX, true, 0,
+                           &retPos, &retLines, &retLineStart, &retLineEnd, false);
+    else
+      retLines = layout_wraps(line, lineStart);
     if (retLines > nLines)
       return skip_lines(lineStart, retLines-nLines, true);
     nLines -= retLines;
@@ -1683,9 +2026,21 @@ void Fl_Text_Display::buffer_modified_cb( int pos, int nInserted, int nDeleted,
   if ( nInserted != 0 || nDeleted != 0 )
     textD->mCursorPreferredXPos = -1;
 
+  /* forget the layout of the changed lines */
+  if (textD->mNLayoutLines && (nInserted != 0 || nDeleted != 0))
+    textD->layout_modified(pos, nInserted, nDeleted, deletedText);
+
+  /* In continuous wrap mode, the pre-delete callback measured the lines
+   of the old text. If it was not called, e.g. for a transaction of the
+   buffer, the old lines can't be measured anymore: count all lines */
+  bool resync = textD->mContinuousWrap && !textD->mSuppressResync &&
+                (nInserted != 0 || nDeleted != 0);
+
   /* Count the number of lines inserted and deleted, and in the case
    of continuous wrap mode, how much has changed */
-  if (textD->mContinuousWrap) {
+  if (resync) {
+    linesInserted = linesDeleted = 0;
+  } else if (textD->mContinuousWrap) {
     textD->find_wrap_range(deletedText, pos, nInserted, nDeleted,
                            &wrapModStart, &wrapModEnd, &linesInserted, &linesDeleted);
   } else {
@@ -1695,7 +2050,10 @@ void Fl_Text_Display::buffer_modified_cb( int pos, int nInserted, int nDeleted,
 
   /* Update the line starts and mTopLineNum */
   if ( nInserted != 0 || nDeleted != 0 ) {
-    if (textD->mContinuousWrap) {
+    if (resync) {
+      textD->resync_wrapped_lines(pos, nInserted, nDeleted);
+      scrolled = 1;
+    } else if (textD->mContinuousWrap) {
       textD->update_line_starts( wrapModStart, wrapModEnd-wrapModStart,
                                 nDeleted + pos-wrapModStart + (wrapModEnd-(pos+nInserted)),
                                 linesInserted, linesDeleted, &scrolled );
@@ -1731,6 +2089,9 @@ void Fl_Text_Display::buffer_modified_cb( int pos, int nInserted, int nDeleted,
       textD->mCursorPos += nInserted - nDeleted;
   }
 
+  if (textD->mRestyleCB && (nInserted != 0 || nDeleted != 0))
+    textD->restyle_modified(pos, nInserted, nDeleted);
+
   // refigure scrollbars & stuff
   textD->resize(textD->x(), textD->y(), textD->w(), textD->h());
 
@@ -1800,7 +2161,7 @@ void Fl_Text_Display::buffer_modified_cb( int pos, int nInserted, int nDeleted,
   IS_UTF8_ALIGNED2(buf, endDispPos)
 
   /* Redisplay computed range */
-  textD->redisplay_range( startDispPos, endDispPos );
+  textD->redisplay_range_( startDispPos, endDispPos );
 }
 
 
@@ -2171,9 +2532,11 @@ int Fl_Text_Display::find_x(const char *s, int len, int style, int x) const {
   // TODO: use binary search which may be quicker.
   int i = 0;
   int last_w = 0;       // STR #2788
+  double fixed = fixed_font_width(); // ASCII text in monospace fonts
   while (i<len) {
     int cl = fl_utf8len1(s[i]);
-    int w = int( string_width(s, i+cl, style) );
+    if (s[i] < ' ' || s[i] > '~') fixed = 0;
+    int w = fixed > 0 ? int((i+cl) * fixed) : int( string_width(s, i+cl, style) );
     if (w>x) {
       if (cursor_pos && (w-x < x-last_w)) return i+cl; // STR #2788
       return i;
@@ -2525,6 +2888,68 @@ int Fl_Text_Display::position_style( int lineStartPos, int lineLen, int lineInde
 }
 
 
+/*
+ Advances of the printable ASCII characters of the fonts used recently,
+ so that measuring text character by character, as wrapping does, does not
+ ask the graphics driver for every character. The advances depend on the
+ graphics driver and its scale factor as well as on the font and size, and
+ they are dropped when Fl::set_font() changes a face.
+ */
+#define GLYPH_CACHE_SIZE 8
+
+struct Glyph_Advances {
+  unsigned driver;      // serial() of the graphics driver, 0 if unused
+  unsigned generation;  // Fl_Graphics_Driver::font_generation()
+  float scale;
+  Fl_Font font;
+  Fl_Fontsize size;
+  double advance[128];  // width of each ASCII character, -1 if not printable
+  double fixed;         // width of all printable characters, 0 if they differ
+};
+
+static Glyph_Advances glyph_cache[GLYPH_CACHE_SIZE];
+static int glyph_cache_next = 0;
+
+static const Glyph_Advances *glyph_advances(Fl_Font font, Fl_Fontsize size) {
+  unsigned driver = fl_graphics_driver->serial();
+  unsigned generation = Fl_Graphics_Driver::font_generation();
+  float scale = fl_graphics_driver->scale();
+  int i;
+  for (i = 0; i < GLYPH_CACHE_SIZE; i++) {
+    const Glyph_Advances &g = glyph_cache[i];
+    if (g.driver == driver && g.generation == generation &&
+        g.font == font && g.size == size && g.scale == scale)
+      return &g;
+  }
+  Glyph_Advances &g = glyph_cache[glyph_cache_next];
+  glyph_cache_next = (glyph_cache_next + 1) % GLYPH_CACHE_SIZE;
+  g.driver = driver;
+  g.generation = generation;
+  g.scale = scale;
+  g.font = font;
+  g.size = size;
+  fl_font(font, size);
+  for (i = 0; i < 128; i++) {
+    char c = (char)i;
+    g.advance[i] = (i < ' ' || i > '~') ? -1 : fl_width(&c, 1);
+  }
+  g.fixed = g.advance[(int)'M'];
+  for (i = ' '; i <= '~'; i++)
+    if (g.advance[i] != g.fixed) {
+      g.fixed = 0;
+      break;
+    }
+  return &g;
+}
+
+static bool is_printable_ascii(const char *s, int n) {
+  for (int i = 0; i < n; i++)
+    if (s[i] < ' ' || s[i] > '~')
+      return false;
+  return true;
+}
+
+
 /**
  \brief Find the width of a string in the font of a particular style.
 
@@ -2539,6 +2964,11 @@ double Fl_Text_Display::string_width( const char *string, int length, int style
   Fl_Font font;
   Fl_Fontsize fsize;
 
+  /* monospace fonts: ASCII text is measured without looking up the style */
+  double fixed = fixed_font_width();
+  if (fixed > 0 && is_printable_ascii(string, length))
+    return length * fixed;
+
   if ( mNStyles && (style & STYLE_LOOKUP_MASK) ) {
     int si = (style & STYLE_LOOKUP_MASK) - 'A';
     if (si < 0) si = 0;
@@ -2550,11 +2980,42 @@ double Fl_Text_Display::string_width( const char *string, int length, int style
     font  = textfont();
     fsize = textsize();
   }
+  const Glyph_Advances *g = glyph_advances(font, fsize);
+  unsigned char c = (unsigned char)*string;
+  if (length == 1 && c < 128 && g->advance[c] >= 0)
+    return g->advance[c];
+  if (g->fixed > 0 && is_printable_ascii(string, length))
+    return length * g->fixed;
   fl_font( font, fsize );
   return fl_width( string, length );
 }
 
 
+/**
+ \brief Returns the width of a character if all fonts are monospace.
+
+ If the text font and all fonts of the style table are monospace fonts
+ with the same width, positions and columns of ASCII text can be
+ calculated without measuring the text.
+
+ \return the width of every printable ASCII character in pixels, or 0
+   if the fonts differ in width
+ */
+double Fl_Text_Display::fixed_font_width() const {
+  if (mFixedFontWidth < 0 || mFixedFontDriver != fl_graphics_driver->serial() ||
+      mFixedFontGeneration != Fl_Graphics_Driver::font_generation()) {
+    double fixed = glyph_advances(textfont(), textsize())->fixed;
+    for (int i = 0; i < mNStyles && fixed > 0; i++)
+      if (glyph_advances(mStyleTable[i].font, mStyleTable[i].size)->fixed != fixed)
+        fixed = 0;
+    mFixedFontWidth = fixed;
+    mFixedFontDriver = fl_graphics_driver->serial();
+    mFixedFontGeneration = Fl_Graphics_Driver::font_generation();
+  }
+  return mFixedFontWidth;
+}
+
+
 
 /**
  \brief Translate a pixel position into a character index.
@@ -3397,6 +3858,33 @@ void Fl_Text_Display::measure_deleted_lines(int pos, int nDeleted) {
 }
 
 
+/**
+ \brief Recalculates the lines after a change of the text in continuous wrap mode.
+
+ This is used instead of find_wrap_range() and update_line_starts() if the
+ lines of the deleted text were not measured before the change, e.g. at
+ the end of a transaction of the buffer. All lines are counted again, with
+ the line layout this measures only the changed lines.
+
+ \param pos start of the change
+ \param nInserted number of bytes inserted
+ \param nDeleted number of bytes deleted
+ */
+void Fl_Text_Display::resync_wrapped_lines(int pos, int nInserted, int nDeleted) {
+  if (mFirstChar > pos) {
+    if (mFirstChar >= pos + nDeleted)
+      mFirstChar += nInserted - nDeleted;
+    else
+      mFirstChar = pos;
+  }
+  mNBufferLines = count_lines(0, buffer()->length(), true);
+  mFirstChar = line_start(mFirstChar);
+  mTopLineNum = count_lines(0, mFirstChar, true) + 1;
+  calc_line_starts(0, mNVisibleLines);
+  calc_last_char();
+}
+
+
 /**
  \brief Wrapping calculations.
 
@@ -3587,6 +4075,160 @@ double Fl_Text_Display::measure_proportional_character(const char *s, int xPix,
 }
 
 
+/**
+ \brief Makes the line layout match the buffer and the current wrap margin.
+
+ The layout is cleared if the number of lines of the buffer, the text font,
+ the tab distance or the scale factor changed, or if Fl::set_font() changed
+ a face. If only the wrap margin changed, lines
+ that are narrower than the new margin are known not to wrap, and the
+ others need to be measured again.
+ */
+void Fl_Text_Display::layout_check() const {
+  int margin = mWrapMarginPix != 0 ? mWrapMarginPix : text_area.w;
+  int nLines = mBuffer->count_lines(0, mBuffer->length()) + 1;
+  if (nLines != mNLayoutLines || textfont() != mLayoutFont ||
+      textsize() != mLayoutFontSize ||
+      mBuffer->tab_distance() != mLayoutTabDistance ||
+      fl_graphics_driver->scale() != mLayoutScale ||
+      Fl_Graphics_Driver::font_generation() != mLayoutFontGeneration) {
+    if (nLines > mLayoutLinesSize) {
+      mLayoutLinesSize = nLines;
+      if (mLineLayout) free(mLineLayout);
+      mLineLayout = (int *)malloc(2 * nLines * sizeof(int));
+    }
+    memset(mLineLayout, 0xff, 2 * nLines * sizeof(int));
+    mNLayoutLines = nLines;
+    mLayoutFont = textfont();
+    mLayoutFontSize = textsize();
+    mLayoutTabDistance = mBuffer->tab_distance();
+    mLayoutScale = fl_graphics_driver->scale();
+    mLayoutFontGeneration = Fl_Graphics_Driver::font_generation();
+    mLayoutMargin = margin;
+  } else if (margin != mLayoutMargin) {
+    for (int i = 0; i < mNLayoutLines; i++) {
+      int width = mLineLayout[2 * i];
+      mLineLayout[2 * i + 1] = (width >= 0 && width <= margin) ? 0 : -1;
+    }
+    mLayoutMargin = margin;
+  }
+}
+
+
+/**
+ \brief Returns the number of times a line of the buffer wraps.
+
+ The line is measured if it is not in the line layout yet. Call
+ layout_check() before.
+
+ \param line the line number, starting at 0
+ \param lineStart the position of the start of the line, or -1 if
+   it is not known
+ \return the number of wrapped lines after the first one
+ */
+int Fl_Text_Display::layout_wraps(int line, int lineStart) const {
+  int *layout = mLineLayout + 2 * line;
+  if (layout[1] >= 0)
+    return layout[1];
+
+  Fl_Text_Buffer *buf = mBuffer;
+  if (lineStart < 0)
+    lineStart = buf->skip_lines(0, line);
+  int lineEnd = buf->line_end(lineStart);
+  int width = layout[0], wraps;
+  if (width < 0) {
+    // measure the line the same way as wrapped_line_counter()
+    double w = 0;
+    for (int p = lineStart; p < lineEnd; p = buf->next_char(p))
+      w += measure_proportional_character(buf->address(p), (int)w, p);
+    width = w < INT_MAX ? (int)w : INT_MAX;
+    if (width < w) width++;
+  }
+  if (width <= mLayoutMargin) {
+    wraps = 0;
+  } else {
+    int retPos, retLines, retLineStart, retLineEnd;
+    wrapped_line_counter(buf, lineStart, lineEnd, INT_MAX, true, 0,
+                         &retPos, &retLines, &retLineStart, &retLineEnd, false);
+    wraps = retLines;
+  }
+  // While the text was changed and the style buffer was not yet, the line
+  // is measured with the wrong styles: don't keep that
+  if (!mStyleBuffer || !mNStyles || mStyleBuffer->length() == buf->length()) {
+    layout[0] = width;
+    layout[1] = wraps;
+  }
+  return wraps;
+}
+
+
+/**
+ \brief Updates the line layout after the text was changed.
+
+ The layout of the changed lines is removed, and the layout of the lines
+ after the change is kept.
+
+ \param pos index of the change
+ \param nInserted number of bytes inserted
+ \param nDeleted number of bytes deleted
+ \param deletedText the deleted text
+ */
+void Fl_Text_Display::layout_modified(int pos, int nInserted, int nDeleted,
+                                      const char *deletedText) {
+  if (nDeleted && !deletedText) {
+    layout_clear();
+    return;
+  }
+  int line = mBuffer->count_lines(0, pos);
+  int inserted = mBuffer->count_lines(pos, pos + nInserted);
+  int deleted = nDeleted ? countlines(deletedText) : 0;
+  if (line + deleted >= mNLayoutLines) {
+    layout_clear();
+    return;
+  }
+  if (mNLayoutLines + inserted - deleted > mLayoutLinesSize) {
+    mLayoutLinesSize = 2 * (mNLayoutLines + inserted - deleted);
+    mLineLayout = (int *)realloc(mLineLayout, 2 * mLayoutLinesSize * sizeof(int));
+  }
+  memmove(mLineLayout + 2 * (line + inserted + 1),
+          mLineLayout + 2 * (line + deleted + 1),
+          2 * (mNLayoutLines - line - deleted - 1) * sizeof(int));
+  memset(mLineLayout + 2 * line, 0xff, 2 * (inserted + 1) * sizeof(int));
+  mNLayoutLines += inserted - deleted;
+}
+
+
+/**
+ \brief Removes the layout of the lines from start to end.
+
+ This is needed when the styles of the text changed.
+
+ \param start, end range of text
+ */
+void Fl_Text_Display::layout_invalidate(int start, int end) {
+  if (!mNLayoutLines)
+    return;
+  int line = mBuffer->count_lines(0, start);
+  int last = line + mBuffer->count_lines(start, end);
+  if (last >= mNLayoutLines) {
+    layout_clear();
+    return;
+  }
+  memset(mLineLayout + 2 * line, 0xff, 2 * (last - line + 1) * sizeof(int));
+}
+
+
+/**
+ \brief Removes the layout of all lines.
+ */
+void Fl_Text_Display::layout_clear() {
+  if (mLineLayout) free(mLineLayout);
+  mLineLayout = 0;
+  mNLayoutLines = 0;
+  mLayoutLinesSize = 0;
+}
+
+
 /**
  \brief Finds both the end of the current line and the start of the next line.
 
@@ -3619,6 +4261,18 @@ void Fl_Text_Display::find_line_end(int startPos, bool startPosIsLineStart,
     return;
   }
 
+  /* lines of the buffer that do not wrap need not be measured */
+  Fl_Text_Buffer *buf = buffer();
+  if (startPos == 0 || buf->byte_at(startPos - 1) == '\n') {
+    layout_check();
+    if (layout_wraps(buf->count_lines(0, startPos), startPos) == 0) {
+      int le = buf->line_end(startPos);
+      *lineEnd = le;
+      *nextLineStart = min(buf->length(), buf->next_char(le));
+      return;
+    }
+  }
+
   /* use the wrapped line counter routine to count forward one line */
   wrapped_line_counter(buffer(), startPos, buffer()->length(),
                        1, startPosIsLineStart, 0, nextLineStart, &retLines,
@@ -4091,17 +4745,17 @@ int Fl_Text_Display::handle(int event) {
       if (buffer()->selected()) {
         int start, end;
         if (buffer()->selection_position(&start, &end))
-          redisplay_range(start, end);
+          redisplay_range_(start, end);
       }
       if (buffer()->secondary_selected()) {
         int start, end;
         if (buffer()->secondary_selection_position(&start, &end))
-          redisplay_range(start, end);
+          redisplay_range_(start, end);
       }
       if (buffer()->highlight()) {
         int start, end;
         if (buffer()->highlight_position(&start, &end))
-          redisplay_range(start, end);
+          redisplay_range_(start, end);
       }
       return 1;
 
@@ -0,0 +1,231 @@
+//
+// Internal line index of Fl_Text_Buffer for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Text_Line_Index.h"
+#include <FL/Fl_Text_Buffer.H>
+
+// Inserted text is divided into segments of this size. Small edits change
+// the size of a segment in place as long as it stays below twice this.
+#define SEGMENT_SIZE 4096
+
+Fl_Text_Line_Index::Fl_Text_Line_Index(const Fl_Text_Buffer *buf)
+: buf_(buf), root_(0), seed_(2463534242U)
+{
+}
+
+Fl_Text_Line_Index::~Fl_Text_Line_Index() {
+  clear();
+}
+
+void Fl_Text_Line_Index::free_tree(Node *n) {
+  while (n) {
+    free_tree(n->left);
+    Node *r = n->right;
+    delete n;
+    n = r;
+  }
+}
+
+void Fl_Text_Line_Index::clear() {
+  free_tree(root_);
+  root_ = 0;
+}
+
+// xorshift random number generator for the node priorities
+unsigned Fl_Text_Line_Index::random() {
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 17;
+  seed_ ^= seed_ << 5;
+  return seed_;
+}
+
+Fl_Text_Line_Index::Node *Fl_Text_Line_Index::new_node(int len, int nl, unsigned prio) {
+  Node *n = new Node;
+  n->len = n->size = len;
+  n->nl = n->lines = nl;
+  n->prio = prio;
+  n->left = n->right = 0;
+  return n;
+}
+
+// Returns the number of newlines between start and end in the buffer.
+int Fl_Text_Line_Index::count(int start, int end) const {
+  return buf_->count_lines_(start, end);
+}
+
+// Splits the tree t, which starts at position base, into the segments
+// before pos and the segments after pos. A segment that contains pos is
+// split in two.
+void Fl_Text_Line_Index::split(Node *t, int base, int pos, Node *&l, Node *&r) {
+  if (!t) {
+    l = r = 0;
+    return;
+  }
+  int ls = size(t->left);
+  if (pos <= base + ls) {
+    split(t->left, base, pos, l, t->left);
+    update(t);
+    r = t;
+  } else if (pos >= base + ls + t->len) {
+    split(t->right, base + ls + t->len, pos, t->right, r);
+    update(t);
+    l = t;
+  } else {
+    // the tail of the segment takes the priority of t, which is greater
+    // than that of all nodes of the right subtree
+    int k = pos - base - ls;
+    int nl = count(base + ls, pos);
+    Node *n = new_node(t->len - k, t->nl - nl, t->prio);
+    t->len = k;
+    t->nl = nl;
+    n->right = t->right;
+    t->right = 0;
+    update(n);
+    update(t);
+    l = t;
+    r = n;
+  }
+}
+
+// Joins two trees, all segments of l are before those of r.
+Fl_Text_Line_Index::Node *Fl_Text_Line_Index::merge(Node *l, Node *r) {
+  if (!l) return r;
+  if (!r) return l;
+  if (l->prio > r->prio) {
+    l->right = merge(l->right, r);
+    update(l);
+    return l;
+  }
+  r->left = merge(l, r->left);
+  update(r);
+  return r;
+}
+
+// Returns the segment that contains pos and its position in start, or
+// NULL if pos is not in the text.
+Fl_Text_Line_Index::Node *Fl_Text_Line_Index::find(int pos, int &start) const {
+  Node *t = root_;
+  int base = 0;
+  while (t) {
+    int ls = size(t->left);
+    if (pos < base + ls) {
+      t = t->left;
+    } else if (pos < base + ls + t->len) {
+      start = base + ls;
+      return t;
+    } else {
+      base += ls + t->len;
+      t = t->right;
+    }
+  }
+  return 0;
+}
+
+// Adds len bytes and nl newlines to the segment that contains pos.
+void Fl_Text_Line_Index::grow(int pos, int len, int nl) {
+  for (Node *t = root_; ; ) {
+    t->size += len;
+    t->lines += nl;
+    int ls = size(t->left);
+    if (pos < ls) {
+      t = t->left;
+    } else if (pos < ls + t->len) {
+      t->len += len;
+      t->nl += nl;
+      return;
+    } else {
+      pos -= ls + t->len;
+      t = t->right;
+    }
+  }
+}
+
+// Adds the segments for the len bytes at pos, which were just inserted
+// into the buffer.
+void Fl_Text_Line_Index::insert(int pos, int len) {
+  if (len <= 0) return;
+  // typing: add the text to the segment before it
+  if (root_ && len <= SEGMENT_SIZE) {
+    int start;
+    Node *n = find(pos > 0 ? pos - 1 : 0, start);
+    if (n->len + len < 2 * SEGMENT_SIZE) {
+      grow(start, len, count(pos, pos + len));
+      return;
+    }
+  }
+  Node *l, *r;
+  split(root_, 0, pos, l, r);
+  for (int end = pos + len; pos < end; pos += SEGMENT_SIZE) {
+    int k = end - pos < SEGMENT_SIZE ? end - pos : SEGMENT_SIZE;
+    l = merge(l, new_node(k, count(pos, pos + k), random()));
+  }
+  root_ = merge(l, r);
+}
+
+// Removes the bytes between start and end, which are about to be removed
+// from the buffer.
+void Fl_Text_Line_Index::remove(int start, int end) {
+  if (start >= end) return;
+  int s;
+  Node *n = find(start, s);
+  if (n && end < s + n->len) {
+    grow(s, start - end, -count(start, end));
+    return;
+  }
+  Node *l, *m, *r;
+  split(root_, 0, start, l, m);
+  split(m, start, end, m, r);
+  free_tree(m);
+  root_ = merge(l, r);
+}
+
+int Fl_Text_Line_Index::line(int pos) const {
+  const Node *t = root_;
+  int base = 0, nl = 0;
+  while (t) {
+    int ls = size(t->left);
+    if (pos < base + ls) {
+      t = t->left;
+    } else if (pos < base + ls + t->len) {
+      return nl + lines(t->left) + count(base + ls, pos);
+    } else {
+      base += ls + t->len;
+      nl += lines(t->left) + t->nl;
+      t = t->right;
+    }
+  }
+  return nl;
+}
+
+int Fl_Text_Line_Index::position(int n) const {
+  const Node *t = root_;
+  int base = 0;
+  while (t) {
+    int ls = size(t->left);
+    if (n <= lines(t->left)) {
+      t = t->left;
+    } else if (n <= lines(t->left) + t->nl) {
+      int found;
+      return buf_->skip_lines_(base + ls, base + ls + t->len,
+                               n - lines(t->left), &found);
+    } else {
+      n -= lines(t->left) + t->nl;
+      base += ls + t->len;
+      t = t->right;
+    }
+  }
+  return size(root_);
+}
@@ -0,0 +1,86 @@
+//
+// Internal line index of Fl_Text_Buffer for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/*
+  This internal (undocumented) class counts the newlines of the text of an
+  Fl_Text_Buffer, so that the buffer can find the line number of a
+  position and the position of a line number without scanning the text
+  from the start.
+
+  The text is divided into segments of at most a few kilobytes, which
+  may start and end anywhere, even inside a UTF-8 character. Every
+  segment knows its number of bytes and newlines. The segments are the
+  nodes of a treap ordered by their position in the text, like the pieces
+  of Fl_Text_Piece_Table, and every node knows the bytes and newlines of
+  its subtree. A query finds the segment in O(log n) and then scans at
+  most one segment of the text.
+
+  The buffer calls insert() after text was inserted, and remove() before
+  text is removed, because both scan the text around the change.
+*/
+
+#ifndef FL_TEXT_LINE_INDEX_H
+#define FL_TEXT_LINE_INDEX_H
+
+class Fl_Text_Buffer;
+
+class Fl_Text_Line_Index {
+
+  struct Node {
+    int len;                  // number of bytes of this segment
+    int nl;                   // number of newlines of this segment
+    int size;                 // number of bytes of this subtree
+    int lines;                // number of newlines of this subtree
+    unsigned prio;            // treap priority, greater than that of the children
+    Node *left, *right;
+  };
+
+  const Fl_Text_Buffer *buf_;
+  Node *root_;
+  unsigned seed_;             // state of the random number generator
+
+  static int size(const Node *n) { return n ? n->size : 0; }
+  static int lines(const Node *n) { return n ? n->lines : 0; }
+  static void update(Node *n) {
+    n->size = n->len + size(n->left) + size(n->right);
+    n->lines = n->nl + lines(n->left) + lines(n->right);
+  }
+  static void free_tree(Node *n);
+  Node *new_node(int len, int nl, unsigned prio);
+  unsigned random();
+  int count(int start, int end) const;
+  void split(Node *t, int base, int pos, Node *&l, Node *&r);
+  Node *merge(Node *l, Node *r);
+  Node *find(int pos, int &start) const;
+  void grow(int pos, int len, int nl);
+
+public:
+  Fl_Text_Line_Index(const Fl_Text_Buffer *buf);
+  ~Fl_Text_Line_Index();
+
+  void clear();
+  void insert(int pos, int len);
+  void remove(int start, int end);
+
+  // Returns the number of newlines in the text.
+  int lines() const { return lines(root_); }
+  // Returns the number of newlines before pos.
+  int line(int pos) const;
+  // Returns the position after the n-th newline, 1 <= n <= lines().
+  int position(int n) const;
+};
+
+#endif // FL_TEXT_LINE_INDEX_H
@@ -0,0 +1,290 @@
+//
+// Internal piece table storage of Fl_Text_Buffer for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Text_Piece_Table.h"
+#include "Fl_System_Driver.H"
+#include <FL/Fl.H>
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the blocks that inserted text is appended to. Text that is
+// larger than half of this gets a block of its own.
+#define BLOCK_SIZE (64*1024)
+// compact() makes blocks of this size, and only runs if this many bytes
+// are unused
+#define COMPACT_SIZE (1024*1024)
+
+Fl_Text_Piece_Table::Fl_Text_Piece_Table()
+: root_(0), blocks_(0), mappings_(0), stored_(0), seed_(2463534242U), cache_(0), cache_start_(0)
+{
+}
+
+Fl_Text_Piece_Table::~Fl_Text_Piece_Table() {
+  clear();
+}
+
+void Fl_Text_Piece_Table::free_tree(Node *n) {
+  while (n) {
+    free_tree(n->left);
+    Node *r = n->right;
+    delete n;
+    n = r;
+  }
+}
+
+void Fl_Text_Piece_Table::clear() {
+  free_tree(root_);
+  root_ = 0;
+  while (blocks_) {
+    Block *b = blocks_->next;
+    free(blocks_);
+    blocks_ = b;
+  }
+  while (mappings_) {
+    Mapping *m = mappings_->next;
+    Fl::system_driver()->unmap_file(mappings_->addr, mappings_->size);
+    delete mappings_;
+    mappings_ = m;
+  }
+  stored_ = 0;
+  cache_ = 0;
+}
+
+// xorshift random number generator for the node priorities
+unsigned Fl_Text_Piece_Table::random() {
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 17;
+  seed_ ^= seed_ << 5;
+  return seed_;
+}
+
+Fl_Text_Piece_Table::Node *Fl_Text_Piece_Table::new_node(const char *text, int len, unsigned prio) {
+  Node *n = new Node;
+  n->text = text;
+  n->len = n->size = len;
+  n->prio = prio;
+  n->left = n->right = 0;
+  return n;
+}
+
+// Splits the tree t into the pieces before pos and the pieces after pos.
+// A piece that contains pos is split in two.
+void Fl_Text_Piece_Table::split(Node *t, int pos, Node *&l, Node *&r) {
+  if (!t) {
+    l = r = 0;
+    return;
+  }
+  int ls = size(t->left);
+  if (pos <= ls) {
+    split(t->left, pos, l, t->left);
+    update(t);
+    r = t;
+  } else if (pos >= ls + t->len) {
+    split(t->right, pos - ls - t->len, t->right, r);
+    update(t);
+    l = t;
+  } else {
+    // the tail of the piece takes the priority of t, which is greater
+    // than that of all nodes of the right subtree
+    int k = pos - ls;
+    Node *n = new_node(t->text + k, t->len - k, t->prio);
+    t->len = k;
+    n->right = t->right;
+    t->right = 0;
+    update(n);
+    update(t);
+    l = t;
+    r = n;
+  }
+}
+
+// Joins two trees, all pieces of l are before those of r.
+Fl_Text_Piece_Table::Node *Fl_Text_Piece_Table::merge(Node *l, Node *r) {
+  if (!l) return r;
+  if (!r) return l;
+  if (l->prio > r->prio) {
+    l->right = merge(l->right, r);
+    update(l);
+    return l;
+  }
+  r->left = merge(l, r->left);
+  update(r);
+  return r;
+}
+
+// Copies text into a block and returns the copy.
+const char *Fl_Text_Piece_Table::store(const char *text, int len) {
+  Block *b;
+  if (len > BLOCK_SIZE / 2) {
+    // keep the current block for small pieces
+    b = (Block*)malloc(sizeof(Block) + len);
+    b->size = len;
+    b->used = 0;
+    if (blocks_) {
+      b->next = blocks_->next;
+      blocks_->next = b;
+    } else {
+      b->next = 0;
+      blocks_ = b;
+    }
+  } else {
+    b = blocks_;
+    if (!b || b->size - b->used < len) {
+      b = (Block*)malloc(sizeof(Block) + BLOCK_SIZE);
+      b->size = BLOCK_SIZE;
+      b->used = 0;
+      b->next = blocks_;
+      blocks_ = b;
+    }
+  }
+  char *s = b->data + b->used;
+  memcpy(s, text, len);
+  b->used += len;
+  stored_ += len;
+  return s;
+}
+
+// Returns the piece that contains pos and its position in start, or NULL
+// if pos is not in the text.
+const Fl_Text_Piece_Table::Node *Fl_Text_Piece_Table::find(int pos, int &start) const {
+  const Node *t = root_;
+  int base = 0;
+  while (t) {
+    int ls = size(t->left);
+    if (pos < ls) {
+      t = t->left;
+    } else if (pos < ls + t->len) {
+      start = cache_start_ = base + ls;
+      cache_ = t;
+      return t;
+    } else {
+      pos -= ls + t->len;
+      base += ls + t->len;
+      t = t->right;
+    }
+  }
+  return 0;
+}
+
+const char *Fl_Text_Piece_Table::piece(int pos, int &start, int &len) const {
+  const Node *n = cache_;
+  if (n && pos >= cache_start_ && pos < cache_start_ + n->len)
+    start = cache_start_;
+  else
+    n = find(pos, start);
+  len = n->len;
+  return n->text;
+}
+
+void Fl_Text_Piece_Table::insert(int pos, const char *text, int len) {
+  if (len <= 0) return;
+  cache_ = 0;
+  // Text that is typed is inserted right after the previous insertion,
+  // which is at the end of the current block: extend that piece instead
+  // of adding a new one.
+  Block *b = blocks_;
+  if (pos > 0 && b && len <= BLOCK_SIZE / 2 && b->size - b->used >= len) {
+    int start;
+    const Node *n = find(pos - 1, start);
+    cache_ = 0;
+    if (start + n->len == pos && n->text + n->len == b->data + b->used) {
+      memcpy(b->data + b->used, text, len);
+      b->used += len;
+      stored_ += len;
+      int p = pos - 1;
+      for (Node *t = root_; ; ) { // grow all subtrees that contain the piece
+        t->size += len;
+        int ls = size(t->left);
+        if (p < ls) {
+          t = t->left;
+        } else if (p < ls + t->len) {
+          t->len += len;
+          break;
+        } else {
+          p -= ls + t->len;
+          t = t->right;
+        }
+      }
+      return;
+    }
+  }
+  const char *s = store(text, len);
+  Node *l, *r;
+  split(root_, pos, l, r);
+  root_ = merge(merge(l, new_node(s, len, random())), r);
+}
+
+void Fl_Text_Piece_Table::insert_mapped(int pos, const char *addr, size_t size) {
+  Mapping *m = new Mapping;
+  m->next = mappings_;
+  m->addr = addr;
+  m->size = size;
+  mappings_ = m;
+  cache_ = 0;
+  stored_ += (int)size;
+  Node *l, *r;
+  split(root_, pos, l, r);
+  root_ = merge(merge(l, new_node(addr, (int)size, random())), r);
+}
+
+void Fl_Text_Piece_Table::remove(int start, int end) {
+  if (start >= end) return;
+  cache_ = 0;
+  Node *l, *m, *r;
+  split(root_, start, l, m);
+  split(m, end - start, m, r);
+  free_tree(m);
+  root_ = merge(l, r);
+  int unused = stored_ - length();
+  if (unused > COMPACT_SIZE && unused > length())
+    compact();
+}
+
+void Fl_Text_Piece_Table::copy(int start, int end, char *dest) const {
+  while (start < end) {
+    int s, len;
+    const char *p = piece(start, s, len);
+    int n = (s + len < end ? s + len : end) - start;
+    memcpy(dest, p + start - s, n);
+    dest += n;
+    start += n;
+  }
+}
+
+// Copies the text into new blocks, and frees the old blocks and pieces.
+void Fl_Text_Piece_Table::compact() {
+  int n = length();
+  Node *root = 0;
+  Block *blocks = 0;
+  for (int pos = 0; pos < n; ) {
+    int k = n - pos < COMPACT_SIZE ? n - pos : COMPACT_SIZE;
+    // don't split a UTF-8 character between two pieces
+    int j = k;
+    while (j > 0 && pos + j < n && (byte_at(pos + j) & 0xc0) == 0x80) j--;
+    if (j > 0) k = j;
+    Block *b = (Block*)malloc(sizeof(Block) + k);
+    b->size = b->used = k;
+    b->next = blocks;
+    blocks = b;
+    copy(pos, pos + k, b->data);
+    root = merge(root, new_node(b->data, k, random()));
+    pos += k;
+  }
+  clear();
+  root_ = root;
+  blocks_ = blocks;
+  stored_ = n;
+}
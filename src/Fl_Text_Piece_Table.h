@@ -0,0 +1,117 @@
+//
+// Internal piece table storage of Fl_Text_Buffer for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/*
+  This internal (undocumented) class stores the text of an Fl_Text_Buffer
+  in the Fl_Text_Buffer::PIECE_TABLE storage mode.
+
+  The text is a sequence of pieces. Each piece points to a run of bytes in
+  one of the blocks of the table, which are never moved. Inserted text is
+  appended to the current block, or gets a block of its own if it is large.
+  Removing text only shortens or splits pieces, the bytes stay in their
+  block until compact() copies the text into new blocks, which happens
+  when more than half of the stored bytes are no longer used.
+
+  The pieces are the nodes of a treap (a binary search tree that is
+  balanced by random node priorities) ordered by their position in the
+  text, and every node knows the number of bytes in its subtree. This
+  makes insert(), remove() and finding the piece at a position O(log n)
+  in the number of pieces. The piece that was found last is cached, so
+  that reading the text byte by byte is fast.
+
+  A file that is mapped into memory with insert_mapped() is not copied:
+  its pieces point into the mapping, and edits only add new pieces around
+  them. The mapping is released by clear(), which compact() calls after
+  copying the text that is still used.
+
+  Positions are byte offsets. Pieces are only split at the positions that
+  are passed to insert() and remove(), so a UTF-8 character is never
+  split between pieces if these are at character boundaries.
+*/
+
+#ifndef FL_TEXT_PIECE_TABLE_H
+#define FL_TEXT_PIECE_TABLE_H
+
+#include <stddef.h>
+
+class Fl_Text_Piece_Table {
+
+  struct Node {
+    const char *text;         // the bytes of this piece
+    int len;                  // number of bytes of this piece
+    int size;                 // number of bytes of this subtree
+    unsigned prio;            // treap priority, greater than that of the children
+    Node *left, *right;
+  };
+
+  struct Block {
+    Block *next;              // the previously allocated block
+    int size, used;
+    char data[1];
+  };
+
+  struct Mapping {
+    Mapping *next;
+    const char *addr;
+    size_t size;
+  };
+
+  Node *root_;
+  Block *blocks_;             // the current block, which text is appended to
+  Mapping *mappings_;         // the mapped files
+  int stored_;                // bytes in all blocks and mappings, used or not
+  unsigned seed_;             // state of the random number generator
+  mutable const Node *cache_; // the piece that was found last, or NULL
+  mutable int cache_start_;   // the position of cache_
+
+  static int size(const Node *n) { return n ? n->size : 0; }
+  static void update(Node *n) { n->size = n->len + size(n->left) + size(n->right); }
+  static void free_tree(Node *n);
+  Node *new_node(const char *text, int len, unsigned prio);
+  unsigned random();
+  void split(Node *t, int pos, Node *&l, Node *&r);
+  Node *merge(Node *l, Node *r);
+  const char *store(const char *text, int len);
+  const Node *find(int pos, int &start) const;
+  void compact();
+
+public:
+  Fl_Text_Piece_Table();
+  ~Fl_Text_Piece_Table();
+
+  int length() const { return size(root_); }
+  void clear();
+  void insert(int pos, const char *text, int len);
+  // Inserts a file that was mapped with Fl_System_Driver::map_file(),
+  // the table unmaps it when it is no longer used.
+  void insert_mapped(int pos, const char *addr, size_t size);
+  void remove(int start, int end);
+  void copy(int start, int end, char *dest) const;
+
+  // Returns the piece that contains pos, 0 <= pos < length(): the bytes
+  // start .. start+len-1 of the text are at the returned address.
+  const char *piece(int pos, int &start, int &len) const;
+
+  // Returns the byte at pos, 0 <= pos < length().
+  char byte_at(int pos) const {
+    if (cache_ && pos >= cache_start_ && pos < cache_start_ + cache_->len)
+      return cache_->text[pos - cache_start_];
+    int start, len;
+    return piece(pos, start, len)[pos - start];
+  }
+};
+
+#endif // FL_TEXT_PIECE_TABLE_H
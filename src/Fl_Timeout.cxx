@@ -0,0 +1,269 @@
+//
+// Internal timeout queue for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Timeout.h"
+#include <FL/platform_types.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <time.h>
+#  include <sys/time.h>
+#endif
+
+// Entry states
+enum { FREE = 0, ACTIVE, CANCELLED };
+
+// An Fl_Timeout_Id stores (slot + 1) in the low bits and the slot's
+// generation in the high bits, so that stale ids are never mistaken for
+// a newer timeout that reuses the same slot. Id 0 is never used.
+#define ID_SLOT_BITS  20
+#define ID_SLOT_MASK  ((1U << ID_SLOT_BITS) - 1)
+#define ID_GEN_MASK   ((1U << (32 - ID_SLOT_BITS)) - 1)
+
+Fl_Timeout::Fl_Timeout()
+  : entry_(0)
+  , alloc_entry_(0)
+  , free_(-1)
+  , heap_(0)
+  , num_heap_(0)
+  , alloc_heap_(0)
+  , hash_(0)
+  , num_hash_(0)
+  , active_(0)
+  , seq_(0)
+{
+}
+
+Fl_Timeout::~Fl_Timeout() {
+  free(entry_);
+  free(heap_);
+  free(hash_);
+}
+
+double Fl_Timeout::now() {
+#ifdef _WIN32
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER count;
+  if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  return (double)count.QuadPart / (double)freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+#endif
+}
+
+unsigned int Fl_Timeout::hash(Fl_Timeout_Handler cb, void *data) const {
+  fl_uintptr_t h = (fl_uintptr_t)cb ^ ((fl_uintptr_t)data * 31);
+  h ^= h >> 16;
+  h *= 0x45d9f3b;
+  h ^= h >> 16;
+  return (unsigned int)h & (num_hash_ - 1);
+}
+
+void Fl_Timeout::sift_up(int pos) {
+  while (pos > 0) {
+    int parent = (pos - 1) / 2;
+    if (!less(pos, parent)) break;
+    int t = heap_[pos]; heap_[pos] = heap_[parent]; heap_[parent] = t;
+    pos = parent;
+  }
+}
+
+void Fl_Timeout::sift_down(int pos) {
+  for (;;) {
+    int child = 2 * pos + 1;
+    if (child >= num_heap_) break;
+    if (child + 1 < num_heap_ && less(child + 1, child)) child++;
+    if (!less(child, pos)) break;
+    int t = heap_[pos]; heap_[pos] = heap_[child]; heap_[child] = t;
+    pos = child;
+  }
+}
+
+void Fl_Timeout::hash_link(int slot) {
+  Entry &e = entry_[slot];
+  unsigned int h = hash(e.cb, e.data);
+  e.hprev = -1;
+  e.hnext = hash_[h];
+  if (e.hnext >= 0) entry_[e.hnext].hprev = slot;
+  hash_[h] = slot;
+}
+
+void Fl_Timeout::hash_unlink(int slot) {
+  Entry &e = entry_[slot];
+  if (e.hprev >= 0) entry_[e.hprev].hnext = e.hnext;
+  else hash_[hash(e.cb, e.data)] = e.hnext;
+  if (e.hnext >= 0) entry_[e.hnext].hprev = e.hprev;
+}
+
+void Fl_Timeout::rehash(int size) {
+  free(hash_);
+  num_hash_ = size;
+  hash_ = (int *)malloc(size * sizeof(int));
+  for (int i = 0; i < size; i++) hash_[i] = -1;
+  for (int i = 0; i < alloc_entry_; i++)
+    if (entry_[i].state == ACTIVE) hash_link(i);
+}
+
+int Fl_Timeout::new_slot() {
+  if (free_ < 0) {
+    int n = alloc_entry_ ? alloc_entry_ * 2 : 32;
+    entry_ = (Entry *)realloc(entry_, n * sizeof(Entry));
+    for (int i = n - 1; i >= alloc_entry_; i--) {
+      entry_[i].state = FREE;
+      entry_[i].gen = 0;
+      entry_[i].hnext = free_;
+      free_ = i;
+    }
+    alloc_entry_ = n;
+  }
+  int slot = free_;
+  free_ = entry_[slot].hnext;
+  return slot;
+}
+
+void Fl_Timeout::free_slot(int slot) {
+  Entry &e = entry_[slot];
+  e.state = FREE;
+  e.gen++;
+  e.hnext = free_;
+  free_ = slot;
+}
+
+Fl_Timeout_Id Fl_Timeout::add(double time, Fl_Timeout_Handler cb, void *data) {
+  if (active_ >= num_hash_) rehash(num_hash_ ? num_hash_ * 2 : 64);
+  int slot = new_slot();
+  Entry &e = entry_[slot];
+  e.time = time;
+  e.seq = seq_++;
+  e.cb = cb;
+  e.data = data;
+  e.state = ACTIVE;
+  hash_link(slot);
+  if (num_heap_ >= alloc_heap_) {
+    alloc_heap_ = alloc_heap_ ? alloc_heap_ * 2 : 32;
+    heap_ = (int *)realloc(heap_, alloc_heap_ * sizeof(int));
+  }
+  heap_[num_heap_] = slot;
+  sift_up(num_heap_++);
+  active_++;
+  if ((unsigned)slot >= ID_SLOT_MASK) return 0; // can't be represented
+  return ((e.gen & ID_GEN_MASK) << ID_SLOT_BITS) | (unsigned)(slot + 1);
+}
+
+// Mark a timeout as cancelled. It stays in the heap until it reaches the
+// top or until more than half of the heap consists of cancelled entries.
+void Fl_Timeout::cancel(int slot) {
+  Entry &e = entry_[slot];
+  hash_unlink(slot);
+  e.state = CANCELLED;
+  e.cb = 0;
+  active_--;
+  if (num_heap_ > 32 && num_heap_ - active_ > num_heap_ / 2) compact();
+}
+
+// Remove cancelled entries from the top of the heap.
+void Fl_Timeout::pop_cancelled() {
+  while (num_heap_ > 0 && entry_[heap_[0]].state == CANCELLED) {
+    free_slot(heap_[0]);
+    heap_[0] = heap_[--num_heap_];
+    sift_down(0);
+  }
+}
+
+// Drop all cancelled entries and rebuild the heap in O(n).
+void Fl_Timeout::compact() {
+  int n = 0;
+  for (int i = 0; i < num_heap_; i++) {
+    int slot = heap_[i];
+    if (entry_[slot].state == CANCELLED) free_slot(slot);
+    else heap_[n++] = slot;
+  }
+  num_heap_ = n;
+  for (int i = n / 2 - 1; i >= 0; i--) sift_down(i);
+}
+
+int Fl_Timeout::has(Fl_Timeout_Handler cb, void *data) const {
+  if (!active_) return 0;
+  for (int s = hash_[hash(cb, data)]; s >= 0; s = entry_[s].hnext)
+    if (entry_[s].cb == cb && entry_[s].data == data) return 1;
+  return 0;
+}
+
+void Fl_Timeout::remove(Fl_Timeout_Handler cb, void *data) {
+  if (!active_) return;
+  if (data) {
+    int s = hash_[hash(cb, data)];
+    while (s >= 0) {
+      int next = entry_[s].hnext;
+      if (entry_[s].cb == cb && entry_[s].data == data) cancel(s);
+      s = next;
+    }
+  } else { // matches any data: must look at all timeouts
+    for (int s = 0; s < alloc_entry_; s++)
+      if (entry_[s].state == ACTIVE && entry_[s].cb == cb) cancel(s);
+  }
+}
+
+int Fl_Timeout::slot_of(Fl_Timeout_Id id) const {
+  int slot = (int)(id & ID_SLOT_MASK) - 1;
+  if (slot < 0 || slot >= alloc_entry_) return -1;
+  const Entry &e = entry_[slot];
+  if (e.state != ACTIVE || (e.gen & ID_GEN_MASK) != (id >> ID_SLOT_BITS)) return -1;
+  return slot;
+}
+
+int Fl_Timeout::has(Fl_Timeout_Id id) const {
+  return slot_of(id) >= 0;
+}
+
+void Fl_Timeout::remove(Fl_Timeout_Id id) {
+  int slot = slot_of(id);
+  if (slot >= 0) cancel(slot);
+}
+
+double Fl_Timeout::next_time() {
+  pop_cancelled();
+  return entry_[heap_[0]].time;
+}
+
+int Fl_Timeout::pop_expired(double time, Fl_Timeout_Handler &cb, void *&data, double &deadline) {
+  pop_cancelled();
+  if (!num_heap_) return 0;
+  int slot = heap_[0];
+  Entry &e = entry_[slot];
+  if (e.time > time) return 0;
+  cb = e.cb;
+  data = e.data;
+  deadline = e.time;
+  hash_unlink(slot);
+  active_--;
+  free_slot(slot);
+  heap_[0] = heap_[--num_heap_];
+  sift_down(0);
+  return 1;
+}
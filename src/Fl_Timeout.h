@@ -0,0 +1,105 @@
+//
+// Internal timeout queue for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/*
+  This internal (undocumented) class stores timeouts with absolute
+  deadlines in a binary min-heap, so that adding a timeout costs
+  O(log n) and the next deadline is found in O(1). Time never needs
+  to be subtracted from queued timeouts.
+
+  Timeouts are additionally hashed by their (callback, data) pair, so
+  that has() and remove() don't need to scan the whole queue. Every
+  timeout gets an Fl_Timeout_Id that can be used to cancel it in O(1):
+  cancelled timeouts are only marked and are dropped lazily when they
+  reach the top of the heap (or when the heap is compacted).
+
+  This class is used by the X11 screen driver and may be used by other
+  platforms that don't have a native timer queue.
+*/
+
+#ifndef FL_TIMEOUT_H
+#define FL_TIMEOUT_H
+
+#include <FL/Fl.H>
+
+class Fl_Timeout {
+
+  struct Entry {
+    double time;              // absolute deadline, see now()
+    unsigned long seq;        // insertion order for equal deadlines
+    Fl_Timeout_Handler cb;    // callback, 0 if cancelled
+    void *data;               // callback data
+    unsigned int gen;         // generation, incremented when freed
+    int state;                // FREE, ACTIVE or CANCELLED
+    int hprev, hnext;         // (callback, data) hash chain, or free list
+  };
+
+  Entry *entry_;              // entries, indexed by slot
+  int alloc_entry_;           // allocated entries
+  int free_;                  // first free slot or -1
+  int *heap_;                 // heap of slots, ordered by (time, seq)
+  int num_heap_;              // used heap size (incl. cancelled entries)
+  int alloc_heap_;            // allocated heap size
+  int *hash_;                 // hash table heads (slots or -1)
+  int num_hash_;              // hash table size (power of 2)
+  int active_;                // number of active (not cancelled) timeouts
+  unsigned long seq_;         // insertion counter
+
+  int less(int a, int b) const {
+    const Entry &ea = entry_[heap_[a]], &eb = entry_[heap_[b]];
+    return ea.time < eb.time || (ea.time == eb.time && ea.seq < eb.seq);
+  }
+  unsigned int hash(Fl_Timeout_Handler cb, void *data) const;
+  void sift_up(int pos);
+  void sift_down(int pos);
+  void hash_link(int slot);
+  void hash_unlink(int slot);
+  void rehash(int size);
+  int new_slot();
+  void free_slot(int slot);
+  void cancel(int slot);
+  void pop_cancelled();
+  void compact();
+  int slot_of(Fl_Timeout_Id id) const;
+
+public:
+  Fl_Timeout();
+  ~Fl_Timeout();
+
+  // current time in seconds from an arbitrary (monotonic) reference
+  static double now();
+
+  // add a timeout with absolute deadline 'time'
+  Fl_Timeout_Id add(double time, Fl_Timeout_Handler cb, void *data);
+  // test for timeouts by callback/data
+  int has(Fl_Timeout_Handler cb, void *data) const;
+  // remove timeouts by callback/data, data == 0 matches all data
+  void remove(Fl_Timeout_Handler cb, void *data);
+  // test for or remove a single timeout by its id
+  int has(Fl_Timeout_Id id) const;
+  void remove(Fl_Timeout_Id id);
+
+  // returns true if no timeout is pending
+  int empty() const { return active_ == 0; }
+  // number of pending timeouts
+  int size() const { return active_; }
+  // absolute deadline of the next timeout, must not be empty()
+  double next_time();
+  // remove the next timeout if it expired at 'time', return 1 if found
+  int pop_expired(double time, Fl_Timeout_Handler &cb, void *&data, double &deadline);
+};
+
+#endif // FL_TIMEOUT_H
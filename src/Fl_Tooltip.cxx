@@ -353,11 +353,11 @@ void Fl_Widget::tooltip(const char *text) {
   Fl_Tooltip::set_enter_exit_once_();
   if (flags() & COPIED_TOOLTIP) {
     // reassigning a copied tooltip remains the same copied tooltip
-    if (tooltip_ == text) return;
-    free((void*)(tooltip_));            // free maintained copy
+    if (extra_->tooltip == text) return;
+    free((void*)(extra_->tooltip));     // free maintained copy
     clear_flag(COPIED_TOOLTIP);         // disable copy flag (WE don't make copies)
   }
-  tooltip_ = text;
+  if (text || extra_) extra()->tooltip = text;
 }
 
 /**
@@ -377,12 +377,12 @@ void Fl_Widget::tooltip(const char *text) {
 */
 void Fl_Widget::copy_tooltip(const char *text) {
   Fl_Tooltip::set_enter_exit_once_();
-  if (flags() & COPIED_TOOLTIP) free((void *)(tooltip_));
+  if (flags() & COPIED_TOOLTIP) free((void *)(extra_->tooltip));
   if (text) {
     set_flag(COPIED_TOOLTIP);
-    tooltip_ = fl_strdup(text);
+    extra()->tooltip = fl_strdup(text);
   } else {
     clear_flag(COPIED_TOOLTIP);
-    tooltip_ = (char *)0;
+    if (extra_) extra_->tooltip = (char *)0;
   }
 }
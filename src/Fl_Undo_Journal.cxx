@@ -0,0 +1,225 @@
+//
+// Internal undo journal of Fl_Text_Buffer and Fl_Input_ for the Fast Light
+// Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Undo_Journal.h"
+#include <stdlib.h>
+#include <string.h>
+
+// The default limit of the memory used by the records of one text.
+#define MAX_MEMORY (16 * 1024 * 1024)
+
+Fl_Undo_Journal::Fl_Undo_Journal()
+: records_(0), count_(0), alloc_(0), done_(0), open_(0), memory_(0),
+  max_memory_(MAX_MEMORY), stepping_(0), group_(0), group_start_(0),
+  save_(0), scratch_(0), scratch_size_(0)
+{
+}
+
+Fl_Undo_Journal::~Fl_Undo_Journal() {
+  clear();
+  free(records_);
+  free(scratch_);
+}
+
+void Fl_Undo_Journal::clear() {
+  for (int i = 0; i < count_; i++)
+    free(records_[i].text);
+  free(save_);
+  save_ = 0;
+  count_ = done_ = 0;
+  open_ = stepping_ = 0;
+  group_start_ = group_ > 0;
+  memory_ = 0;
+}
+
+void Fl_Undo_Journal::max_memory(int bytes) {
+  max_memory_ = bytes;
+  trim();
+}
+
+// Makes text large enough for n bytes and a nul, and returns it.
+char *Fl_Undo_Journal::reserve(char *&text, int &size, int n) {
+  if (n >= size) {
+    int s = size ? size : 16;
+    while (s <= n) s *= 2;
+    text = (char *)realloc(text, s);
+    size = s;
+  }
+  return text;
+}
+
+// Adds a record at pos after dropping the records that were undone.
+Fl_Undo_Journal::Record *Fl_Undo_Journal::add(int pos) {
+  while (count_ > done_) {
+    Record *r = records_ + --count_;
+    memory_ -= (int)sizeof(Record) + r->size;
+    free(r->text);
+  }
+  if (count_ == alloc_) {
+    alloc_ = alloc_ ? 2 * alloc_ : 16;
+    records_ = (Record *)realloc(records_, alloc_ * sizeof(Record));
+  }
+  Record *r = records_ + count_++;
+  done_ = count_;
+  r->pos = pos;
+  r->del = r->ins = r->size = 0;
+  r->joined = group_ && !group_start_;
+  r->text = 0;
+  group_start_ = 0;
+  memory_ += (int)sizeof(Record);
+  return r;
+}
+
+// Drops the oldest records until the memory limit is met, but keeps the
+// last record and the records that were undone.
+void Fl_Undo_Journal::trim() {
+  int n = 0;
+  while (memory_ > max_memory_ && n < done_ && n < count_ - 1) {
+    memory_ -= (int)sizeof(Record) + records_[n].size;
+    free(records_[n].text);
+    n++;
+  }
+  if (!n) return;
+  memmove(records_, records_ + n, (count_ - n) * sizeof(Record));
+  count_ -= n;
+  done_ -= n;
+  records_[0].joined = 0;
+}
+
+void Fl_Undo_Journal::inserted(int pos, const char *text, int len) {
+  if (stepping_ || len <= 0) return;
+  Record *r = count_ ? records_ + count_ - 1 : 0;
+  if (!r || !open_ || done_ < count_ || pos != r->pos + r->ins)
+    r = add(pos);
+  r->ins += len;
+  open_ = !memchr(text, '\n', len);
+  trim();
+}
+
+char *Fl_Undo_Journal::removed(int start, int end) {
+  if (stepping_) return save_;
+  int n = end - start;
+  if (n <= 0) return reserve(scratch_, scratch_size_, 0);
+  Record *r = count_ ? records_ + count_ - 1 : 0;
+  if (r && open_ && done_ == count_) {
+    int size = r->size;
+    if (!r->ins && end == r->pos) {
+      // backspace: the removed bytes go before those of the record
+      reserve(r->text, r->size, r->del + n);
+      memmove(r->text + n, r->text, r->del);
+      r->pos = start;
+      r->del += n;
+      r->text[r->del] = 0;
+      memory_ += r->size - size;
+      char *p = r->text;
+      trim();
+      return p;
+    }
+    if (!r->ins && start == r->pos) {
+      // delete: the removed bytes go after those of the record
+      reserve(r->text, r->size, r->del + n);
+      char *p = r->text + r->del;
+      r->del += n;
+      r->text[r->del] = 0;
+      memory_ += r->size - size;
+      trim();
+      return p;
+    }
+    if (start >= r->pos && end == r->pos + r->ins) {
+      // backspace over typed text: the bytes were never there before
+      r->ins -= n;
+      if (!r->ins && !r->del) {
+        memory_ -= (int)sizeof(Record) + r->size;
+        free(r->text);
+        if (group_ && !r->joined) group_start_ = 1;
+        count_--;
+        done_--;
+        open_ = 0;
+      }
+      return reserve(scratch_, scratch_size_, n);
+    }
+  }
+  r = add(start);
+  r->del = n;
+  reserve(r->text, r->size, n);
+  r->text[n] = 0;
+  memory_ += r->size;
+  open_ = 1;
+  char *p = r->text;
+  trim();
+  return p;
+}
+
+int Fl_Undo_Journal::start(int redo, Step &s) {
+  if (stepping_ || (redo ? done_ >= count_ : done_ <= 0)) return 0;
+  Record *r = records_ + (redo ? done_ : done_ - 1);
+  s.pos = r->pos;
+  s.remove = redo ? r->del : r->ins;
+  s.insert = r->text ? r->text : "";
+  s.insert_len = redo ? r->ins : r->del;
+  save_ = (char *)malloc(s.remove + 1);
+  save_[s.remove] = 0;
+  stepping_ = redo ? 2 : 1;
+  open_ = 0;
+  return 1;
+}
+
+void Fl_Undo_Journal::finish() {
+  if (!stepping_) return;
+  int redo = stepping_ == 2;
+  Record *r = records_ + (redo ? done_ : done_ - 1);
+  memory_ -= r->size;
+  free(r->text);
+  r->text = save_;
+  r->size = (redo ? r->del : r->ins) + 1;
+  memory_ += r->size;
+  save_ = 0;
+  stepping_ = 0;
+  done_ += redo ? 1 : -1;
+  trim();
+}
+
+// Returns non-zero if the record after the last one that was redone, or
+// the last one that was undone, belongs to the same group.
+int Fl_Undo_Journal::joined(int redo) const {
+  if (redo)
+    return done_ < count_ && records_[done_].joined;
+  return done_ > 0 && records_[done_].joined;
+}
+
+void Fl_Undo_Journal::begin_group() {
+  if (!group_++) {
+    open_ = 0;
+    group_start_ = 1;
+  }
+}
+
+void Fl_Undo_Journal::end_group() {
+  if (group_ > 0 && !--group_)
+    open_ = 0;
+}
+
+const char *Fl_Undo_Journal::last_cut(int &len) const {
+  for (int i = done_ - 1; i >= 0; i--) {
+    if (records_[i].del) {
+      len = records_[i].del;
+      return records_[i].text;
+    }
+  }
+  len = 0;
+  return 0;
+}
@@ -0,0 +1,113 @@
+//
+// Internal undo journal of Fl_Text_Buffer and Fl_Input_ for the Fast Light
+// Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/*
+  This internal (undocumented) class records the edits of one text, so
+  that they can be undone and redone in any number of steps.
+
+  Every record replaces the del bytes at pos with ins bytes. Its text
+  holds the bytes that are not in the text right now: the removed bytes
+  while the record is done, and the inserted bytes after it was undone.
+  Undoing or redoing a record swaps the two, so a record never stores
+  both.
+
+  Consecutive typing and deleting are merged into the last record: an
+  insertion at its end, a backspace before it, and a delete after it.
+  A record is closed after a newline was typed, and when an edit is made
+  somewhere else. A new edit drops the records that were undone.
+
+  The text of all records is limited to max_memory() bytes. The oldest
+  records are dropped when more is needed, but the last record is always
+  kept.
+
+  The records between begin_group() and end_group() are undone and
+  redone together: joined() tells the owner to continue with the next
+  record after finish().
+
+  The owner calls inserted() after text was inserted and removed() before
+  text is removed, and copies the removed text to the memory returned by
+  removed(). To undo or redo a record, it calls start(), replaces the
+  text as told by the Step, and then calls finish(). Edits between start()
+  and finish() are not recorded, but removed() returns the memory where
+  the text of the step must be saved.
+*/
+
+#ifndef FL_UNDO_JOURNAL_H
+#define FL_UNDO_JOURNAL_H
+
+class Fl_Undo_Journal {
+
+  struct Record {
+    int pos;                  // start of the edit
+    int del;                  // number of bytes removed at pos
+    int ins;                  // number of bytes inserted at pos
+    int size;                 // allocated size of text
+    int joined;               // undone and redone together with the previous record
+    char *text;               // removed bytes if done, inserted bytes if undone
+  };
+
+  Record *records_;
+  int count_;                 // number of records
+  int alloc_;                 // allocated number of records
+  int done_;                  // records before this can be undone, the others redone
+  int open_;                  // the last record can be extended
+  int memory_;                // bytes used by the records
+  int max_memory_;
+  int stepping_;              // 1 while undoing, 2 while redoing a record
+  int group_;                 // nesting depth of begin_group()
+  int group_start_;           // the next record is the first of its group
+  char *save_;                // text of the record that is undone or redone
+  char *scratch_;             // removed text that is not kept
+  int scratch_size_;
+
+  static char *reserve(char *&text, int &size, int n);
+  Record *add(int pos);
+  void trim();
+
+public:
+  struct Step {
+    int pos;                  // replace this many bytes at pos ...
+    int remove;
+    const char *insert;       // ... with these bytes, which are nul-terminated
+    int insert_len;
+  };
+
+  Fl_Undo_Journal();
+  ~Fl_Undo_Journal();
+
+  void clear();
+  void close() { open_ = 0; }
+  int can_undo() const { return done_ > 0; }
+  int can_redo() const { return done_ < count_; }
+  int max_memory() const { return max_memory_; }
+  void max_memory(int bytes);
+
+  void inserted(int pos, const char *text, int len);
+  char *removed(int start, int end);
+
+  int start(int redo, Step &s);
+  void finish();
+  int joined(int redo) const;
+
+  void begin_group();
+  void end_group();
+
+  // Returns the text that was removed by the last edit that removed text.
+  const char *last_cut(int &len) const;
+};
+
+#endif // FL_UNDO_JOURNAL_H
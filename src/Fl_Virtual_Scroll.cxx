@@ -0,0 +1,254 @@
+//
+// Virtual scroll widget for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <FL/Fl.H>
+#include <FL/Fl_Virtual_Scroll.H>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+  Creates a new Fl_Virtual_Scroll widget using the given position,
+  size, and label string. The list has no rows, call rows(int) to set
+  the number of rows.
+
+  The type() is Fl_Scroll::VERTICAL, because the row widgets are as
+  wide as the scroll area.
+
+  As with Fl_Scroll, call end() after creating the widget.
+*/
+Fl_Virtual_Scroll::Fl_Virtual_Scroll(int X, int Y, int W, int H, const char *L)
+  : Fl_Scroll(X, Y, W, H, L),
+    spacer_(X, Y, W, 0) {
+  type(VERTICAL);
+  rows_ = 0;
+  default_row_height_ = 25;
+  row_y_ = (int*)malloc(sizeof(int));
+  row_y_[0] = 0;
+  first_ = last_ = 0;
+  shown_ = 0;
+  alloc_shown_ = 0;
+  unused_ = 0;
+  num_unused_ = alloc_unused_ = 0;
+}
+
+/**
+  Destroys the widget and all row widgets.
+*/
+Fl_Virtual_Scroll::~Fl_Virtual_Scroll() {
+  while (num_unused_) delete unused_[--num_unused_];
+  free(unused_);
+  free(shown_);
+  free(row_y_);
+}
+
+/**
+  Deletes all row widgets. New row widgets are made with create_row()
+  when they are needed.
+*/
+void Fl_Virtual_Scroll::clear() {
+  remove(spacer_);
+  Fl_Scroll::clear();
+  add(spacer_);
+  while (num_unused_) delete unused_[--num_unused_];
+  first_ = last_ = 0;
+  redraw();
+}
+
+/**
+  Returns the height of \p row in pixels.
+
+  The default implementation returns default_row_height(). Override this
+  for rows of different heights, and call rows_changed() when the heights
+  change.
+*/
+int Fl_Virtual_Scroll::row_height(int /*row*/) const {
+  return default_row_height_;
+}
+
+/**
+  Sets the number of rows.
+
+  All row widgets are updated with update_row() before they are drawn
+  the next time.
+*/
+void Fl_Virtual_Scroll::rows(int n) {
+  rows_ = n > 0 ? n : 0;
+  rows_changed();
+}
+
+/**
+  Sets the height of all rows if row_height(int) is not overridden.
+  The default is 25 pixels.
+*/
+void Fl_Virtual_Scroll::default_row_height(int h) {
+  default_row_height_ = h > 0 ? h : 0;
+  rows_changed();
+}
+
+/**
+  Tells the widget that the data or the heights of the rows changed.
+
+  This asks row_height(int) for the height of all rows, and updates all
+  row widgets with update_row() before they are drawn the next time.
+*/
+void Fl_Virtual_Scroll::rows_changed() {
+  row_y_ = (int*)realloc(row_y_, (rows_ + 1) * sizeof(int));
+  row_y_[0] = 0;
+  for (int i = 0; i < rows_; i++) {
+    int h = row_height(i);
+    row_y_[i + 1] = row_y_[i] + (h > 0 ? h : 0);
+  }
+  for (int i = first_; i < last_; i++) recycle_row(shown_[i - first_]);
+  first_ = last_ = 0;
+  spacer_.size(spacer_.w(), row_y_[rows_]);
+  // keep the end of the list at the bottom if it got shorter
+  int X, Y, W, H; bbox(X, Y, W, H);
+  int bottom = row_y_[rows_] - H;
+  if (bottom < 0) bottom = 0;
+  if (yposition() > bottom) scroll_to(xposition(), bottom);
+  redraw();
+}
+
+/**
+  Returns the position of the top of \p row relative to the top of the
+  first row.
+*/
+int Fl_Virtual_Scroll::row_position(int row) const {
+  if (row < 0) row = 0;
+  if (row > rows_) row = rows_;
+  return row_y_[row];
+}
+
+/**
+  Scrolls the list so that \p row is visible, if it is not visible yet.
+*/
+void Fl_Virtual_Scroll::show_row(int row) {
+  if (row < 0 || row >= rows_) return;
+  int X, Y, W, H; bbox(X, Y, W, H);
+  int pos = yposition();
+  if (row_y_[row] < pos) pos = row_y_[row];
+  else if (row_y_[row + 1] > pos + H) pos = row_y_[row + 1] - H;
+  scroll_to(xposition(), pos);
+}
+
+/**
+  Returns the widget that shows \p row, or NULL if the row has no widget
+  because it is not visible.
+
+  The widget can change when the list is scrolled or drawn.
+*/
+Fl_Widget *Fl_Virtual_Scroll::row_widget(int row) const {
+  if (row < first_ || row >= last_) return 0;
+  return shown_[row - first_];
+}
+
+// Returns the row at position Y relative to the top of the first row.
+int Fl_Virtual_Scroll::find_row(int Y) const {
+  int lo = 0, hi = rows_ - 1;
+  while (lo < hi) {
+    int mid = (lo + hi + 1) / 2;
+    if (row_y_[mid] <= Y) lo = mid;
+    else hi = mid - 1;
+  }
+  return lo;
+}
+
+// Returns an unused row widget or makes a new one, and adds it to the group.
+Fl_Widget *Fl_Virtual_Scroll::new_row() {
+  Fl_Widget *w;
+  if (num_unused_) {
+    w = unused_[--num_unused_];
+  } else {
+    Fl_Group *g = Fl_Group::current();
+    Fl_Group::current(0);
+    w = create_row();
+    Fl_Group::current(g);
+  }
+  add(w);
+  return w;
+}
+
+// Removes a row widget from the group and keeps it for reuse.
+void Fl_Virtual_Scroll::recycle_row(Fl_Widget *w) {
+  // the widget can't keep the focus or the mouse while it is not shown
+  if (w->contains(Fl::focus())) Fl::focus(0);
+  if (w->contains(Fl::belowmouse())) Fl::belowmouse(0);
+  if (w->contains(Fl::pushed())) Fl::pushed(0);
+  remove(w);
+  if (num_unused_ >= alloc_unused_) {
+    alloc_unused_ = alloc_unused_ ? 2 * alloc_unused_ : 8;
+    unused_ = (Fl_Widget**)realloc(unused_, alloc_unused_ * sizeof(Fl_Widget*));
+  }
+  unused_[num_unused_++] = w;
+}
+
+/**
+  Makes sure that the visible rows, and only those, have row widgets.
+
+  Row widgets of rows that are no longer visible are reused for the
+  rows that became visible, and updated with update_row(). All row
+  widgets are moved and resized to the position and size of their row.
+
+  draw() calls this before it draws the widget.
+*/
+void Fl_Virtual_Scroll::layout_rows() {
+  int X, Y, W, H; bbox(X, Y, W, H);
+  int top = Y - yposition(); // top of the first row
+  if (spacer_.x() != X || spacer_.y() != top ||
+      spacer_.w() != W || spacer_.h() != row_y_[rows_])
+    spacer_.resize(X, top, W, row_y_[rows_]);
+
+  // find the visible rows
+  int first = 0, last = 0;
+  if (rows_ && H > 0) {
+    first = find_row(Y - top);
+    last = find_row(Y - top + H - 1) + 1;
+  }
+
+  // keep the widgets of rows that are still visible, reuse the others
+  int i;
+  for (i = first_; i < last_; i++)
+    if (i < first || i >= last) recycle_row(shown_[i - first_]);
+  if (last - first > alloc_shown_) {
+    alloc_shown_ = last - first;
+    shown_ = (Fl_Widget**)realloc(shown_, alloc_shown_ * sizeof(Fl_Widget*));
+  }
+  int keep_first = first > first_ ? first : first_;
+  int keep_last = last < last_ ? last : last_;
+  if (keep_first < keep_last)
+    memmove(shown_ + keep_first - first, shown_ + keep_first - first_,
+            (keep_last - keep_first) * sizeof(Fl_Widget*));
+  for (i = first; i < last; i++) {
+    Fl_Widget *w;
+    if (i >= keep_first && i < keep_last) {
+      w = shown_[i - first];
+    } else {
+      w = new_row();
+      update_row(w, i);
+      shown_[i - first] = w;
+    }
+    int wy = top + row_y_[i], wh = row_y_[i + 1] - row_y_[i];
+    if (w->x() != X || w->y() != wy || w->w() != W || w->h() != wh)
+      w->resize(X, wy, W, wh);
+  }
+  first_ = first;
+  last_ = last;
+}
+
+void Fl_Virtual_Scroll::draw() {
+  layout_rows();
+  Fl_Scroll::draw();
+}
@@ -22,6 +22,7 @@
 #include <FL/fl_string.h>
 #include <stdlib.h>
 #include "flstring.h"
+#include "Fl_Spatial_Index.h"
 
 
 ////////////////////////////////////////////////////////////////
@@ -110,15 +111,13 @@ Fl_Widget::Fl_Widget(int X, int Y, int W, int H, const char* L) {
 
   x_ = X; y_ = Y; w_ = W; h_ = H;
 
-  label_.value   = L;
-  label_.image   = 0;
-  label_.deimage = 0;
-  label_.type    = FL_NORMAL_LABEL;
-  label_.font    = FL_HELVETICA;
-  label_.size    = FL_NORMAL_SIZE;
-  label_.color   = FL_FOREGROUND_COLOR;
-  label_.align_  = FL_ALIGN_CENTER;
-  tooltip_       = 0;
+  label_         = L;
+  labeltype_     = FL_NORMAL_LABEL;
+  labelfont_     = FL_HELVETICA;
+  labelsize_     = FL_NORMAL_SIZE;
+  labelcolor_    = FL_FOREGROUND_COLOR;
+  align_         = FL_ALIGN_CENTER;
+  extra_         = 0;
   callback_      = default_callback;
   user_data_     = 0;
   type_          = 0;
@@ -130,6 +129,7 @@ Fl_Widget::Fl_Widget(int X, int Y, int W, int H, const char* L) {
   when_          = FL_WHEN_RELEASE;
 
   parent_ = 0;
+  index_ = 0;
   if (Fl_Group::current()) Fl_Group::current()->add(this);
   if (!fl_graphics_driver) {
     // Make sure fl_graphics_driver is initialized. Important if we are called by a static initializer.
@@ -137,8 +137,38 @@ Fl_Widget::Fl_Widget(int X, int Y, int W, int H, const char* L) {
   }
 }
 
+// Returns the rarely used attributes, allocating them if needed.
+Fl_Widget::Extra *Fl_Widget::extra() {
+  if (!extra_) {
+    extra_ = new Extra;
+    extra_->tooltip = 0;
+    extra_->image = 0;
+    extra_->deimage = 0;
+  }
+  return extra_;
+}
+
+// Fills in the label of the widget for drawing or measuring it.
+void Fl_Widget::get_label(Fl_Label &l) const {
+  l.value   = label_;
+  l.image   = extra_ ? extra_->image : 0;
+  l.deimage = extra_ ? extra_->deimage : 0;
+  l.type    = labeltype_;
+  l.font    = labelfont_;
+  l.size    = labelsize_;
+  l.color   = labelcolor_;
+  l.align_  = align_;
+}
+
+void Fl_Widget::measure_label(int& ww, int& hh) const {
+  Fl_Label l;
+  get_label(l);
+  l.measure(ww, hh);
+}
+
 void Fl_Widget::resize(int X, int Y, int W, int H) {
   x_ = X; y_ = Y; w_ = W; h_ = H;
+  if (parent_ && parent_->spatial_index()) parent_->layout_->spatial_index->invalidate();
 }
 
 // this is useful for parent widgets to call to resize children:
@@ -167,8 +197,9 @@ extern void fl_throw_focus(Fl_Widget*); // in Fl_x.cxx
 */
 Fl_Widget::~Fl_Widget() {
   Fl::clear_widget_pointer(this);
-  if (flags() & COPIED_LABEL) free((void *)(label_.value));
-  if (flags() & COPIED_TOOLTIP) free((void *)(tooltip_));
+  if (flags() & COPIED_LABEL) free((void *)(label_));
+  if (flags() & COPIED_TOOLTIP) free((void *)(extra_->tooltip));
+  delete extra_;
   // remove from parent group
   if (parent_) parent_->remove(this);
 #ifdef DEBUG_DELETE
@@ -277,19 +308,19 @@ int Fl_Widget::contains(const Fl_Widget *o) const {
 void Fl_Widget::label(const char *a) {
   if (flags() & COPIED_LABEL) {
     // reassigning a copied label remains the same copied label
-    if (label_.value == a)
+    if (label_ == a)
       return;
-    free((void *)(label_.value));
+    free((void *)(label_));
     clear_flag(COPIED_LABEL);
   }
-  label_.value=a;
+  label_=a;
   redraw_label();
 }
 
 
 void Fl_Widget::copy_label(const char *a) {
   // reassigning a copied label remains the same copied label
-  if ((flags() & COPIED_LABEL) && (label_.value == a))
+  if ((flags() & COPIED_LABEL) && (label_ == a))
     return;
   if (a) {
     label(fl_strdup(a));
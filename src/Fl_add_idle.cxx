@@ -18,6 +18,7 @@
 // Replaces the older set_idle() call (which is used to implement this)
 
 #include <FL/Fl.H>
+#include "fl_loop_stats.h"
 
 struct idle_cb {
   void (*cb)(void*);
@@ -35,7 +36,10 @@ static idle_cb* freelist;
 static void call_idle() {
   idle_cb* p = first;
   last = p; first = p->next;
-  p->cb(p->data); // this may call add_idle() or remove_idle()!
+  FL_LOOP_STATS_START(t);
+  Fl_Idle_Handler cb = p->cb;
+  cb(p->data); // this may call add_idle() or remove_idle()!
+  FL_LOOP_STATS_END(t, IDLE, cb);
 }
 
 /**
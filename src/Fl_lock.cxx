@@ -56,65 +56,161 @@
    returns the most recent value!
 */
 
-#ifndef FL_DOXYGEN
-Fl_Awake_Handler *Fl::awake_ring_;
-void **Fl::awake_data_;
-int Fl::awake_ring_size_;
-int Fl::awake_ring_head_;
-int Fl::awake_ring_tail_;
+/*
+  The awake queue:
+
+  Fl::awake(Fl_Awake_Handler, void*) may be called from any thread, the
+  handlers are called by the main thread. The queue is a lock-free stack
+  of nodes, producers push with a single compare-and-swap. The main thread
+  takes all pending nodes at once and reverses them into a private FIFO
+  batch, so it needs only one atomic operation per batch.
+
+  The producer that finds the stack empty is responsible for waking up
+  the main thread, all others rely on this wakeup. Hence the main thread
+  is only signalled once per batch and not once per message.
+
+  The queue grows as needed unless Fl::awake_queue_limit() was set, in
+  which case Fl::awake() returns -1 when the limit is reached so that
+  producers can throttle themselves.
+*/
+
+#if defined(_WIN32)
+#  include <windows.h>
 #endif
 
-static const int AWAKE_RING_SIZE = 1024;
+struct Fl_Awake_Node {
+  Fl_Awake_Handler func;
+  void *data;
+  Fl_Awake_Node *next;
+};
+
+static Fl_Awake_Node * volatile awake_head = 0; // pushed by producers (LIFO)
+static Fl_Awake_Node *awake_batch = 0;          // taken by the main thread (FIFO)
+static volatile long awake_count = 0;           // pushed, but not yet processed
+static int awake_limit = 0;                     // 0 = no limit
+
+// Atomically replace *p by n if it equals o, returns the previous value.
+static Fl_Awake_Node *awake_cas(Fl_Awake_Node * volatile *p, Fl_Awake_Node *o, Fl_Awake_Node *n) {
+#if defined(_WIN32)
+  return (Fl_Awake_Node *)InterlockedCompareExchangePointer((PVOID volatile *)p, n, o);
+#elif defined(__GNUC__)
+  return __sync_val_compare_and_swap(p, o, n);
+#else
+  Fl::system_driver()->lock_ring();
+  Fl_Awake_Node *prev = *p;
+  if (prev == o) *p = n;
+  Fl::system_driver()->unlock_ring();
+  return prev;
+#endif
+}
 
-/** Adds an awake handler for use in awake(). */
-int Fl::add_awake_handler_(Fl_Awake_Handler func, void *data)
-{
-  int ret = 0;
+// Atomically add v to awake_count.
+static void awake_count_add(long v) {
+#if defined(_WIN32)
+  InterlockedExchangeAdd((LONG volatile *)&awake_count, v);
+#elif defined(__GNUC__)
+  __sync_fetch_and_add(&awake_count, v);
+#else
   Fl::system_driver()->lock_ring();
-  if (!awake_ring_) {
-    awake_ring_size_ = AWAKE_RING_SIZE;
-    awake_ring_ = (Fl_Awake_Handler*)malloc(awake_ring_size_*sizeof(Fl_Awake_Handler));
-    awake_data_ = (void**)malloc(awake_ring_size_*sizeof(void*));
-    // explicitly initialize the head and tail indices
-    awake_ring_head_= awake_ring_tail_ = 0;
-  }
-  // The next head index we will want (not the current index):
-  // We use this to check if the ring-buffer is full or not
-  // (and to update awake_ring_head_ if we do use the current index.)
-  int next_head = awake_ring_head_ + 1;
-  if (next_head >= awake_ring_size_) {
-    next_head = 0;
-  }
-  // check that the ring buffer is not full, and that it exists
-  if ((!awake_ring_) || (next_head == awake_ring_tail_)) {
-    // ring is non-existent or full. Return -1 as an error indicator.
-    ret = -1;
-  } else {
-    awake_ring_[awake_ring_head_] = func;
-    awake_data_[awake_ring_head_] = data;
-    awake_ring_head_ = next_head;
-  }
+  awake_count += v;
   Fl::system_driver()->unlock_ring();
-  return ret;
+#endif
+}
+
+// Allocates a node for the awake queue, returns 0 if the queue is full.
+// This takes no lock, so it may be called with the ring lock held.
+static Fl_Awake_Node *awake_node_new(Fl_Awake_Handler func, void *data) {
+  if (awake_limit > 0 && awake_count >= awake_limit)
+    return 0;
+  Fl_Awake_Node *node = (Fl_Awake_Node*)malloc(sizeof(Fl_Awake_Node));
+  if (!node) return 0;
+  node->func = func;
+  node->data = data;
+  return node;
+}
+
+// Pushes a node allocated by awake_node_new(), this can't fail.
+// Returns 1 if the queue was empty, i.e. the main thread must be woken up.
+static int awake_push(Fl_Awake_Node *node) {
+  awake_count_add(1);
+  Fl_Awake_Node *head = awake_head;
+  for (;;) {
+    node->next = head;
+    Fl_Awake_Node *prev = awake_cas(&awake_head, head, node);
+    if (prev == head) break;
+    head = prev;
+  }
+  return head ? 0 : 1;
+}
+
+/** Adds an awake handler for use in awake().
+ Returns 1 if the queue was empty, i.e. the caller must wake up the main
+ thread, 0 if the main thread has already been signalled, or -1 on error.
+ */
+int Fl::add_awake_handler_(Fl_Awake_Handler func, void *data)
+{
+  Fl_Awake_Node *node = awake_node_new(func, data);
+  if (!node) return -1;
+  return awake_push(node);
 }
 
-/** Gets the last stored awake handler for use in awake(). */
+/** Gets the next stored awake handler for use in awake().
+ Must only be called by the main thread.
+ */
 int Fl::get_awake_handler_(Fl_Awake_Handler &func, void *&data)
 {
-  int ret = 0;
-  Fl::system_driver()->lock_ring();
-  if ((!awake_ring_) || (awake_ring_head_ == awake_ring_tail_)) {
-    ret = -1;
-  } else {
-    func = awake_ring_[awake_ring_tail_];
-    data = awake_data_[awake_ring_tail_];
-    ++awake_ring_tail_;
-    if (awake_ring_tail_ >= awake_ring_size_) {
-      awake_ring_tail_ = 0;
+  if (!awake_batch) {
+    if (!awake_head) return -1;
+    // take all pending nodes at once and restore their order
+    Fl_Awake_Node *list = awake_head, *prev;
+    while ((prev = awake_cas(&awake_head, list, 0)) != list) list = prev;
+    while (list) {
+      Fl_Awake_Node *next = list->next;
+      list->next = awake_batch;
+      awake_batch = list;
+      list = next;
     }
+    if (!awake_batch) return -1;
   }
-  Fl::system_driver()->unlock_ring();
-  return ret;
+  Fl_Awake_Node *node = awake_batch;
+  awake_batch = node->next;
+  func = node->func;
+  data = node->data;
+  free(node);
+  awake_count_add(-1);
+  return 0;
+}
+
+/** Returns non-zero if awake handlers are pending. */
+int Fl::has_awake_handler_()
+{
+  return awake_batch != 0 || awake_head != 0;
+}
+
+/**
+ Sets the maximum number of pending Fl::awake(Fl_Awake_Handler, void*) calls.
+
+ By default the awake queue grows as needed. If you set a limit, Fl::awake()
+ returns -1 if \p max calls are pending that have not been processed by the
+ main thread yet. Producer threads can use this to throttle themselves
+ when the main thread can't keep up.
+
+ \param[in] max  maximum number of pending handlers, 0 (default) for no limit
+ \version 1.4.0
+ */
+void Fl::awake_queue_limit(int max)
+{
+  awake_limit = max > 0 ? max : 0;
+}
+
+/**
+ Returns the maximum number of pending Fl::awake() handlers, 0 means no limit.
+ \see Fl::awake_queue_limit(int)
+ \version 1.4.0
+ */
+int Fl::awake_queue_limit()
+{
+  return awake_limit;
 }
 
 /**
@@ -122,15 +218,182 @@ int Fl::get_awake_handler_(Fl_Awake_Handler &func, void *&data)
  Registers a function that will be
  called by the main thread during the next message handling cycle.
  Returns 0 if the callback function was registered,
- and -1 if registration failed. Over a thousand awake callbacks can be
- registered simultaneously.
+ and -1 if registration failed. The number of awake callbacks that can
+ be registered simultaneously is only limited by available memory, unless
+ a limit was set with Fl::awake_queue_limit().
+
+ Consecutive calls are processed in batches: the main thread is only
+ woken up once for all calls that are made before it gets to process them.
 
  \see Fl::awake(void* message=0)
 */
 int Fl::awake(Fl_Awake_Handler func, void *data) {
   int ret = add_awake_handler_(func, data);
-  Fl::awake();
-  return ret;
+  // only wake up the main thread if it has not been signalled yet
+  if (ret) Fl::system_driver()->awake_signal();
+  return ret < 0 ? -1 : 0;
+}
+
+/*
+  Coalescing awake handlers (Fl::awake_once()):
+
+  Pending (handler, data) pairs are stored in a small hash table protected
+  by the ring lock. Each pair is posted once to the awake queue with a
+  trampoline that removes the pair from the table before calling the
+  handler, so that calls made while the handler runs queue a new call.
+*/
+
+struct Fl_Awake_Once {
+  Fl_Awake_Handler func;
+  void *data;
+  int count;                    // number of awake_once() calls
+  Fl_Awake_Once *next;          // hash chain
+};
+
+static Fl_Awake_Once **once_table = 0;
+static int once_table_size = 0; // power of 2
+static int once_pending = 0;
+static unsigned long once_posted = 0;
+static unsigned long once_merged = 0;
+static int once_current_count = 0;
+
+static Fl_Awake_Once **once_bucket(Fl_Awake_Handler func, void *data) {
+  fl_uintptr_t h = (fl_uintptr_t)func ^ ((fl_uintptr_t)data * 31);
+  h ^= h >> 16;
+  return once_table + (h & (once_table_size - 1));
+}
+
+static void once_rehash(int size) {
+  Fl_Awake_Once **old = once_table;
+  int old_size = once_table_size;
+  once_table = (Fl_Awake_Once **)calloc(size, sizeof(Fl_Awake_Once *));
+  once_table_size = size;
+  for (int i = 0; i < old_size; i++) {
+    Fl_Awake_Once *e = old[i];
+    while (e) {
+      Fl_Awake_Once *next = e->next;
+      Fl_Awake_Once **b = once_bucket(e->func, e->data);
+      e->next = *b;
+      *b = e;
+      e = next;
+    }
+  }
+  free(old);
+}
+
+// called by the main thread for each pending pair
+static void awake_once_cb(void *v) {
+  Fl_Awake_Once *entry = (Fl_Awake_Once *)v;
+  Fl::system_driver()->lock_ring();
+  Fl_Awake_Once **p = once_bucket(entry->func, entry->data);
+  while (*p != entry) p = &((*p)->next);
+  *p = entry->next;
+  once_pending--;
+  Fl::system_driver()->unlock_ring();
+  Fl_Awake_Handler func = entry->func;
+  void *data = entry->data;
+  int saved_count = once_current_count;
+  once_current_count = entry->count;
+  free(entry);
+  func(data);
+  once_current_count = saved_count;
+}
+
+/**
+ Let the main thread call a function once, merging duplicate requests.
+
+ This works like Fl::awake(Fl_Awake_Handler, void*), but guarantees that
+ at most one call of \p func with \p data is pending at any time.
+ If the same pair is posted again before the main thread calls it, the
+ posts are merged into the pending call. This allows worker threads to post
+ updates at a high rate without flooding the main thread with redundant
+ calls, for instance to update a widget that displays the latest value.
+
+ Calls posted while \p func is running (even from \p func itself)
+ are queued again, hence no update is lost.
+
+ Inside \p func, Fl::awake_once_count() returns the number of posts that
+ this call represents. Fl::awake_once_posted() and Fl::awake_once_merged()
+ return global statistics.
+
+ \param[in] func  function to call in the main thread
+ \param[in] data  user data passed to \p func
+ \return 0 if a new call was queued, 1 if it was merged into a pending call,
+   or -1 if registration failed (see Fl::awake_queue_limit())
+
+ \see Fl::awake(Fl_Awake_Handler, void*)
+ \version 1.4.0
+ */
+int Fl::awake_once(Fl_Awake_Handler func, void *data) {
+  Fl::system_driver()->lock_ring();
+  once_posted++;
+  if (once_table_size) {
+    for (Fl_Awake_Once *e = *once_bucket(func, data); e; e = e->next) {
+      if (e->func == func && e->data == data) {
+        e->count++;
+        once_merged++;
+        Fl::system_driver()->unlock_ring();
+        return 1;
+      }
+    }
+  }
+  // Reserve the queue node before the entry is visible to other threads:
+  // once they can merge into it, queueing it must not fail anymore.
+  Fl_Awake_Once *entry = (Fl_Awake_Once *)malloc(sizeof(Fl_Awake_Once));
+  Fl_Awake_Node *node = entry ? awake_node_new(awake_once_cb, entry) : 0;
+  if (!node) {
+    Fl::system_driver()->unlock_ring();
+    free(entry);
+    return -1;
+  }
+  if (once_pending >= once_table_size)
+    once_rehash(once_table_size ? once_table_size * 2 : 64);
+  entry->func = func;
+  entry->data = data;
+  entry->count = 1;
+  Fl_Awake_Once **b = once_bucket(func, data);
+  entry->next = *b;
+  *b = entry;
+  once_pending++;
+  Fl::system_driver()->unlock_ring();
+  if (awake_push(node)) Fl::system_driver()->awake_signal();
+  return 0;
+}
+
+/**
+ Returns the number of Fl::awake_once() calls merged into the current call.
+ This is only meaningful inside a handler called because of Fl::awake_once(),
+ it returns 1 if the call was not merged with other posts, and 0 outside of
+ such a handler.
+ \version 1.4.0
+ */
+int Fl::awake_once_count() {
+  return once_current_count;
+}
+
+/**
+ Returns the total number of Fl::awake_once() calls.
+ \see Fl::awake_once_merged()
+ \version 1.4.0
+ */
+unsigned long Fl::awake_once_posted() {
+  Fl::system_driver()->lock_ring();
+  unsigned long n = once_posted;
+  Fl::system_driver()->unlock_ring();
+  return n;
+}
+
+/**
+ Returns the number of Fl::awake_once() calls that were merged into a
+ pending call, i.e. the number of handler calls that were saved.
+ \see Fl::awake_once_posted()
+ \version 1.4.0
+ */
+unsigned long Fl::awake_once_merged() {
+  Fl::system_driver()->lock_ring();
+  unsigned long n = once_merged;
+  Fl::system_driver()->unlock_ring();
+  return n;
 }
 
 /** \fn int Fl::lock()
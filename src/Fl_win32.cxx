@@ -408,7 +408,7 @@ static void process_awake_handler_requests(void) {
   Fl_Awake_Handler func;
   void *data;
   while (Fl::get_awake_handler_(func, data) == 0) {
-    func(data);
+    if (func) func(data);
   }
 }
 
@@ -498,16 +498,16 @@ double Fl_WinAPI_Screen_Driver::wait(double time_to_wait) {
   }
 
   // The following conditional test:
-  //    (Fl::awake_ring_head_ != Fl::awake_ring_tail_)
+  //    (Fl::has_awake_handler_())
   // is a workaround / fix for STR #3143. This works, but a better solution
   // would be to understand why the PostThreadMessage() messages are not
   // seen by the main window if it is being dragged/ resized at the time.
   // If a worker thread posts an awake callback to the ring buffer
   // whilst the main window is unresponsive (if a drag or resize operation
   // is in progress) we may miss the PostThreadMessage(). So here, we check if
-  // there is anything pending in the awake ring buffer and if so process
-  // it. This is not strictly thread safe (for speed it compares the head
-  // and tail indices without first locking the ring buffer) but is intended
+  // there is anything pending in the awake queue and if so process
+  // it. This is not strictly thread safe (for speed it reads the queue
+  // pointers without atomic operations) but is intended
   // only as a fall-back recovery mechanism if the awake processing stalls.
   // If the test erroneously returns true (may happen if we test the indices
   // whilst they are being modified) we will call process_awake_handler_requests()
@@ -515,9 +515,9 @@ double Fl_WinAPI_Screen_Driver::wait(double time_to_wait) {
   // Note also that if we miss the PostThreadMessage(), then thread_message_
   // will not be updated, so this is not a perfect solution, but it does
   // recover and process any pending awake callbacks.
-  // Normally the ring buffer head and tail indices will match and this
-  // comparison will do nothing. Addresses STR #3143
-  if (Fl::awake_ring_head_ != Fl::awake_ring_tail_) {
+  // Normally the awake queue will be empty and this
+  // test will do nothing. Addresses STR #3143
+  if (Fl::has_awake_handler_()) {
     process_awake_handler_requests();
   }
 
@@ -38,6 +38,7 @@
 #  include <stdio.h>
 #  include <stdlib.h>
 #  include "flstring.h"
+#  include "fl_loop_stats.h"
 #  include "drivers/X11/Fl_X11_Screen_Driver.H"
 #  include "drivers/X11/Fl_X11_Window_Driver.H"
 #  include "drivers/X11/Fl_X11_System_Driver.H"
@@ -83,6 +84,110 @@ static void open_display_i(Display *d); // open display (internal)
 ////////////////////////////////////////////////////////////////
 // interface to poll/select call:
 
+#  if USE_EPOLL
+
+// The epoll() backend keeps the callbacks in an array indexed by the file
+// descriptor, so add_fd() and remove_fd() are O(1) and only the descriptors
+// reported ready by epoll_wait() are looked at.
+
+#    include <sys/epoll.h>
+#    include <poll.h>
+#    include <errno.h>
+#    include <string.h>
+
+// the 3 conditions FL_READ, FL_WRITE, FL_EXCEPT can have separate callbacks
+static const int fd_when[3] = { POLLIN, POLLOUT, POLLERR };
+
+struct FD {
+  short events;                 // registered POLLIN/POLLOUT/POLLERR bits
+  short edge;                   // non-zero for edge-triggered notification
+  void (*cb[3])(int, void*);    // callbacks for fd_when[]
+  void* arg[3];
+};
+
+static int epfd = -1;           // the epoll file descriptor
+static int nfds = 0;            // number of registered file descriptors
+static int fd_array_size = 0;   // size of fd[], indexed by file descriptor
+static FD *fd = 0;
+static struct epoll_event *ready_events = 0; // buffer for epoll_wait()
+static int ready_size = 0;
+
+// update the kernel's interest list for file descriptor n
+static void epoll_update(int n, int old_events) {
+  struct epoll_event ev;
+  ev.events = 0;
+  ev.data.u64 = 0;
+  ev.data.fd = n;
+  if (fd[n].events & POLLIN)  ev.events |= EPOLLIN;
+  if (fd[n].events & POLLOUT) ev.events |= EPOLLOUT;
+  if (fd[n].events & POLLERR) ev.events |= EPOLLPRI;
+  if (fd[n].edge) ev.events |= EPOLLET;
+  if (!fd[n].events) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, n, &ev);
+  } else if (!old_events) {
+    // the fd may still be registered if it was closed and reused without remove_fd()
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, n, &ev) < 0 && errno == EEXIST)
+      epoll_ctl(epfd, EPOLL_CTL_MOD, n, &ev);
+  } else {
+    if (epoll_ctl(epfd, EPOLL_CTL_MOD, n, &ev) < 0 && errno == ENOENT)
+      epoll_ctl(epfd, EPOLL_CTL_ADD, n, &ev);
+  }
+}
+
+void Fl_X11_System_Driver::add_fd(int n, int events, void (*cb)(int, void*), void *v) {
+  if (n < 0) return;
+  if (epfd < 0) {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) return;
+  }
+  if (n >= fd_array_size) {
+    int size = 2*fd_array_size+1;
+    if (size <= n) size = n+1;
+    FD *temp = (FD*)realloc(fd, size*sizeof(FD));
+    if (!temp) return;
+    memset(temp + fd_array_size, 0, (size - fd_array_size)*sizeof(FD));
+    fd = temp;
+    fd_array_size = size;
+  }
+  int old_events = fd[n].events;
+  if (!old_events) nfds++;
+  for (int i = 0; i < 3; i++) {
+    if (events & fd_when[i]) {
+      fd[n].cb[i] = cb;
+      fd[n].arg[i] = v;
+      fd[n].events |= fd_when[i];
+    }
+  }
+  fd[n].edge = (events & FL_EDGE_TRIGGERED) ? 1 : 0;
+  // always update, the fd may have been closed and reopened since the last call
+  epoll_update(n, old_events);
+}
+
+void Fl_X11_System_Driver::add_fd(int n, void (*cb)(int, void*), void* v) {
+  add_fd(n, POLLIN, cb, v);
+}
+
+void Fl_X11_System_Driver::remove_fd(int n, int events) {
+  if (n < 0 || n >= fd_array_size || !fd[n].events) return;
+  int old_events = fd[n].events;
+  for (int i = 0; i < 3; i++) {
+    if (events & fd_when[i]) {
+      fd[n].cb[i] = 0;
+      fd[n].arg[i] = 0;
+      fd[n].events &= ~fd_when[i];
+    }
+  }
+  if (fd[n].events == old_events) return;
+  if (!fd[n].events) { nfds--; fd[n].edge = 0; }
+  epoll_update(n, old_events);
+}
+
+void Fl_X11_System_Driver::remove_fd(int n) {
+  remove_fd(n, -1);
+}
+
+#  else // !USE_EPOLL
+
 #  if USE_POLL
 
 #    include <poll.h>
@@ -144,7 +249,7 @@ void Fl_X11_System_Driver::add_fd(int n, int events, void (*cb)(int, void*), voi
   fd[i].arg = v;
 #  if USE_POLL
   pollfds[i].fd = n;
-  pollfds[i].events = events;
+  pollfds[i].events = events & ~FL_EDGE_TRIGGERED;
 #  else
   fd[i].fd = n;
   fd[i].events = events;
@@ -200,6 +305,8 @@ void Fl_X11_System_Driver::remove_fd(int n) {
   remove_fd(n, -1);
 }
 
+#  endif /* USE_EPOLL */
+
 extern int fl_send_system_handlers(void *e);
 
 #if FLTK_CONSOLIDATE_MOTION
@@ -213,9 +320,10 @@ static void do_queued_events() {
   while (XEventsQueued(fl_display,QueuedAfterReading)) {
     XEvent xevent;
     XNextEvent(fl_display, &xevent);
-    if (fl_send_system_handlers(&xevent))
-      continue;
-    fl_handle(xevent);
+    FL_LOOP_STATS_START(t);
+    if (!fl_send_system_handlers(&xevent))
+      fl_handle(xevent);
+    FL_LOOP_STATS_END(t, EVENT, 0);
   }
   // we send FL_LEAVE only if the mouse did not enter some other window:
   if (!in_a_window) Fl::handle(FL_LEAVE, 0);
@@ -242,6 +350,53 @@ int Fl_X11_Screen_Driver::poll_or_select_with_delay(double time_to_wait) {
   // so we must check for already-read events:
   if (fl_display && XQLength(fl_display)) {do_queued_events(); return 1;}
 
+#  if USE_EPOLL
+  if (ready_size < nfds) {
+    int size = nfds < 256 ? nfds : 256; // more will be reported by the next call
+    if (size > ready_size) {
+      struct epoll_event *temp =
+        (struct epoll_event*)realloc(ready_events, size*sizeof(struct epoll_event));
+      if (temp) { ready_events = temp; ready_size = size; }
+    }
+  }
+  int n;
+
+  fl_unlock_function();
+
+  int ms = time_to_wait < 2147483.648 ? int(time_to_wait*1000 + .5) : -1;
+  FL_LOOP_STATS_START(wait_start);
+  if (ready_size > 0)
+    n = epoll_wait(epfd, ready_events, ready_size, ms);
+  else
+    n = ::poll(0, 0, ms);
+  FL_LOOP_STATS_END(wait_start, WAIT, 0);
+
+  fl_lock_function();
+
+  for (int i = 0; i < n; i++) {
+    int f = ready_events[i].data.fd;
+    unsigned int e = ready_events[i].events;
+    short revents = 0;
+    if (e & (EPOLLIN|EPOLLHUP|EPOLLERR)) revents |= POLLIN;
+    if (e & (EPOLLOUT|EPOLLERR)) revents |= POLLOUT;
+    if (e & (EPOLLPRI|EPOLLHUP|EPOLLERR)) revents |= POLLERR;
+    void (*done)(int, void*) = 0;
+    void *done_arg = 0;
+    for (int j = 0; j < 3; j++) {
+      // callbacks may remove this or other fd's, always look at the current state
+      if (f >= fd_array_size || !(revents & fd_when[j] & fd[f].events)) continue;
+      void (*cb)(int, void*) = fd[f].cb[j];
+      void *arg = fd[f].arg[j];
+      if (cb == done && arg == done_arg) continue; // same callback for several conditions
+      FL_LOOP_STATS_START(t);
+      cb(f, arg);
+      FL_LOOP_STATS_END(t, FD, cb);
+      done = cb;
+      done_arg = arg;
+    }
+  }
+  return n;
+#  else // !USE_EPOLL
 #  if !USE_POLL
   fd_set fdt[3];
   fdt[0] = fdsets[0];
@@ -252,6 +407,7 @@ int Fl_X11_Screen_Driver::poll_or_select_with_delay(double time_to_wait) {
 
   fl_unlock_function();
 
+  FL_LOOP_STATS_START(wait_start);
   if (time_to_wait < 2147483.648) {
 #  if USE_POLL
     n = ::poll(pollfds, nfds, int(time_to_wait*1000 + .5));
@@ -268,31 +424,47 @@ int Fl_X11_Screen_Driver::poll_or_select_with_delay(double time_to_wait) {
     n = ::select(maxfd+1,&fdt[0],&fdt[1],&fdt[2],0);
 #  endif
   }
+  FL_LOOP_STATS_END(wait_start, WAIT, 0);
 
   fl_lock_function();
 
   if (n > 0) {
     for (int i=0; i<nfds; i++) {
 #  if USE_POLL
-      if (pollfds[i].revents) fd[i].cb(pollfds[i].fd, fd[i].arg);
+      if (!pollfds[i].revents) continue;
+      FL_LOOP_STATS_START(t);
+      Fl_FD_Handler cb = fd[i].cb;
+      cb(pollfds[i].fd, fd[i].arg);
+      FL_LOOP_STATS_END(t, FD, cb);
 #  else
       int f = fd[i].fd;
       short revents = 0;
       if (FD_ISSET(f,&fdt[0])) revents |= POLLIN;
       if (FD_ISSET(f,&fdt[1])) revents |= POLLOUT;
       if (FD_ISSET(f,&fdt[2])) revents |= POLLERR;
-      if (fd[i].events & revents) fd[i].cb(f, fd[i].arg);
+      if (!(fd[i].events & revents)) continue;
+      FL_LOOP_STATS_START(t);
+      Fl_FD_Handler cb = fd[i].cb;
+      cb(f, fd[i].arg);
+      FL_LOOP_STATS_END(t, FD, cb);
 #  endif
     }
   }
   return n;
+#  endif /* USE_EPOLL */
 }
 
 // just like Fl_X11_Screen_Driver::poll_or_select_with_delay(0.0) except no callbacks are done:
 int Fl_X11_Screen_Driver::poll_or_select() {
   if (XQLength(fl_display)) return 1;
   if (!nfds) return 0; // nothing to select or poll
-#  if USE_POLL
+#  if USE_EPOLL
+  // poll the epoll descriptor itself, this doesn't consume any events
+  pollfd p;
+  p.fd = epfd;
+  p.events = POLLIN;
+  return ::poll(&p, 1, 0);
+#  elif USE_POLL
   return ::poll(pollfds, nfds, 0);
 #  else
   timeval t;
@@ -1236,6 +1408,34 @@ static void set_event_xy(Fl_Window *win) {
     Fl::e_is_click = 0;
 }
 
+extern void fl_reset_motion_history(); // in Fl.cxx
+extern void fl_add_motion_history();   // in Fl.cxx
+
+// Merges the MotionNotify events for the same window and with the same
+// button and modifier state that directly follow the current one in the
+// queue, see Fl::OPTION_COMPRESS_MOTION. Other events are never skipped,
+// so that the event order is kept. On return fl_xevent and the event
+// position are the ones of the last merged event.
+static void compress_motion(Fl_Window *window) {
+  static XEvent last;
+  fl_reset_motion_history();
+  fl_add_motion_history();
+  Window xid = fl_xevent->xmotion.window;
+  unsigned int state = fl_xevent->xmotion.state;
+  XEvent next;
+  while (XEventsQueued(fl_display, QueuedAfterReading)) {
+    XPeekEvent(fl_display, &next);
+    if (next.type != MotionNotify || next.xmotion.window != xid ||
+        next.xmotion.state != state) break;
+    XNextEvent(fl_display, &next);
+    if (fl_send_system_handlers(&next)) continue;
+    last = next;
+    fl_xevent = &last;
+    set_event_xy(window);
+    fl_add_motion_history();
+  }
+}
+
 // if this is same event as last && is_click, increment click count:
 static inline void checkdouble() {
   if (Fl::e_is_click == Fl::e_keysym)
@@ -2152,6 +2352,7 @@ int fl_handle(const XEvent& thisevent)
     send_motion = fl_xmousewin = window;
     return 0;
 #  else
+    if (Fl::option(Fl::OPTION_COMPRESS_MOTION)) compress_motion(window);
     event = FL_MOVE;
     break;
 #  endif
@@ -2212,6 +2413,14 @@ int fl_handle(const XEvent& thisevent)
   case ConfigureNotify: {
     if (window->parent()) break; // ignore child windows
 
+    // While the user drags the window border, the window manager sends a
+    // ConfigureNotify event for every intermediate size. The geometry is
+    // read from the server below, so configure events that are already
+    // queued for this window are outdated: drop them, so that the window
+    // is laid out only once for the latest size.
+    XEvent pending;
+    while (XCheckTypedWindowEvent(fl_display, fl_xid(window), ConfigureNotify, &pending)) {}
+
     // figure out where OS really put window
     XWindowAttributes actual;
     XGetWindowAttributes(fl_display, fl_xid(window), &actual);
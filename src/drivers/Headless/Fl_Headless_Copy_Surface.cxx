@@ -0,0 +1,68 @@
+//
+// Copy-to-clipboard code for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <config.h>
+#include <FL/Fl_Copy_Surface.H>
+#include "Fl_Headless_Graphics_Driver.H"
+
+// The clipboard of the headless driver only holds text: the drawing
+// is done into a buffer that is discarded when the surface is deleted.
+class Fl_Headless_Copy_Surface_Driver : public Fl_Copy_Surface_Driver {
+  friend class Fl_Copy_Surface_Driver;
+protected:
+  Fl_Headless_Buffer *buffer;
+  Fl_Headless_Copy_Surface_Driver(int w, int h);
+  ~Fl_Headless_Copy_Surface_Driver();
+  void set_current();
+  void translate(int x, int y);
+  void untranslate();
+};
+
+
+Fl_Copy_Surface_Driver *Fl_Copy_Surface_Driver::newCopySurfaceDriver(int w, int h)
+{
+  return new Fl_Headless_Copy_Surface_Driver(w, h);
+}
+
+
+Fl_Headless_Copy_Surface_Driver::Fl_Headless_Copy_Surface_Driver(int w, int h) : Fl_Copy_Surface_Driver(w, h) {
+  buffer = Fl_Headless_Buffer::create(w, h);
+  Fl_Headless_Graphics_Driver *d = new Fl_Headless_Graphics_Driver();
+  d->target(buffer);
+  driver(d);
+}
+
+
+Fl_Headless_Copy_Surface_Driver::~Fl_Headless_Copy_Surface_Driver() {
+  if (is_current()) end_current();
+  delete driver();
+  Fl_Headless_Buffer::destroy(buffer);
+}
+
+
+void Fl_Headless_Copy_Surface_Driver::set_current() {
+  Fl_Surface_Device::set_current();
+}
+
+
+void Fl_Headless_Copy_Surface_Driver::translate(int x, int y) {
+  ((Fl_Headless_Graphics_Driver*)driver())->translate_all(x, y);
+}
+
+
+void Fl_Headless_Copy_Surface_Driver::untranslate() {
+  ((Fl_Headless_Graphics_Driver*)driver())->untranslate_all();
+}
@@ -0,0 +1,846 @@
+//
+// Rectangle drawing routines for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <config.h>
+#include "Fl_Headless_Graphics_Driver.H"
+#include <FL/Fl.H>
+#include <FL/fl_draw.H>
+#include <FL/fl_utf8.h>
+#include <FL/Fl_RGB_Image.H>
+#include <FL/Fl_Pixmap.H>
+#include <FL/Fl_Bitmap.H>
+#include <FL/math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Clip regions of the headless driver are simple rectangles.
+struct Fl_Headless_Region {
+  int x, y, w, h;
+};
+
+
+/*
+ * By linking this module, the following static method will instantiate the
+ * headless Graphics driver as the main display driver.
+ */
+Fl_Graphics_Driver *Fl_Graphics_Driver::newMainGraphicsDriver()
+{
+  return new Fl_Headless_Graphics_Driver();
+}
+
+
+Fl_Headless_Buffer *Fl_Headless_Buffer::create(int w, int h)
+{
+  Fl_Headless_Buffer *b = new Fl_Headless_Buffer;
+  b->w = b->h = 0;
+  b->pixels = 0;
+  b->resize(w, h);
+  return b;
+}
+
+
+void Fl_Headless_Buffer::destroy(Fl_Headless_Buffer *b)
+{
+  if (!b) return;
+  free(b->pixels);
+  delete b;
+}
+
+
+// Resizes the buffer, keeps the overlapping part and fills new pixels with white.
+void Fl_Headless_Buffer::resize(int W, int H)
+{
+  if (W < 1) W = 1;
+  if (H < 1) H = 1;
+  if (W == w && H == h && pixels) return;
+  unsigned *p = (unsigned*)malloc(W * H * sizeof(unsigned));
+  for (int y = 0; y < H; y++) {
+    unsigned *row = p + y * W;
+    int keep = 0;
+    if (y < h) {
+      keep = (W < w ? W : w);
+      memcpy(row, pixels + y * w, keep * sizeof(unsigned));
+    }
+    for (int x = keep; x < W; x++) row[x] = 0xffffffff;
+  }
+  free(pixels);
+  pixels = p;
+  w = W;
+  h = H;
+}
+
+
+Fl_Headless_Graphics_Driver::Fl_Headless_Graphics_Driver()
+: target_(0), ox_(0), oy_(0),
+  bx0_(0), by0_(0), bx1_(0), by1_(0),
+  cx0_(0), cy0_(0), cx1_(0), cy1_(0),
+  depth_(0), pixel_(0xff000000),
+  vertex_(0), num_vertex_(0), alloc_vertex_(0),
+  contour_(0), num_contour_(0), alloc_contour_(0)
+{
+}
+
+
+Fl_Headless_Graphics_Driver::~Fl_Headless_Graphics_Driver()
+{
+  free(vertex_);
+  free(contour_);
+}
+
+
+/**
+ Sets the buffer to draw into.
+ Drawing coordinates (0, 0) are at (\p ox, \p oy) of the buffer, and only the
+ area \p x, \p y, \p w, \p h of the buffer is changed (all of it if \p w < 0).
+ */
+void Fl_Headless_Graphics_Driver::target(Fl_Headless_Buffer *buffer, int ox, int oy,
+                                         int x, int y, int w, int h)
+{
+  target_ = buffer;
+  ox_ = ox; oy_ = oy;
+  depth_ = 0;
+  if (!buffer) {
+    bx0_ = by0_ = bx1_ = by1_ = 0;
+  } else if (w < 0) {
+    bx0_ = by0_ = 0;
+    bx1_ = buffer->w; by1_ = buffer->h;
+  } else {
+    bx0_ = x > 0 ? x : 0;
+    by0_ = y > 0 ? y : 0;
+    bx1_ = x + w < buffer->w ? x + w : buffer->w;
+    by1_ = y + h < buffer->h ? y + h : buffer->h;
+  }
+  update_clip();
+}
+
+
+void Fl_Headless_Graphics_Driver::translate_all(int dx, int dy)
+{
+  if (depth_ < (int)(sizeof(stack_x_) / sizeof(stack_x_[0]))) {
+    stack_x_[depth_] = ox_;
+    stack_y_[depth_] = oy_;
+  }
+  depth_++;
+  ox_ += dx; oy_ += dy;
+  update_clip();
+}
+
+
+void Fl_Headless_Graphics_Driver::untranslate_all()
+{
+  if (depth_ <= 0) return;
+  depth_--;
+  if (depth_ < (int)(sizeof(stack_x_) / sizeof(stack_x_[0]))) {
+    ox_ = stack_x_[depth_];
+    oy_ = stack_y_[depth_];
+  }
+  update_clip();
+}
+
+
+// Computes the current clip area from the drawable area and the clip stack.
+void Fl_Headless_Graphics_Driver::update_clip()
+{
+  cx0_ = bx0_; cy0_ = by0_; cx1_ = bx1_; cy1_ = by1_;
+  Fl_Headless_Region *r = (Fl_Headless_Region*)rstack[rstackptr];
+  if (r) {
+    if (r->x + ox_ > cx0_) cx0_ = r->x + ox_;
+    if (r->y + oy_ > cy0_) cy0_ = r->y + oy_;
+    if (r->x + r->w + ox_ < cx1_) cx1_ = r->x + r->w + ox_;
+    if (r->y + r->h + oy_ < cy1_) cy1_ = r->y + r->h + oy_;
+  }
+  if (cx1_ < cx0_) cx1_ = cx0_;
+  if (cy1_ < cy0_) cy1_ = cy0_;
+}
+
+
+// Fills the pixels x0..x1 (inclusive) of row y of the target with the current color.
+void Fl_Headless_Graphics_Driver::span(int x0, int x1, int y)
+{
+  if (y < cy0_ || y >= cy1_) return;
+  if (x0 < cx0_) x0 = cx0_;
+  if (x1 >= cx1_) x1 = cx1_ - 1;
+  if (x1 < x0) return;
+  unsigned *p = target_->pixels + y * target_->w + x0, *e = p + (x1 - x0 + 1);
+  while (p < e) *p++ = pixel_;
+}
+
+
+// Blends one pixel of the target with the color rgb (0xRRGGBB).
+void Fl_Headless_Graphics_Driver::put(int x, int y, unsigned rgb, uchar alpha)
+{
+  if (x < cx0_ || x >= cx1_ || y < cy0_ || y >= cy1_ || !alpha) return;
+  unsigned *p = target_->pixels + y * target_->w + x;
+  if (alpha == 255) {
+    *p = 0xff000000 | rgb;
+    return;
+  }
+  unsigned d = *p, a = alpha, na = 255 - alpha;
+  unsigned r = (((rgb >> 16) & 0xff) * a + ((d >> 16) & 0xff) * na) / 255;
+  unsigned g = (((rgb >> 8) & 0xff) * a + ((d >> 8) & 0xff) * na) / 255;
+  unsigned b = ((rgb & 0xff) * a + (d & 0xff) * na) / 255;
+  *p = 0xff000000 | (r << 16) | (g << 8) | b;
+}
+
+
+void Fl_Headless_Graphics_Driver::point(int x, int y)
+{
+  x += ox_; y += oy_;
+  if (x < cx0_ || x >= cx1_ || y < cy0_ || y >= cy1_) return;
+  target_->pixels[y * target_->w + x] = pixel_;
+}
+
+
+void Fl_Headless_Graphics_Driver::rectf(int x, int y, int w, int h)
+{
+  if (w <= 0 || h <= 0) return;
+  int x0 = x + ox_, y0 = y + oy_, x1 = x0 + w, y1 = y0 + h;
+  if (x0 < cx0_) x0 = cx0_;
+  if (y0 < cy0_) y0 = cy0_;
+  if (x1 > cx1_) x1 = cx1_;
+  if (y1 > cy1_) y1 = cy1_;
+  if (x1 <= x0) return;
+  for (int j = y0; j < y1; j++) {
+    unsigned *p = target_->pixels + j * target_->w + x0, *e = p + (x1 - x0);
+    while (p < e) *p++ = pixel_;
+  }
+}
+
+
+void Fl_Headless_Graphics_Driver::colored_rectf(int x, int y, int w, int h, uchar r, uchar g, uchar b)
+{
+  unsigned save = pixel_;
+  pixel_ = 0xff000000 | (r << 16) | (g << 8) | b;
+  rectf(x, y, w, h);
+  pixel_ = save;
+}
+
+
+void Fl_Headless_Graphics_Driver::xyline(int x, int y, int x1)
+{
+  if (x1 < x) { int t = x; x = x1; x1 = t; }
+  span(x + ox_, x1 + ox_, y + oy_);
+}
+
+
+void Fl_Headless_Graphics_Driver::yxline(int x, int y, int y1)
+{
+  if (y1 < y) { int t = y; y = y1; y1 = t; }
+  for (int j = y; j <= y1; j++) point(x, j);
+}
+
+
+void Fl_Headless_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2)
+{
+  begin_polygon();
+  add_vertex((float)x0, (float)y0);
+  add_vertex((float)x1, (float)y1);
+  add_vertex((float)x2, (float)y2);
+  end_polygon();
+}
+
+
+void Fl_Headless_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3)
+{
+  begin_polygon();
+  add_vertex((float)x0, (float)y0);
+  add_vertex((float)x1, (float)y1);
+  add_vertex((float)x2, (float)y2);
+  add_vertex((float)x3, (float)y3);
+  end_polygon();
+}
+
+
+// --- clipping
+
+void Fl_Headless_Graphics_Driver::push_clip(int x, int y, int w, int h)
+{
+  Fl_Headless_Region *r = new Fl_Headless_Region;
+  if (w < 0) w = 0;
+  if (h < 0) h = 0;
+  Fl_Headless_Region *current = (Fl_Headless_Region*)rstack[rstackptr];
+  if (current) {
+    int x1 = x + w, y1 = y + h;
+    if (current->x > x) x = current->x;
+    if (current->y > y) y = current->y;
+    if (current->x + current->w < x1) x1 = current->x + current->w;
+    if (current->y + current->h < y1) y1 = current->y + current->h;
+    w = x1 > x ? x1 - x : 0;
+    h = y1 > y ? y1 - y : 0;
+  }
+  r->x = x; r->y = y; r->w = w; r->h = h;
+  if (rstackptr < region_stack_max) rstack[++rstackptr] = (Fl_Region)r;
+  else {
+    Fl::warning("Fl_Headless_Graphics_Driver::push_clip: clip stack overflow!\n");
+    delete r;
+  }
+  restore_clip();
+}
+
+
+int Fl_Headless_Graphics_Driver::clip_box(int x, int y, int w, int h, int &X, int &Y, int &W, int &H)
+{
+  int x0 = x, y0 = y, x1 = x + w, y1 = y + h;
+  if (cx0_ - ox_ > x0) x0 = cx0_ - ox_;
+  if (cy0_ - oy_ > y0) y0 = cy0_ - oy_;
+  if (cx1_ - ox_ < x1) x1 = cx1_ - ox_;
+  if (cy1_ - oy_ < y1) y1 = cy1_ - oy_;
+  X = x0; Y = y0;
+  W = x1 > x0 ? x1 - x0 : 0;
+  H = y1 > y0 ? y1 - y0 : 0;
+  return (X != x || Y != y || W != w || H != h);
+}
+
+
+int Fl_Headless_Graphics_Driver::not_clipped(int x, int y, int w, int h)
+{
+  x += ox_; y += oy_;
+  return (x + w > cx0_ && x < cx1_ && y + h > cy0_ && y < cy1_);
+}
+
+
+void Fl_Headless_Graphics_Driver::push_no_clip()
+{
+  Fl_Graphics_Driver::push_no_clip();
+}
+
+
+void Fl_Headless_Graphics_Driver::pop_clip()
+{
+  Fl_Graphics_Driver::pop_clip();
+}
+
+
+void Fl_Headless_Graphics_Driver::restore_clip()
+{
+  Fl_Graphics_Driver::restore_clip();
+  update_clip();
+}
+
+
+void Fl_Headless_Graphics_Driver::add_rectangle_to_region(Fl_Region r, int x, int y, int w, int h)
+{
+  Fl_Headless_Region *R = (Fl_Headless_Region*)r;
+  if (w <= 0 || h <= 0) return;
+  if (R->w <= 0 || R->h <= 0) {
+    R->x = x; R->y = y; R->w = w; R->h = h;
+    return;
+  }
+  int x1 = R->x + R->w > x + w ? R->x + R->w : x + w;
+  int y1 = R->y + R->h > y + h ? R->y + R->h : y + h;
+  if (x < R->x) R->x = x;
+  if (y < R->y) R->y = y;
+  R->w = x1 - R->x;
+  R->h = y1 - R->y;
+}
+
+
+Fl_Region Fl_Headless_Graphics_Driver::XRectangleRegion(int x, int y, int w, int h)
+{
+  Fl_Headless_Region *r = new Fl_Headless_Region;
+  r->x = x; r->y = y; r->w = w; r->h = h;
+  return (Fl_Region)r;
+}
+
+
+void Fl_Headless_Graphics_Driver::XDestroyRegion(Fl_Region r)
+{
+  delete (Fl_Headless_Region*)r;
+}
+
+
+// --- complex shapes
+
+void Fl_Headless_Graphics_Driver::add_vertex(float x, float y)
+{
+  if (num_vertex_ > contour_[num_contour_ - 1] &&
+      vertex_[2 * num_vertex_ - 2] == x && vertex_[2 * num_vertex_ - 1] == y)
+    return;
+  if (num_vertex_ >= alloc_vertex_) {
+    alloc_vertex_ = alloc_vertex_ ? 2 * alloc_vertex_ : 64;
+    vertex_ = (float*)realloc(vertex_, 2 * alloc_vertex_ * sizeof(float));
+  }
+  vertex_[2 * num_vertex_] = x;
+  vertex_[2 * num_vertex_ + 1] = y;
+  num_vertex_++;
+}
+
+
+void Fl_Headless_Graphics_Driver::begin_points()
+{
+  begin_line();
+  what = POINT_;
+}
+
+
+void Fl_Headless_Graphics_Driver::begin_line()
+{
+  what = LINE;
+  num_vertex_ = 0;
+  if (!alloc_contour_) {
+    alloc_contour_ = 16;
+    contour_ = (int*)malloc(alloc_contour_ * sizeof(int));
+  }
+  contour_[0] = 0;
+  num_contour_ = 1;
+}
+
+
+void Fl_Headless_Graphics_Driver::begin_loop()
+{
+  begin_line();
+  what = LOOP;
+}
+
+
+void Fl_Headless_Graphics_Driver::begin_polygon()
+{
+  begin_line();
+  what = POLYGON;
+}
+
+
+void Fl_Headless_Graphics_Driver::begin_complex_polygon()
+{
+  begin_line();
+  what = POLYGON;
+}
+
+
+void Fl_Headless_Graphics_Driver::transformed_vertex(double xf, double yf)
+{
+  if (!num_contour_) begin_line();
+  add_vertex((float)xf, (float)yf);
+}
+
+
+void Fl_Headless_Graphics_Driver::gap()
+{
+  if (!num_contour_ || num_vertex_ == contour_[num_contour_ - 1]) return;
+  if (num_contour_ >= alloc_contour_) {
+    alloc_contour_ *= 2;
+    contour_ = (int*)realloc(contour_, alloc_contour_ * sizeof(int));
+  }
+  contour_[num_contour_++] = num_vertex_;
+}
+
+
+void Fl_Headless_Graphics_Driver::end_points()
+{
+  for (int i = 0; i < num_vertex_; i++)
+    point((int)floor(vertex_[2 * i] + 0.5f), (int)floor(vertex_[2 * i + 1] + 0.5f));
+  num_vertex_ = num_contour_ = 0;
+}
+
+
+void Fl_Headless_Graphics_Driver::end_line()
+{
+  stroke_contours(0);
+}
+
+
+void Fl_Headless_Graphics_Driver::end_loop()
+{
+  stroke_contours(1);
+}
+
+
+void Fl_Headless_Graphics_Driver::end_polygon()
+{
+  fill_contours(num_contour_);
+}
+
+
+void Fl_Headless_Graphics_Driver::end_complex_polygon()
+{
+  fill_contours(num_contour_);
+}
+
+
+void Fl_Headless_Graphics_Driver::stroke_contours(int closed)
+{
+  for (int c = 0; c < num_contour_; c++) {
+    int s = contour_[c], e = (c + 1 < num_contour_) ? contour_[c + 1] : num_vertex_;
+    if (e - s == 1) {
+      point((int)floor(vertex_[2 * s] + 0.5f), (int)floor(vertex_[2 * s + 1] + 0.5f));
+      continue;
+    }
+    for (int i = s + 1; i < e; i++)
+      line((int)floor(vertex_[2 * i - 2] + 0.5f), (int)floor(vertex_[2 * i - 1] + 0.5f),
+           (int)floor(vertex_[2 * i] + 0.5f), (int)floor(vertex_[2 * i + 1] + 0.5f));
+    if (closed && e - s > 2)
+      line((int)floor(vertex_[2 * e - 2] + 0.5f), (int)floor(vertex_[2 * e - 1] + 0.5f),
+           (int)floor(vertex_[2 * s] + 0.5f), (int)floor(vertex_[2 * s + 1] + 0.5f));
+  }
+  num_vertex_ = num_contour_ = 0;
+}
+
+
+// Fills the collected contours with the even-odd rule, sampling pixel centers.
+void Fl_Headless_Graphics_Driver::fill_contours(int num_contours)
+{
+  static float *xs = 0;
+  static int alloc_xs = 0;
+  if (num_vertex_ < 3 || !num_contours) {
+    stroke_contours(0);
+    return;
+  }
+  float ymin = vertex_[1], ymax = vertex_[1];
+  for (int i = 1; i < num_vertex_; i++) {
+    if (vertex_[2 * i + 1] < ymin) ymin = vertex_[2 * i + 1];
+    if (vertex_[2 * i + 1] > ymax) ymax = vertex_[2 * i + 1];
+  }
+  int y0 = (int)floor(ymin), y1 = (int)ceil(ymax);
+  if (y0 < cy0_ - oy_) y0 = cy0_ - oy_;
+  if (y1 > cy1_ - oy_) y1 = cy1_ - oy_;
+  if (alloc_xs < num_vertex_) {
+    alloc_xs = num_vertex_;
+    xs = (float*)realloc(xs, alloc_xs * sizeof(float));
+  }
+  for (int y = y0; y < y1; y++) {
+    float sy = y + 0.5f;
+    int n = 0;
+    for (int c = 0; c < num_contours; c++) {
+      int s = contour_[c], e = (c + 1 < num_contour_) ? contour_[c + 1] : num_vertex_;
+      if (e - s < 2) continue;
+      for (int i = s; i < e; i++) {
+        int j = (i + 1 < e) ? i + 1 : s;
+        float ax = vertex_[2 * i], ay = vertex_[2 * i + 1];
+        float bx = vertex_[2 * j], by = vertex_[2 * j + 1];
+        if ((ay <= sy && by > sy) || (by <= sy && ay > sy))
+          xs[n++] = ax + (sy - ay) * (bx - ax) / (by - ay);
+      }
+    }
+    for (int i = 1; i < n; i++) { // insertion sort, n is small
+      float v = xs[i];
+      int k = i - 1;
+      while (k >= 0 && xs[k] > v) { xs[k + 1] = xs[k]; k--; }
+      xs[k + 1] = v;
+    }
+    for (int i = 0; i + 1 < n; i += 2) {
+      int xa = (int)ceil(xs[i] - 0.5f), xb = (int)ceil(xs[i + 1] - 0.5f) - 1;
+      if (xb >= xa) span(xa + ox_, xb + ox_, y + oy_);
+    }
+  }
+  num_vertex_ = num_contour_ = 0;
+}
+
+
+void Fl_Headless_Graphics_Driver::circle(double x, double y, double r)
+{
+  double rx = fabs(transform_dx(r, r));
+  double ry = fabs(transform_dy(r, r));
+  int segs = (int)(M_PI * (rx + ry) / 3); // every line is about three pixels long
+  if (segs < 16) segs = 16;
+  gap();
+  for (int i = 0; i < segs; i++) {
+    double a = 2 * M_PI * i / segs;
+    vertex(x + r * cos(a), y + r * sin(a));
+  }
+  gap();
+}
+
+
+void Fl_Headless_Graphics_Driver::arc(int x, int y, int w, int h, double a1, double a2)
+{
+  if (w <= 0 || h <= 0 || a2 == a1) return;
+  double rx = (w - 1) / 2.0, ry = (h - 1) / 2.0;
+  double cx = x + rx, cy = y + ry;
+  int segs = (int)(fabs(a2 - a1) * M_PI * (rx + ry) / 720);
+  if (segs < 4) segs = 4;
+  int px = 0, py = 0;
+  for (int i = 0; i <= segs; i++) {
+    double a = (a1 + (a2 - a1) * i / segs) * M_PI / 180;
+    int nx = (int)floor(cx + rx * cos(a) + 0.5), ny = (int)floor(cy - ry * sin(a) + 0.5);
+    if (i) line(px, py, nx, ny);
+    px = nx; py = ny;
+  }
+}
+
+
+void Fl_Headless_Graphics_Driver::pie(int x, int y, int w, int h, double a1, double a2)
+{
+  if (w <= 0 || h <= 0 || a2 == a1) return;
+  double rx = w / 2.0, ry = h / 2.0;
+  double cx = x + rx, cy = y + ry;
+  int segs = (int)(fabs(a2 - a1) * M_PI * (rx + ry) / 720);
+  if (segs < 4) segs = 4;
+  begin_polygon();
+  if (fabs(a2 - a1) < 360) add_vertex((float)cx, (float)cy);
+  for (int i = 0; i <= segs; i++) {
+    double a = (a1 + (a2 - a1) * i / segs) * M_PI / 180;
+    add_vertex((float)(cx + rx * cos(a)), (float)(cy - ry * sin(a)));
+  }
+  end_polygon();
+}
+
+
+// --- colors and text
+
+void Fl_Headless_Graphics_Driver::color(Fl_Color c)
+{
+  Fl_Graphics_Driver::color(c);
+  uchar r, g, b;
+  Fl::get_color(c, r, g, b);
+  pixel_ = 0xff000000 | (r << 16) | (g << 8) | b;
+}
+
+
+void Fl_Headless_Graphics_Driver::color(uchar r, uchar g, uchar b)
+{
+  Fl_Graphics_Driver::color(fl_rgb_color(r, g, b));
+  pixel_ = 0xff000000 | (r << 16) | (g << 8) | b;
+}
+
+
+// Draws UTF-8 text. Characters outside the ASCII range take up space but
+// have no glyph in the Pico vector font.
+void Fl_Headless_Graphics_Driver::draw(const char *str, int n, int x, int y)
+{
+  const char *end = str + n;
+  double fx = x;
+  while (str < end) {
+    int len = fl_utf8len1(*str);
+    if (len < 1) len = 1;
+    if (len > end - str) len = (int)(end - str);
+    if (len == 1) Fl_Pico_Graphics_Driver::draw(str, 1, (int)(fx + 0.5), y);
+    fx += size_ * 0.5;
+    str += len;
+  }
+}
+
+
+double Fl_Headless_Graphics_Driver::width(const char *str, int n)
+{
+  return fl_utf_nb_char((const unsigned char*)str, n) * size_ * 0.5;
+}
+
+
+double Fl_Headless_Graphics_Driver::width(unsigned int c)
+{
+  return size_ * 0.5;
+}
+
+
+// All fonts are drawn with the same vector font, but their names are
+// kept so that Fl::get_font() and Fl::set_font() work.
+static Fl_Fontdesc built_in_table[] = {
+{"Helvetica"},
+{"Helvetica Bold"},
+{"Helvetica Italic"},
+{"Helvetica Bold Italic"},
+{"Courier"},
+{"Courier Bold"},
+{"Courier Italic"},
+{"Courier Bold Italic"},
+{"Times"},
+{"Times Bold"},
+{"Times Italic"},
+{"Times Bold Italic"},
+{"Symbol"},
+{"Screen"},
+{"Screen Bold"},
+{"Zapf Dingbats"}
+};
+
+Fl_Fontdesc* fl_fonts = built_in_table;
+
+
+const char* Fl_Headless_Graphics_Driver::get_font_name(Fl_Font fnum, int* ap)
+{
+  const char *name = fl_fonts[fnum].name;
+  if (!name) name = "";
+  if (ap) {
+    *ap = 0;
+    if (strstr(name, "Bold")) *ap |= FL_BOLD;
+    if (strstr(name, "Italic")) *ap |= FL_ITALIC;
+  }
+  return name;
+}
+
+
+int Fl_Headless_Graphics_Driver::get_font_sizes(Fl_Font fnum, int*& sizep)
+{
+  static int array[1] = {0};  // the vector font can be drawn at any size
+  sizep = array;
+  return 1;
+}
+
+
+Fl_Font Fl_Headless_Graphics_Driver::set_fonts(const char *name)
+{
+  return FL_FREE_FONT;
+}
+
+
+const char *Fl_Headless_Graphics_Driver::font_name(int num)
+{
+  return fl_fonts[num].name;
+}
+
+
+void Fl_Headless_Graphics_Driver::font_name(int num, const char *name)
+{
+  Fl_Fontdesc *s = fl_fonts + num;
+  s->name = name;
+  s->fontname[0] = 0;
+}
+
+
+// --- images
+
+void Fl_Headless_Graphics_Driver::draw_image(const uchar* buf, int X, int Y, int W, int H, int D, int L)
+{
+  int d = D < 0 ? -D : D;
+  if (!L) L = W * D;
+  for (int j = 0; j < H; j++) {
+    const uchar *p = buf + j * L;
+    for (int i = 0; i < W; i++, p += D) {
+      unsigned rgb = d >= 3 ? (p[0] << 16) | (p[1] << 8) | p[2] : p[0] * 0x010101;
+      put(X + i + ox_, Y + j + oy_, rgb, d == 4 ? p[3] : 255);
+    }
+  }
+}
+
+
+void Fl_Headless_Graphics_Driver::draw_image_mono(const uchar* buf, int X, int Y, int W, int H, int D, int L)
+{
+  if (!L) L = W * D;
+  for (int j = 0; j < H; j++) {
+    const uchar *p = buf + j * L;
+    for (int i = 0; i < W; i++, p += D)
+      put(X + i + ox_, Y + j + oy_, p[0] * 0x010101, 255);
+  }
+}
+
+
+void Fl_Headless_Graphics_Driver::draw_image(Fl_Draw_Image_Cb cb, void* data, int X, int Y, int W, int H, int D)
+{
+  int d = D < 0 ? -D : D;
+  uchar *line = (uchar*)malloc(W * d);
+  for (int j = 0; j < H; j++) {
+    cb(data, 0, j, W, line);
+    draw_image(line, X, Y + j, W, 1, d, 0);
+  }
+  free(line);
+}
+
+
+void Fl_Headless_Graphics_Driver::draw_image_mono(Fl_Draw_Image_Cb cb, void* data, int X, int Y, int W, int H, int D)
+{
+  int d = D < 0 ? -D : D;
+  uchar *line = (uchar*)malloc(W * d);
+  for (int j = 0; j < H; j++) {
+    cb(data, 0, j, W, line);
+    draw_image_mono(line, X, Y + j, W, 1, d, 0);
+  }
+  free(line);
+}
+
+
+// Draws the part cx, cy, W, H of an image of size img_w x img_h at X, Y.
+// The image data of size data_w x data_h is scaled to the image size.
+void Fl_Headless_Graphics_Driver::blit(const uchar *array, int d, int ld, int data_w, int data_h,
+                                       int img_w, int img_h, int X, int Y, int W, int H, int cx, int cy)
+{
+  for (int j = 0; j < H; j++) {
+    int sy = (int)((long)(cy + j) * data_h / img_h);
+    if (sy >= data_h) break;
+    const uchar *row = array + sy * ld;
+    for (int i = 0; i < W; i++) {
+      int sx = (int)((long)(cx + i) * data_w / img_w);
+      if (sx >= data_w) break;
+      const uchar *p = row + sx * d;
+      unsigned rgb;
+      uchar a = 255;
+      switch (d) {
+        case 1: rgb = p[0] * 0x010101; break;
+        case 2: rgb = p[0] * 0x010101; a = p[1]; break;
+        case 3: rgb = (p[0] << 16) | (p[1] << 8) | p[2]; break;
+        default: rgb = (p[0] << 16) | (p[1] << 8) | p[2]; a = p[3]; break;
+      }
+      put(X + i + ox_, Y + j + oy_, rgb, a);
+    }
+  }
+}
+
+
+void Fl_Headless_Graphics_Driver::draw_rgb(Fl_RGB_Image *rgb, int XP, int YP, int WP, int HP, int cx, int cy)
+{
+  if (!rgb->d() || !rgb->array) {
+    draw_empty(rgb, XP, YP);
+    return;
+  }
+  int X, Y, W, H;
+  if (start_image(rgb, XP, YP, WP, HP, cx, cy, X, Y, W, H)) return;
+  int ld = rgb->ld() ? rgb->ld() : rgb->data_w() * rgb->d();
+  blit(rgb->array, rgb->d(), ld, rgb->data_w(), rgb->data_h(),
+       rgb->w(), rgb->h(), X, Y, W, H, cx, cy);
+}
+
+
+// The cached form of an Fl_Pixmap is an RGBA Fl_RGB_Image.
+void Fl_Headless_Graphics_Driver::draw_pixmap(Fl_Pixmap *pxm, int XP, int YP, int WP, int HP, int cx, int cy)
+{
+  int X, Y, W, H;
+  if (start_image(pxm, XP, YP, WP, HP, cx, cy, X, Y, W, H)) return;
+  if (!*id(pxm)) *id(pxm) = (fl_uintptr_t)new Fl_RGB_Image(pxm);
+  Fl_RGB_Image *rgb = (Fl_RGB_Image*)*id(pxm);
+  blit(rgb->array, rgb->d(), rgb->data_w() * rgb->d(), rgb->data_w(), rgb->data_h(),
+       pxm->w(), pxm->h(), X, Y, W, H, cx, cy);
+}
+
+
+void Fl_Headless_Graphics_Driver::uncache_pixmap(fl_uintptr_t p)
+{
+  delete (Fl_RGB_Image*)p;
+}
+
+
+void Fl_Headless_Graphics_Driver::draw_bitmap(Fl_Bitmap *bm, int XP, int YP, int WP, int HP, int cx, int cy)
+{
+  int X, Y, W, H;
+  if (start_image(bm, XP, YP, WP, HP, cx, cy, X, Y, W, H)) return;
+  int data_w = bm->data_w(), data_h = bm->data_h(), ld = (data_w + 7) / 8;
+  unsigned rgb = pixel_ & 0xffffff;
+  for (int j = 0; j < H; j++) {
+    int sy = (int)((long)(cy + j) * data_h / bm->h());
+    if (sy >= data_h) break;
+    const uchar *row = bm->array + sy * ld;
+    for (int i = 0; i < W; i++) {
+      int sx = (int)((long)(cx + i) * data_w / bm->w());
+      if (sx >= data_w) break;
+      if (row[sx >> 3] & (1 << (sx & 7))) put(X + i + ox_, Y + j + oy_, rgb, 255);
+    }
+  }
+}
+
+
+void Fl_Headless_Graphics_Driver::copy_offscreen(int x, int y, int w, int h, Fl_Offscreen pixmap, int srcx, int srcy)
+{
+  Fl_Headless_Buffer *src = (Fl_Headless_Buffer*)pixmap;
+  if (!src) return;
+  for (int j = 0; j < h; j++) {
+    int sy = srcy + j;
+    if (sy < 0 || sy >= src->h) continue;
+    for (int i = 0; i < w; i++) {
+      int sx = srcx + i;
+      if (sx < 0 || sx >= src->w) continue;
+      put(x + i + ox_, y + j + oy_, src->pixels[sy * src->w + sx] & 0xffffff, 255);
+    }
+  }
+}
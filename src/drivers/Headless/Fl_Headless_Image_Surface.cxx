@@ -0,0 +1,75 @@
+//
+// Draw-to-image code for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <config.h>
+#include "Fl_Headless_Graphics_Driver.H"
+#include <FL/Fl_Image_Surface.H>
+#include <FL/platform.H>
+#include "../../Fl_Screen_Driver.H"
+
+class Fl_Headless_Image_Surface_Driver : public Fl_Image_Surface_Driver {
+  virtual void end_current();
+public:
+  Window pre_window;
+  Fl_Headless_Image_Surface_Driver(int w, int h, int high_res, Fl_Offscreen off);
+  ~Fl_Headless_Image_Surface_Driver();
+  void set_current();
+  void translate(int x, int y);
+  void untranslate();
+  Fl_RGB_Image *image();
+};
+
+Fl_Image_Surface_Driver *Fl_Image_Surface_Driver::newImageSurfaceDriver(int w, int h, int high_res, Fl_Offscreen off)
+{
+  return new Fl_Headless_Image_Surface_Driver(w, h, high_res, off);
+}
+
+Fl_Headless_Image_Surface_Driver::Fl_Headless_Image_Surface_Driver(int w, int h, int high_res, Fl_Offscreen off) : Fl_Image_Surface_Driver(w, h, high_res, off) {
+  if (!off) offscreen = (Fl_Offscreen)Fl_Headless_Buffer::create(w, h);
+  Fl_Headless_Graphics_Driver *d = new Fl_Headless_Graphics_Driver();
+  d->target((Fl_Headless_Buffer*)offscreen);
+  driver(d);
+}
+
+Fl_Headless_Image_Surface_Driver::~Fl_Headless_Image_Surface_Driver() {
+  if (offscreen && !external_offscreen) Fl_Headless_Buffer::destroy((Fl_Headless_Buffer*)offscreen);
+  delete driver();
+}
+
+void Fl_Headless_Image_Surface_Driver::set_current() {
+  Fl_Surface_Device::set_current();
+  pre_window = fl_window;
+  fl_window = 0;
+}
+
+void Fl_Headless_Image_Surface_Driver::translate(int x, int y) {
+  ((Fl_Headless_Graphics_Driver*)driver())->translate_all(x, y);
+}
+
+void Fl_Headless_Image_Surface_Driver::untranslate() {
+  ((Fl_Headless_Graphics_Driver*)driver())->untranslate_all();
+}
+
+Fl_RGB_Image* Fl_Headless_Image_Surface_Driver::image()
+{
+  return Fl::screen_driver()->read_win_rectangle(0, 0, width, height, 0);
+}
+
+void Fl_Headless_Image_Surface_Driver::end_current()
+{
+  fl_window = pre_window;
+  Fl_Surface_Device::end_current();
+}
@@ -0,0 +1,289 @@
+//
+// Definition of the headless screen interface
+// for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <config.h>
+#include "Fl_Headless_Screen_Driver.H"
+#include "Fl_Headless_System_Driver.H"
+#include "Fl_Headless_Window_Driver.H"
+#include "Fl_Headless_Graphics_Driver.H"
+#include "../../Fl_Timeout.h"
+#include "../../fl_loop_stats.h"
+#include <FL/Fl.H>
+#include <FL/platform.H>
+#include <FL/Fl_Image_Surface.H>
+#include <FL/Fl_RGB_Image.H>
+
+
+/**
+ Creates a driver that manages all screen and display related calls.
+
+ This function must be implemented once for every platform.
+ */
+Fl_Screen_Driver *Fl_Screen_Driver::newScreenDriver()
+{
+  return new Fl_Headless_Screen_Driver();
+}
+
+
+int Fl_Headless_Screen_Driver::screen_w = 1024;
+int Fl_Headless_Screen_Driver::screen_h = 768;
+int Fl_Headless_Screen_Driver::virtual_time = 0;
+double Fl_Headless_Screen_Driver::virtual_clock = 0.0;
+int Fl_Headless_Screen_Driver::mouse_x = 0;
+int Fl_Headless_Screen_Driver::mouse_y = 0;
+
+
+Fl_Headless_Screen_Driver::Fl_Headless_Screen_Driver()
+{
+}
+
+
+int Fl_Headless_Screen_Driver::w()
+{
+  return screen_w;
+}
+
+
+int Fl_Headless_Screen_Driver::h()
+{
+  return screen_h;
+}
+
+
+void Fl_Headless_Screen_Driver::screen_dpi(float &h, float &v, int n)
+{
+  h = 96.0;
+  v = 96.0;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+// Timeouts are stored with absolute deadlines in a heap (see Fl_Timeout.h),
+// exactly like on the X11 platform, but the clock may be virtual.
+
+static Fl_Timeout timeouts;
+
+// Time of the last clock sample, used as reference for repeat_timeout().
+static double timeout_clock;
+
+// I avoid the overhead of getting the current time when we have no
+// timeouts by setting this flag instead of getting the time.
+// In this case the next repeat_timeout() gets the current time first.
+static char reset_clock = 1;
+
+// How late we were at calling the last timeout (a number <= 0).
+static double missed_timeout_by;
+
+/** Returns the current time in seconds used for timeouts. */
+double Fl_Headless_Screen_Driver::now()
+{
+  return virtual_time ? virtual_clock : Fl_Timeout::now();
+}
+
+static void elapse_timeouts() {
+  timeout_clock = Fl_Headless_Screen_Driver::now();
+  reset_clock = 0;
+}
+
+
+double Fl_Headless_Screen_Driver::wait(double time_to_wait)
+{
+  static char in_idle;
+
+  if (!timeouts.empty()) {
+    elapse_timeouts();
+    Fl_Timeout_Handler cb;
+    void *argp;
+    double deadline;
+    // The timeout is removed from the queue before doing the callback,
+    // so it is safe for the callback to do add_timeout:
+    while (timeouts.pop_expired(timeout_clock, cb, argp, deadline)) {
+      missed_timeout_by = deadline - timeout_clock;
+      FL_LOOP_STATS_START(t);
+      cb(argp);
+      FL_LOOP_STATS_END(t, TIMEOUT, cb);
+    }
+  } else {
+    reset_clock = 1; // we are not going to check the clock
+  }
+  Fl::run_checks();
+  if (Fl::idle) {
+    if (!in_idle) {
+      in_idle = 1;
+      Fl::idle();
+      in_idle = 0;
+    }
+    // the idle function may turn off idle, we can then wait:
+    if (Fl::idle) time_to_wait = 0.0;
+  }
+  if (!timeouts.empty() && timeouts.next_time() - timeout_clock < time_to_wait)
+    time_to_wait = timeouts.next_time() - timeout_clock;
+  if (time_to_wait <= 0.0) {
+    // do flush second so that the results of events are visible:
+    int ret = Fl_Headless_System_Driver::poll_fds(0.0);
+    Fl::flush();
+    return ret;
+  }
+  // do flush first so that the framebuffers are up to date:
+  Fl::flush();
+  if (Fl::idle && !in_idle) // 'idle' may have been set within flush()
+    time_to_wait = 0.0;
+  else if (!timeouts.empty() && timeouts.next_time() - timeout_clock < time_to_wait) {
+    // another timeout may have been queued within flush(), see STR #3188
+    double t = timeouts.next_time() - timeout_clock;
+    time_to_wait = t >= 0.0 ? t : 0.0;
+  }
+  if (virtual_time && !timeouts.empty()) {
+    // don't sleep: handle pending file descriptors, then jump to the deadline
+    int ret = Fl_Headless_System_Driver::poll_fds(0.0);
+    if (ret <= 0) virtual_clock += time_to_wait;
+    return ret;
+  }
+  return Fl_Headless_System_Driver::poll_fds(time_to_wait);
+}
+
+
+int Fl_Headless_Screen_Driver::ready()
+{
+  if (!timeouts.empty()) {
+    elapse_timeouts();
+    if (timeouts.next_time() <= timeout_clock) return 1;
+  } else {
+    reset_clock = 1;
+  }
+  return Fl_Headless_System_Driver::fds_ready();
+}
+
+
+extern void fl_fix_focus(); // in Fl.cxx
+
+
+void Fl_Headless_Screen_Driver::grab(Fl_Window* win)
+{
+  if (win) {
+    Fl::grab_ = win;    // FIXME: Fl::grab_ "should be private", but we need
+                        // a way to *set* the variable from the driver!
+  } else if (Fl::grab()) {
+    Fl::grab_ = 0;
+    fl_fix_focus();
+  }
+}
+
+
+int Fl_Headless_Screen_Driver::get_mouse(int &x, int &y)
+{
+  x = mouse_x;
+  y = mouse_y;
+  return screen_num(x, y);
+}
+
+
+// There is no input method: like X11 without XIM, only insert
+// non-control characters that are not typed with modifiers.
+int Fl_Headless_Screen_Driver::compose(int &del)
+{
+  unsigned char ascii = (unsigned char)Fl::e_text[0];
+  if ((Fl::e_state & (FL_ALT | FL_META | FL_CTRL)) && !(ascii & 128)) {
+    del = 0;
+    return 0;
+  }
+  del = Fl::compose_state;
+  Fl::compose_state = 0;
+  return (ascii & ~31 && ascii != 127) ? 1 : 0;
+}
+
+
+void Fl_Headless_Screen_Driver::add_timeout(double time, Fl_Timeout_Handler cb, void *argp) {
+  add_timeout_id(time, cb, argp);
+}
+
+void Fl_Headless_Screen_Driver::repeat_timeout(double time, Fl_Timeout_Handler cb, void *argp) {
+  repeat_timeout_id(time, cb, argp);
+}
+
+Fl_Timeout_Id Fl_Headless_Screen_Driver::add_timeout_id(double time, Fl_Timeout_Handler cb, void *argp) {
+  elapse_timeouts();
+  missed_timeout_by = 0;
+  return repeat_timeout_id(time, cb, argp);
+}
+
+Fl_Timeout_Id Fl_Headless_Screen_Driver::repeat_timeout_id(double time, Fl_Timeout_Handler cb, void *argp) {
+  if (reset_clock) elapse_timeouts();
+  time += missed_timeout_by; if (time < -.05) time = 0;
+  return timeouts.add(timeout_clock + time, cb, argp);
+}
+
+int Fl_Headless_Screen_Driver::has_timeout(Fl_Timeout_Handler cb, void *argp) {
+  return timeouts.has(cb, argp);
+}
+
+void Fl_Headless_Screen_Driver::remove_timeout(Fl_Timeout_Handler cb, void *argp) {
+  timeouts.remove(cb, argp);
+}
+
+int Fl_Headless_Screen_Driver::has_timeout_id(Fl_Timeout_Id id) {
+  return timeouts.has(id);
+}
+
+void Fl_Headless_Screen_Driver::remove_timeout_id(Fl_Timeout_Id id) {
+  timeouts.remove(id);
+}
+
+
+// Reads a rectangle of the framebuffer of a window, or of the current offscreen if win is NULL.
+Fl_RGB_Image *Fl_Headless_Screen_Driver::read_win_rectangle(int X, int Y, int w, int h, Fl_Window *win,
+                                                            bool may_capture_subwins,
+                                                            bool *did_capture_subwins)
+{
+  Fl_Headless_Buffer *buffer;
+  if (win) {
+    if (!win->shown()) return NULL;
+    buffer = ((Fl_Headless_Window_Driver*)Fl_Window_Driver::driver(win))->buffer();
+    // subwindows are drawn into the framebuffer of their top-level window
+    for (Fl_Window *sub = win; sub->parent(); sub = sub->window()) {
+      X += sub->x();
+      Y += sub->y();
+    }
+  } else {
+    buffer = ((Fl_Headless_Graphics_Driver*)fl_graphics_driver)->target();
+  }
+  if (!buffer || w <= 0 || h <= 0) return NULL;
+  if (did_capture_subwins) *did_capture_subwins = may_capture_subwins;
+  uchar *p = new uchar[w * h * 3];
+  for (int j = 0; j < h; j++) {
+    uchar *q = p + j * w * 3;
+    for (int i = 0; i < w; i++, q += 3) {
+      int x = X + i, y = Y + j;
+      unsigned px = (x >= 0 && y >= 0 && x < buffer->w && y < buffer->h) ?
+                    buffer->pixels[y * buffer->w + x] : 0xffffffff;
+      q[0] = (uchar)(px >> 16);
+      q[1] = (uchar)(px >> 8);
+      q[2] = (uchar)px;
+    }
+  }
+  Fl_RGB_Image *rgb = new Fl_RGB_Image(p, w, h, 3);
+  rgb->alloc_array = 1;
+  return rgb;
+}
+
+
+void Fl_Headless_Screen_Driver::offscreen_size(Fl_Offscreen off, int &width, int &height)
+{
+  Fl_Headless_Buffer *buffer = (Fl_Headless_Buffer*)off;
+  width = buffer->w;
+  height = buffer->h;
+}
@@ -0,0 +1,312 @@
+//
+// Definition of the headless system driver
+// for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <config.h>
+#include "Fl_Headless_System_Driver.H"
+#include "../../fl_loop_stats.h"
+#include <FL/Fl.H>
+#include <FL/Fl_Widget.H>
+#include <FL/Fl_Native_File_Chooser.H>
+#include <FL/filename.H>
+#include "../../flstring.h"
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <locale.h>
+#include <unistd.h>
+#include <pwd.h>
+
+
+/**
+ Creates a driver that manages all system related calls.
+
+ This function must be implemented once for every platform.
+ */
+Fl_System_Driver *Fl_System_Driver::newSystemDriver()
+{
+  return new Fl_Headless_System_Driver();
+}
+
+
+// There are no native dialogs: always use the FLTK file chooser.
+Fl_Native_File_Chooser::Fl_Native_File_Chooser(int val) {
+  platform_fnfc = new Fl_Native_File_Chooser_FLTK_Driver(val);
+}
+
+
+////////////////////////////////////////////////////////////////
+// Keyboard state, one bit per FLTK key code
+
+static unsigned char key_vector[0x10000 / 8];
+
+void Fl_Headless_System_Driver::key_state(int k, int down)
+{
+  if (k < 0 || k > 0xffff) return;
+  if (down) key_vector[k >> 3] |= (unsigned char)(1 << (k & 7));
+  else key_vector[k >> 3] &= (unsigned char)~(1 << (k & 7));
+}
+
+int Fl_Headless_System_Driver::event_key(int k)
+{
+  if (k > FL_Button && k <= FL_Button+8)
+    return Fl::event_state(8<<(k-FL_Button));
+  if (k < 0 || k > 0xffff) return 0;
+  return (key_vector[k >> 3] >> (k & 7)) & 1;
+}
+
+int Fl_Headless_System_Driver::get_key(int k)
+{
+  return event_key(k);
+}
+
+
+////////////////////////////////////////////////////////////////
+// Selection (0) and clipboard (1), plain text only
+
+static char *selection_buffer[2];
+static int selection_length[2];
+static int selection_buffer_length[2];
+
+extern void fl_trigger_clipboard_notify(int source); // in Fl.cxx
+
+void Fl_Headless_System_Driver::copy(const char *stuff, int len, int clipboard, const char *type)
+{
+  if (!stuff || len<0) return;
+
+  if (clipboard >= 2) {
+    copy(stuff, len, 0, type);
+    copy(stuff, len, 1, type);
+    return;
+  }
+
+  if (len+1 > selection_buffer_length[clipboard]) {
+    delete[] selection_buffer[clipboard];
+    selection_buffer[clipboard] = new char[len+100];
+    selection_buffer_length[clipboard] = len+100;
+  }
+  memcpy(selection_buffer[clipboard], stuff, len);
+  selection_buffer[clipboard][len] = 0;
+  selection_length[clipboard] = len;
+  fl_trigger_clipboard_notify(clipboard);
+}
+
+void Fl_Headless_System_Driver::paste(Fl_Widget &receiver, int clipboard, const char *type)
+{
+  if (clipboard < 0 || clipboard > 1 || strcmp(type, Fl::clipboard_plain_text)) return;
+  Fl::e_text = selection_buffer[clipboard] ? selection_buffer[clipboard] : (char *)"";
+  Fl::e_length = selection_length[clipboard];
+  Fl::e_clipboard_type = Fl::clipboard_plain_text;
+  receiver.handle(FL_PASTE);
+}
+
+int Fl_Headless_System_Driver::clipboard_contains(const char *type)
+{
+  return selection_length[1] > 0 && !strcmp(type, Fl::clipboard_plain_text);
+}
+
+
+////////////////////////////////////////////////////////////////
+// File descriptors
+
+static pollfd *pollfds = 0;
+static int nfds = 0;
+static int fd_array_size = 0;
+struct FD {
+  void (*cb)(int, void*);
+  void* arg;
+};
+
+static FD *fd = 0;
+
+void Fl_Headless_System_Driver::add_fd(int n, int events, void (*cb)(int, void*), void *v) {
+  remove_fd(n,events);
+  int i = nfds++;
+  if (i >= fd_array_size) {
+    fd_array_size = 2*fd_array_size+1;
+    fd = (FD*)realloc(fd, fd_array_size*sizeof(FD));
+    pollfds = (pollfd*)realloc(pollfds, fd_array_size*sizeof(pollfd));
+  }
+  fd[i].cb = cb;
+  fd[i].arg = v;
+  pollfds[i].fd = n;
+  pollfds[i].events = events & ~FL_EDGE_TRIGGERED;
+}
+
+void Fl_Headless_System_Driver::add_fd(int n, void (*cb)(int, void*), void* v) {
+  add_fd(n, POLLIN, cb, v);
+}
+
+void Fl_Headless_System_Driver::remove_fd(int n, int events) {
+  int i,j;
+  for (i=j=0; i<nfds; i++) {
+    if (pollfds[i].fd == n) {
+      int e = pollfds[i].events & ~events;
+      if (!e) continue; // if no events left, delete this fd
+      pollfds[j].events = e;
+    }
+    // move it down in the array if necessary:
+    if (j<i) {
+      fd[j] = fd[i];
+      pollfds[j] = pollfds[i];
+    }
+    j++;
+  }
+  nfds = j;
+}
+
+void Fl_Headless_System_Driver::remove_fd(int n) {
+  remove_fd(n, -1);
+}
+
+// these pointers are set by the Fl::lock() function:
+static void nothing() {}
+void (*fl_lock_function)() = nothing;
+void (*fl_unlock_function)() = nothing;
+
+// This is never called with time_to_wait < 0.0:
+// It returns negative on error, 0 if nothing happens before
+// timeout, and >0 if any callbacks were done.
+int Fl_Headless_System_Driver::poll_fds(double time_to_wait)
+{
+  fl_unlock_function();
+
+  FL_LOOP_STATS_START(wait_start);
+  int n = ::poll(pollfds, nfds, time_to_wait < 2147483.648 ? int(time_to_wait*1000 + .5) : -1);
+  FL_LOOP_STATS_END(wait_start, WAIT, 0);
+
+  fl_lock_function();
+
+  if (n > 0) {
+    for (int i=0; i<nfds; i++) {
+      if (!pollfds[i].revents) continue;
+      FL_LOOP_STATS_START(t);
+      Fl_FD_Handler cb = fd[i].cb;
+      cb(pollfds[i].fd, fd[i].arg);
+      FL_LOOP_STATS_END(t, FD, cb);
+    }
+  }
+  return n;
+}
+
+// just like poll_fds(0.0) except no callbacks are done:
+int Fl_Headless_System_Driver::fds_ready()
+{
+  if (!nfds) return 0; // nothing to poll
+  return ::poll(pollfds, nfds, 0);
+}
+
+
+////////////////////////////////////////////////////////////////
+// File system and locale support, like on the X11 platform
+
+int Fl_Headless_System_Driver::clocale_printf(FILE *output, const char *format, va_list args) {
+  char *saved_locale = setlocale(LC_NUMERIC, NULL);
+  setlocale(LC_NUMERIC, "C");
+  int retval = vfprintf(output, format, args);
+  setlocale(LC_NUMERIC, saved_locale);
+  return retval;
+}
+
+const char *Fl_Headless_System_Driver::filename_name(const char *name) {
+  const char *p,*q;
+  if (!name) return (0);
+  for (p=q=name; *p;) if (*p++ == '/') q = p;
+  return q;
+}
+
+// File names are assumed to be UTF-8 encoded.
+int Fl_Headless_System_Driver::filename_list(const char *d,
+                                             dirent ***list,
+                                             int (*sort)(struct dirent **, struct dirent **),
+                                             char *errmsg, int errmsg_sz) {
+  if (errmsg && errmsg_sz>0) errmsg[0] = '\0';
+#if defined(HAVE_SCANDIR_POSIX)
+  int n = scandir(d, list, 0, (int(*)(const dirent **, const dirent **))sort);
+#else
+  int n = scandir(d, list, 0, (int(*)(const void*,const void*))sort);
+#endif
+  if (n==-1) {
+    if (errmsg) fl_snprintf(errmsg, errmsg_sz, "%s", strerror(errno));
+    return -1;
+  }
+
+  // append a '/' to all filenames that are directories
+  int dirlen = (int)strlen(d);
+  char *fullname = (char*)malloc(dirlen+FL_PATH_MAX+3);
+  memcpy(fullname, d, dirlen+1);
+  char *name = fullname + dirlen;
+  if (name!=fullname && name[-1]!='/')
+    *name++ = '/';
+
+  for (int i=0; i<n; i++) {
+    dirent *de = (*list)[i];
+    int len = (int)strlen(de->d_name);
+    if (len == 0 || de->d_name[len-1] == '/' || len > FL_PATH_MAX) continue;
+    memcpy(name, de->d_name, len+1);
+    if (!fl_filename_isdir(fullname)) continue;
+    dirent *newde = (dirent*)malloc(de->d_name - (char*)de + len + 2);
+    memcpy(newde, de, de->d_name - (char*)de);
+    memcpy(newde->d_name, de->d_name, len);
+    newde->d_name[len] = '/';
+    newde->d_name[len+1] = 0;
+    free(de);
+    (*list)[i] = newde;
+  }
+  free(fullname);
+
+  return n;
+}
+
+char *Fl_Headless_System_Driver::preference_rootnode(Fl_Preferences *prefs, Fl_Preferences::Root root,
+                                                     const char *vendor, const char *application)
+{
+  static char *filename = 0L;
+  if (!filename) filename = (char*)::calloc(1, FL_PATH_MAX);
+  const char *e;
+  switch (root&Fl_Preferences::ROOT_MASK) {
+    case Fl_Preferences::USER:
+      e = getenv("HOME");
+      // make sure that $HOME is set to an existing directory
+      if ( (e==0L) || (e[0]==0) || (::access(e, F_OK)==-1) ) {
+        struct passwd *pw = getpwuid(getuid());
+        e = pw ? pw->pw_dir : 0L;
+      }
+      if ( (e==0L) || (e[0]==0) || (::access(e, F_OK)==-1) ) {
+        return 0L;
+      } else {
+        strlcpy(filename, e, FL_PATH_MAX);
+        if (filename[strlen(filename)-1] != '/')
+          strlcat(filename, "/", FL_PATH_MAX);
+        strlcat(filename, ".fltk/", FL_PATH_MAX);
+      }
+      break;
+    case Fl_Preferences::SYSTEM:
+      strcpy(filename, "/etc/fltk/");
+      break;
+  }
+
+  // Make sure that the parameters are not NULL
+  if ( (vendor==0L) || (vendor[0]==0) )
+    vendor = "unknown";
+  if ( (application==0L) || (application[0]==0) )
+    application = "unknown";
+
+  snprintf(filename + strlen(filename), FL_PATH_MAX - strlen(filename),
+           "%s/%s.prefs", vendor, application);
+  return filename;
+}
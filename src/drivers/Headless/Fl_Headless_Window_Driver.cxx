@@ -0,0 +1,220 @@
+//
+// Definition of the headless window interface
+// for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <config.h>
+#include "Fl_Headless_Window_Driver.H"
+#include "Fl_Headless_Graphics_Driver.H"
+
+#include <FL/Fl.H>
+#include <FL/platform.H>
+#include <FL/Fl_Window.H>
+#include <FL/fl_draw.H>
+#include <FL/fl_ask.H>
+#include <string.h>
+
+
+Window fl_window;
+
+
+Fl_Window_Driver *Fl_Window_Driver::newWindowDriver(Fl_Window *w)
+{
+  return new Fl_Headless_Window_Driver(w);
+}
+
+
+Fl_Headless_Window_Driver::Fl_Headless_Window_Driver(Fl_Window *win)
+: Fl_Pico_Window_Driver(win),
+  buffer_(0),
+  frames_(0)
+{
+}
+
+
+Fl_Headless_Window_Driver::~Fl_Headless_Window_Driver()
+{
+  Fl_Headless_Buffer::destroy(buffer_);
+}
+
+
+/** Returns the framebuffer the window draws into, or NULL if it is not shown. */
+Fl_Headless_Buffer *Fl_Headless_Window_Driver::buffer()
+{
+  if (!shown()) return 0;
+  Fl_Window *top = pWindow->top_window();
+  return ((Fl_Headless_Window_Driver*)driver(top))->buffer_;
+}
+
+
+Fl_X *Fl_Headless_Window_Driver::makeWindow()
+{
+  static Window next_xid = 0;
+  Fl_Group::current(0);
+  if (parent() && !Fl_X::i(pWindow->window())) {
+    pWindow->set_visible();
+    return 0L;
+  }
+  Fl_X *x = new Fl_X;
+  other_xid = 0;
+  x->xid = ++next_xid;
+  x->w = pWindow;
+  x->region = 0;
+  if (!parent()) {
+    if (buffer_) buffer_->resize(w(), h());
+    else buffer_ = Fl_Headless_Buffer::create(w(), h());
+  }
+  x->next = Fl_X::first;
+  wait_for_expose_value = 0;
+  i(x);
+  Fl_X::first = x;
+
+  pWindow->set_visible();
+  pWindow->redraw();
+  int old_event = Fl::e_number;
+  pWindow->handle(Fl::e_number = FL_SHOW);
+  Fl::e_number = old_event;
+  // there is no window manager: a new top-level window gets the focus
+  if (!parent() && !pWindow->tooltip_window() && !pWindow->menu_window())
+    Fl::handle(FL_FOCUS, pWindow);
+
+  return x;
+}
+
+
+void Fl_Headless_Window_Driver::show()
+{
+  if (!shown()) {
+    makeWindow();
+  }
+}
+
+
+void Fl_Headless_Window_Driver::hide()
+{
+  Fl_X* ip = Fl_X::i(pWindow);
+  if (hide_common()) return;
+  if (ip->region) Fl_Graphics_Driver::default_driver().XDestroyRegion(ip->region);
+  if (fl_window == ip->xid) {
+    fl_window = 0;
+    ((Fl_Headless_Graphics_Driver&)Fl_Graphics_Driver::default_driver()).target(0);
+  }
+  Fl_Headless_Buffer::destroy(buffer_);
+  buffer_ = 0;
+  delete ip;
+}
+
+
+void Fl_Headless_Window_Driver::resize(int X, int Y, int W, int H)
+{
+  int is_a_move = (X != x() || Y != y());
+  int is_a_resize = (W != w() || H != h());
+  if (is_a_move) force_position(1);
+  else if (!is_a_resize) return;
+  if (is_a_resize) {
+    pWindow->Fl_Group::resize(X, Y, W, H);
+    if (!pWindow->resizable()) pWindow->size_range(w(), h(), w(), h());
+    if (shown()) {
+      if (buffer_) buffer_->resize(W, H);
+      pWindow->redraw();
+    }
+  } else {
+    x(X); y(Y);
+    if (parent() && shown()) pWindow->redraw();
+  }
+}
+
+
+void Fl_Headless_Window_Driver::make_current()
+{
+  if (!shown()) {
+    fl_alert("Fl_Window::make_current(), but window is not shown().");
+    Fl::fatal("Fl_Window::make_current(), but window is not shown().");
+  }
+  // subwindows draw into the framebuffer of the top-level window
+  int ox = 0, oy = 0;
+  for (Fl_Window *sub = pWindow; sub->parent(); sub = sub->window()) {
+    ox += sub->x();
+    oy += sub->y();
+  }
+  fl_window = fl_xid(pWindow);
+  ((Fl_Headless_Graphics_Driver&)Fl_Graphics_Driver::default_driver()).target(buffer(), ox, oy, ox, oy, w(), h());
+  fl_graphics_driver->clip_region(0);
+}
+
+
+// Draws all shown subwindows of a group again.
+static void flush_subwindows(Fl_Group *g)
+{
+  for (int i = 0; i < g->children(); i++) {
+    Fl_Widget *o = g->child(i);
+    Fl_Window *win = o->as_window();
+    if (win) {
+      if (win->shown() && win->visible()) {
+        win->damage(FL_DAMAGE_ALL);
+        Fl_Window_Driver::driver(win)->flush();
+        win->clear_damage();
+      }
+    } else if (o->as_group()) {
+      flush_subwindows(o->as_group());
+    }
+  }
+}
+
+
+void Fl_Headless_Window_Driver::flush()
+{
+  int all = pWindow->damage() & ~FL_DAMAGE_CHILD;
+  Fl_Window_Driver::flush();
+  // Subwindows share the framebuffer and there is no window system that
+  // clips them out: if the background was drawn, draw them again on top.
+  if (all) flush_subwindows(pWindow);
+}
+
+
+void Fl_Headless_Window_Driver::draw_end()
+{
+  frames_++;
+}
+
+
+int Fl_Headless_Window_Driver::scroll(int src_x, int src_y, int src_w, int src_h,
+                                      int dest_x, int dest_y,
+                                      void (*draw_area)(void*, int,int,int,int), void* data)
+{
+  Fl_Headless_Buffer *b = buffer();
+  if (!b) return 1;
+  for (Fl_Window *sub = pWindow; sub->parent(); sub = sub->window()) {
+    src_x += sub->x(); dest_x += sub->x();
+    src_y += sub->y(); dest_y += sub->y();
+  }
+  // clip source and destination to the framebuffer
+  int d = src_x < dest_x ? -src_x : -dest_x;
+  if (d > 0) { src_x += d; dest_x += d; src_w -= d; }
+  d = src_y < dest_y ? -src_y : -dest_y;
+  if (d > 0) { src_y += d; dest_y += d; src_h -= d; }
+  if ((d = src_x + src_w - b->w) > 0) src_w -= d;
+  if ((d = dest_x + src_w - b->w) > 0) src_w -= d;
+  if ((d = src_y + src_h - b->h) > 0) src_h -= d;
+  if ((d = dest_y + src_h - b->h) > 0) src_h -= d;
+  if (src_w <= 0 || src_h <= 0) return 0;
+  // copy the rows in an order that doesn't overwrite rows not yet copied
+  int first = 0, last = src_h, step = 1;
+  if (dest_y > src_y) { first = src_h - 1; last = -1; step = -1; }
+  for (int i = first; i != last; i += step)
+    memmove(b->pixels + (dest_y + i) * b->w + dest_x,
+            b->pixels + (src_y + i) * b->w + src_x, src_w * sizeof(unsigned));
+  return 0;
+}
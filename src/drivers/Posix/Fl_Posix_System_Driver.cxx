@@ -17,6 +17,7 @@
 #include <config.h>
 #include "Fl_Posix_System_Driver.H"
 #include "../../flstring.h"
+#include "../../fl_loop_stats.h"
 #include <FL/Fl_File_Icon.H>
 #include <FL/filename.H>
 #include <FL/fl_string.h>
@@ -29,6 +30,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <pwd.h>
 #include <unistd.h>
 #include <time.h>
@@ -56,6 +58,23 @@ void *Fl_Posix_System_Driver::load(const char *filename) {
 }
 #endif
 
+const char *Fl_Posix_System_Driver::map_file(const char *filename, size_t *size) {
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0) return NULL;
+  struct stat st;
+  void *addr = MAP_FAILED;
+  if (!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+    *size = (size_t)st.st_size;
+    addr = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  ::close(fd); // the mapping stays valid
+  return addr == MAP_FAILED ? NULL : (const char *)addr;
+}
+
+void Fl_Posix_System_Driver::unmap_file(const char *addr, size_t size) {
+  munmap((void *)addr, size);
+}
+
 int Fl_Posix_System_Driver::file_type(const char *filename)
 {
   int filetype;
@@ -307,8 +326,14 @@ bool Fl_Posix_System_Driver::probe_for_GTK(int major, int minor, void **p_ptr_gt
 #  include <unistd.h>
 #  include <fcntl.h>
 #  include <pthread.h>
-
-// Pipe for thread messaging via Fl::awake()...
+#  if HAVE_SYS_EVENTFD_H
+#    include <sys/eventfd.h>
+#    include <stdint.h>
+#  endif
+
+// Pipe (or eventfd) to wake up the main thread via Fl::awake()...
+// Messages and handlers are passed in the awake queue (see Fl_lock.cxx),
+// the file descriptor is only written when the queue was empty.
 static int thread_filedes[2];
 
 // Mutex and state information for Fl::lock() and Fl::unlock()...
@@ -354,12 +379,24 @@ static void unlock_function_rec() {
 }
 #  endif // HAVE_PTHREAD_MUTEX_RECURSIVE
 
-void Fl_Posix_System_Driver::awake(void* msg) {
+void Fl_Posix_System_Driver::awake_signal() {
   if (thread_filedes[1]) {
-    if (write(thread_filedes[1], &msg, sizeof(void*))==0) { /* ignore */ }
+#  if HAVE_SYS_EVENTFD_H
+    uint64_t one = 1;
+    if (write(thread_filedes[1], &one, sizeof(one))==0) { /* ignore */ }
+#  else
+    char c = 0;
+    if (write(thread_filedes[1], &c, 1)==0) { /* ignore */ }
+#  endif
   }
 }
 
+void Fl_Posix_System_Driver::awake(void* msg) {
+  if (!thread_filedes[1]) return; // Fl::lock() was not called
+  // a handler without function carries the message for thread_message()
+  if (Fl::add_awake_handler_(0, msg)) awake_signal();
+}
+
 static void* thread_message_;
 void* Fl_Posix_System_Driver::thread_message() {
   void* r = thread_message_;
@@ -368,13 +405,22 @@ void* Fl_Posix_System_Driver::thread_message() {
 }
 
 static void thread_awake_cb(int fd, void*) {
-  if (read(fd, &thread_message_, sizeof(void*))==0) {
-    /* This should never happen */
-  }
+  // reset the wakeup signal, then process all pending handlers in one batch
+#  if HAVE_SYS_EVENTFD_H
+  uint64_t count;
+  if (read(fd, &count, sizeof(count))<=0) { /* nothing to read */ }
+#  else
+  char buf[256];
+  if (read(fd, buf, sizeof(buf))<=0) { /* nothing to read */ }
+#  endif
   Fl_Awake_Handler func;
   void *data;
   while (Fl::get_awake_handler_(func, data)==0) {
-    (*func)(data);
+    if (func) {
+      FL_LOOP_STATS_START(t);
+      (*func)(data);
+      FL_LOOP_STATS_END(t, AWAKE, func);
+    } else thread_message_ = data;
   }
 }
 
@@ -386,14 +432,25 @@ int Fl_Posix_System_Driver::lock() {
   if (!thread_filedes[1]) {
     // Initialize thread communication pipe to let threads awake FLTK
     // from Fl::wait()
+#  if HAVE_SYS_EVENTFD_H
+    // An eventfd is a single counter, hence it can't fill up like a pipe.
+    // It is both the read and the write side of the "pipe".
+    thread_filedes[0] = thread_filedes[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (thread_filedes[0]==-1) {
+      /* this should not happen */
+    }
+#  else
     if (pipe(thread_filedes)==-1) {
       /* this should not happen */
     }
 
-    // Make the write side of the pipe non-blocking to avoid deadlock
-    // conditions (STR #1537)
+    // Make the pipe non-blocking to avoid deadlock conditions (STR #1537)
+    // and to be able to read all pending wakeup bytes at once
     fcntl(thread_filedes[1], F_SETFL,
           fcntl(thread_filedes[1], F_GETFL) | O_NONBLOCK);
+    fcntl(thread_filedes[0], F_SETFL,
+          fcntl(thread_filedes[0], F_GETFL) | O_NONBLOCK);
+#  endif
 
     // Monitor the read side of the pipe so that messages sent via
     // Fl::awake() from a thread will "wake up" the main thread in
@@ -424,7 +481,8 @@ void Fl_Posix_System_Driver::unlock() {
   fl_unlock_function();
 }
 
-// Mutex code for the awake ring buffer
+// Mutex code for the awake_once() table, and for the awake queue when
+// there are no atomic operations
 static pthread_mutex_t *ring_mutex;
 
 void Fl_Posix_System_Driver::unlock_ring() {
@@ -442,6 +500,7 @@ void Fl_Posix_System_Driver::lock_ring() {
 #else // ! HAVE_PTHREAD
 
 void Fl_Posix_System_Driver::awake(void*) {}
+void Fl_Posix_System_Driver::awake_signal() {}
 int Fl_Posix_System_Driver::lock() { return 1; }
 void Fl_Posix_System_Driver::unlock() {}
 void* Fl_Posix_System_Driver::thread_message() { return NULL; }
@@ -22,6 +22,8 @@
 #include "Fl_X11_System_Driver.H"
 #include "../Posix/Fl_Posix_System_Driver.H"
 #include "../Xlib/Fl_Xlib_Graphics_Driver.H"
+#include "../../Fl_Timeout.h"
+#include "../../fl_loop_stats.h"
 #include <FL/Fl.H>
 #include <FL/platform.H>
 #include <FL/fl_ask.H>
@@ -65,38 +67,23 @@ extern const char *fl_bg2;
 
 
 ////////////////////////////////////////////////////////////////////////
-// Timeouts are stored in a sorted list (*first_timeout), so only the
-// first one needs to be checked to see if any should be called.
-// Allocated, but unused (free) Timeout structs are stored in another
-// linked list (*free_timeout).
-
-struct Timeout {
-  double time;
-  void (*cb)(void*);
-  void* arg;
-  Timeout* next;
-};
-static Timeout* first_timeout, *free_timeout;
+// Timeouts are stored with absolute deadlines in a heap (see Fl_Timeout.h),
+// so only the first one needs to be checked to see if any should be called,
+// and neither adding nor removing a timeout needs to walk all timeouts.
+
+static Fl_Timeout timeouts;
+
+// Time of the last clock sample, used as reference for repeat_timeout().
+static double timeout_clock;
 
 // I avoid the overhead of getting the current time when we have no
 // timeouts by setting this flag instead of getting the time.
-// In this case calling elapse_timeouts() does nothing, but records
-// the current time, and the next call will actually elapse time.
+// In this case the next repeat_timeout() gets the current time first.
 static char reset_clock = 1;
 
 static void elapse_timeouts() {
-  static struct timeval prevclock;
-  struct timeval newclock;
-  gettimeofday(&newclock, NULL);
-  double elapsed = newclock.tv_sec - prevclock.tv_sec +
-    (newclock.tv_usec - prevclock.tv_usec)/1000000.0;
-  prevclock.tv_sec = newclock.tv_sec;
-  prevclock.tv_usec = newclock.tv_usec;
-  if (reset_clock) {
-    reset_clock = 0;
-  } else if (elapsed > 0) {
-    for (Timeout* t = first_timeout; t; t = t->next) t->time -= elapsed;
-  }
+  timeout_clock = Fl_Timeout::now();
+  reset_clock = 0;
 }
 
 
@@ -436,21 +423,18 @@ double Fl_X11_Screen_Driver::wait(double time_to_wait)
 {
   static char in_idle;
 
-  if (first_timeout) {
+  if (!timeouts.empty()) {
     elapse_timeouts();
-    Timeout *t;
-    while ((t = first_timeout)) {
-      if (t->time > 0) break;
-      // The first timeout in the array has expired.
-      missed_timeout_by = t->time;
-      // We must remove timeout from array before doing the callback:
-      void (*cb)(void*) = t->cb;
-      void *argp = t->arg;
-      first_timeout = t->next;
-      t->next = free_timeout;
-      free_timeout = t;
-      // Now it is safe for the callback to do add_timeout:
+    Fl_Timeout_Handler cb;
+    void *argp;
+    double deadline;
+    // The timeout is removed from the queue before doing the callback,
+    // so it is safe for the callback to do add_timeout:
+    while (timeouts.pop_expired(timeout_clock, cb, argp, deadline)) {
+      missed_timeout_by = deadline - timeout_clock;
+      FL_LOOP_STATS_START(t);
       cb(argp);
+      FL_LOOP_STATS_END(t, TIMEOUT, cb);
     }
   } else {
     reset_clock = 1; // we are not going to check the clock
@@ -465,8 +449,8 @@ double Fl_X11_Screen_Driver::wait(double time_to_wait)
     // the idle function may turn off idle, we can then wait:
     if (Fl::idle) time_to_wait = 0.0;
   }
-  if (first_timeout && first_timeout->time < time_to_wait)
-    time_to_wait = first_timeout->time;
+  if (!timeouts.empty() && timeouts.next_time() - timeout_clock < time_to_wait)
+    time_to_wait = timeouts.next_time() - timeout_clock;
   if (time_to_wait <= 0.0) {
     // do flush second so that the results of events are visible:
     int ret = this->poll_or_select_with_delay(0.0);
@@ -477,9 +461,10 @@ double Fl_X11_Screen_Driver::wait(double time_to_wait)
     Fl::flush();
     if (Fl::idle && !in_idle) // 'idle' may have been set within flush()
       time_to_wait = 0.0;
-    else if (first_timeout && first_timeout->time < time_to_wait) {
+    else if (!timeouts.empty() && timeouts.next_time() - timeout_clock < time_to_wait) {
       // another timeout may have been queued within flush(), see STR #3188
-      time_to_wait = first_timeout->time >= 0.0 ? first_timeout->time : 0.0;
+      double t = timeouts.next_time() - timeout_clock;
+      time_to_wait = t >= 0.0 ? t : 0.0;
     }
     return this->poll_or_select_with_delay(time_to_wait);
   }
@@ -488,9 +473,9 @@ double Fl_X11_Screen_Driver::wait(double time_to_wait)
 
 int Fl_X11_Screen_Driver::ready()
 {
-  if (first_timeout) {
+  if (!timeouts.empty()) {
     elapse_timeouts();
-    if (first_timeout->time <= 0) return 1;
+    if (timeouts.next_time() <= timeout_clock) return 1;
   } else {
     reset_clock = 1;
   }
@@ -631,36 +616,30 @@ const char *Fl_X11_Screen_Driver::get_system_scheme()
 //
 
 void Fl_X11_Screen_Driver::add_timeout(double time, Fl_Timeout_Handler cb, void *argp) {
+  add_timeout_id(time, cb, argp);
+}
+
+void Fl_X11_Screen_Driver::repeat_timeout(double time, Fl_Timeout_Handler cb, void *argp) {
+  repeat_timeout_id(time, cb, argp);
+}
+
+Fl_Timeout_Id Fl_X11_Screen_Driver::add_timeout_id(double time, Fl_Timeout_Handler cb, void *argp) {
   elapse_timeouts();
   missed_timeout_by = 0;
-  repeat_timeout(time, cb, argp);
+  return repeat_timeout_id(time, cb, argp);
 }
 
-void Fl_X11_Screen_Driver::repeat_timeout(double time, Fl_Timeout_Handler cb, void *argp) {
+Fl_Timeout_Id Fl_X11_Screen_Driver::repeat_timeout_id(double time, Fl_Timeout_Handler cb, void *argp) {
+  if (reset_clock) elapse_timeouts();
   time += missed_timeout_by; if (time < -.05) time = 0;
-  Timeout* t = free_timeout;
-  if (t) {
-      free_timeout = t->next;
-  } else {
-      t = new Timeout;
-  }
-  t->time = time;
-  t->cb = cb;
-  t->arg = argp;
-  // insert-sort the new timeout:
-  Timeout** p = &first_timeout;
-  while (*p && (*p)->time <= time) p = &((*p)->next);
-  t->next = *p;
-  *p = t;
+  return timeouts.add(timeout_clock + time, cb, argp);
 }
 
 /**
   Returns true if the timeout exists and has not been called yet.
 */
 int Fl_X11_Screen_Driver::has_timeout(Fl_Timeout_Handler cb, void *argp) {
-  for (Timeout* t = first_timeout; t; t = t->next)
-    if (t->cb == cb && t->arg == argp) return 1;
-  return 0;
+  return timeouts.has(cb, argp);
 }
 
 /**
@@ -671,16 +650,15 @@ int Fl_X11_Screen_Driver::has_timeout(Fl_Timeout_Handler cb, void *argp) {
         This may change in the future.
 */
 void Fl_X11_Screen_Driver::remove_timeout(Fl_Timeout_Handler cb, void *argp) {
-  for (Timeout** p = &first_timeout; *p;) {
-    Timeout* t = *p;
-    if (t->cb == cb && (t->arg == argp || !argp)) {
-      *p = t->next;
-      t->next = free_timeout;
-      free_timeout = t;
-    } else {
-      p = &(t->next);
-    }
-  }
+  timeouts.remove(cb, argp);
+}
+
+int Fl_X11_Screen_Driver::has_timeout_id(Fl_Timeout_Id id) {
+  return timeouts.has(id);
+}
+
+void Fl_X11_Screen_Driver::remove_timeout_id(Fl_Timeout_Id id) {
+  timeouts.remove(id);
 }
 
 int Fl_X11_Screen_Driver::compose(int& del) {
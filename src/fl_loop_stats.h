@@ -0,0 +1,42 @@
+//
+// Internal event loop instrumentation macros for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/*
+  Use these macros to measure a part of the event loop, see Fl_Loop_Stats:
+
+    FL_LOOP_STATS_START(t);
+    cb(data);
+    FL_LOOP_STATS_END(t, TIMEOUT, cb);
+
+  They expand to nothing unless FLTK is built with USE_EVENT_LOOP_STATS.
+*/
+
+#ifndef FL_LOOP_STATS_H
+#define FL_LOOP_STATS_H
+
+#include <config.h>
+
+#if USE_EVENT_LOOP_STATS
+#  include <FL/Fl_Loop_Stats.H>
+#  define FL_LOOP_STATS_START(t) double t = Fl_Loop_Stats::start_()
+#  define FL_LOOP_STATS_END(t, phase, func) \
+     Fl_Loop_Stats::record_(Fl_Loop_Stats::phase, (void *)(func), t)
+#else
+#  define FL_LOOP_STATS_START(t)
+#  define FL_LOOP_STATS_END(t, phase, func)
+#endif
+
+#endif // FL_LOOP_STATS_H
@@ -54,6 +54,7 @@ void Fl::set_font(Fl_Font fnum, const char* name) {
   }
   d.font_name(fnum, name);
   d.font(-1, 0);
+  Fl_Graphics_Driver::font_generation_++;
 }
 
 /** Copies one face to another. */
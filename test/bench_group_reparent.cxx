@@ -0,0 +1,95 @@
+//
+// Group re-parenting benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Moves many widgets between two groups in different orders and measures
+// the time. Every move looks up the widget in its old group with
+// Fl_Group::find() and removes it from there.
+//
+// Usage: bench_group_reparent [number of widgets]
+//
+// No window is shown, so this runs without a display.
+
+#include <FL/Fl.H>
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Box.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static void report(const char *what, int n, clock_t t) {
+  printf("%-20s %6d widgets: %8.3f s\n", what, n,
+         (double)(clock() - t) / CLOCKS_PER_SEC);
+}
+
+int main(int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 100000;
+  if (n < 1) n = 1;
+  Fl_Widget **widgets = new Fl_Widget*[n];
+  int i, errors = 0;
+
+  Fl_Group *a = new Fl_Group(0, 0, 100, 100);
+  for (i = 0; i < n; i++)
+    widgets[i] = new Fl_Box(0, 0, 10, 10);
+  a->end();
+  Fl_Group *b = new Fl_Group(0, 0, 100, 100);
+  b->end();
+
+  // a -> b, in reverse order: each widget is the last child of a
+  clock_t t = clock();
+  for (i = n; i--;)
+    b->add(widgets[i]);
+  report("move last child", n, t);
+
+  // b -> a, in creation order: each widget is the last child of b again
+  t = clock();
+  for (i = 0; i < n; i++)
+    a->add(widgets[i]);
+  report("move back", n, t);
+
+  // look up every widget, as Fl_Widget::~Fl_Widget() and insert() do
+  t = clock();
+  for (i = 0; i < n; i++)
+    if (a->find(widgets[i]) != i) errors++;
+  report("find", n, t);
+
+  // a -> b and back in a scattered order
+  srand(1);
+  int *order = new int[n];
+  for (i = 0; i < n; i++) order[i] = i;
+  for (i = n - 1; i > 0; i--) {
+    int j = rand() % (i + 1), k = order[i];
+    order[i] = order[j];
+    order[j] = k;
+  }
+  int m = n < 10000 ? n : 10000; // each move shifts the children after it
+  t = clock();
+  for (i = 0; i < m; i++)
+    b->add(widgets[order[i]]);
+  report("move random child", m, t);
+  if (a->children() + b->children() != n || b->children() != m) errors++;
+  for (i = 0; i < m; i++)
+    if (b->find(widgets[order[i]]) != i) errors++;
+
+  t = clock();
+  delete a;
+  delete b;
+  report("delete groups", n, t);
+
+  delete[] order;
+  delete[] widgets;
+  if (errors) printf("%d lookups returned a wrong index!\n", errors);
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+//
+// Fl_Simple_Terminal streaming benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Measures the sustained rate at which Fl_Simple_Terminal takes log output,
+// once with every line added right away and once in streaming mode: appends
+// lines in chunks of 100, like a program reading the output of a busy
+// process, and runs the event loop after every chunk. Prints the lines per
+// second and the number of frames that were drawn, with and without ANSI
+// colors.
+//
+// Usage: bench_terminal [number of lines] [history lines]
+//
+// This needs a display, it shows a window.
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Simple_Terminal.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CHUNK 100
+
+static void run(Fl_Simple_Terminal *tty, int lines, bool streaming, bool ansi) {
+  tty->ansi(ansi);
+  tty->streaming(streaming);
+  tty->clear();
+  Fl::flush();
+  Fl::reset_frame_stats();
+
+  clock_t t = clock();
+  for (int i = 0; i < lines; ) {
+    for (int n = 0; n < CHUNK && i < lines; n++, i++) {
+      if (ansi)
+        tty->printf("\033[32m%8d\033[0m [worker %d] \033[3%dmprocessed\033[0m item %d of the queue\n",
+                    i, i % 8, 1 + i % 6, i * 7);
+      else
+        tty->printf("%8d [worker %d] processed item %d of the queue\n", i, i % 8, i * 7);
+    }
+    Fl::check();
+  }
+  tty->flush_pending();
+  Fl::flush();
+  double s = (double)(clock() - t) / CLOCKS_PER_SEC;
+  printf("%-10s %-5s %8d lines %8.3f s %10.0f lines/s %6lu frames\n",
+         streaming ? "streaming" : "immediate", ansi ? "ansi" : "plain",
+         lines, s, s > 0 ? lines / s : 0.0, Fl::frames_drawn());
+}
+
+int main(int argc, char **argv) {
+  int lines = argc > 1 ? atoi(argv[1]) : 20000;
+  if (lines < 1) lines = 1;
+  int history = argc > 2 ? atoi(argv[2]) : 10000;
+
+  Fl_Double_Window *win = new Fl_Double_Window(800, 600, "bench_terminal");
+  Fl_Simple_Terminal *tty = new Fl_Simple_Terminal(0, 0, 800, 600);
+  tty->history_lines(history);
+  win->end();
+  win->show();
+  Fl::wait(0.5);
+  printf("%d lines, %d history lines\n", lines, history);
+
+  run(tty, lines, false, false);
+  run(tty, lines, true, false);
+  run(tty, lines, false, true);
+  run(tty, lines, true, true);
+
+  delete win;
+  return 0;
+}
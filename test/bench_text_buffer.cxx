@@ -0,0 +1,169 @@
+//
+// Text buffer storage benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Compares the GAP_BUFFER and PIECE_TABLE storage of Fl_Text_Buffer, and
+// loading a file with mapfile() into the PIECE_TABLE: loads a generated
+// text file, makes edits at random positions, counts the lines, and looks
+// up line numbers and positions of lines. The texts of all buffers are
+// compared at the end.
+//
+// Usage: bench_text_buffer [size of the file in MB] [number of edits] [mode]
+//
+// mode is "gap", "pieces" or "mapped" to test only that way of storing
+// and loading the text, and to report the peak memory use after loading
+// the file.
+//
+// No window is shown, so this runs without a display.
+
+#include <FL/Fl.H>
+#include <FL/Fl_Text_Buffer.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if !defined(_WIN32)
+#  include <sys/resource.h>
+#endif
+
+static const char *names[] = { "gap buffer", "piece table", "mapped file" };
+static const char *modes[] = { "gap", "pieces", "mapped" };
+enum { GAP, PIECES, MAPPED };
+
+static void report(const char *what, const char *storage, clock_t t) {
+  printf("%-20s %-12s %8.3f s\n", what, storage,
+         (double)(clock() - t) / CLOCKS_PER_SEC);
+}
+
+static void report_memory(const char *storage) {
+#if !defined(_WIN32)
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#  ifdef __APPLE__
+  usage.ru_maxrss /= 1024; // bytes
+#  endif
+  printf("%-20s %-12s %8ld MB\n", "peak memory", storage,
+         (long)usage.ru_maxrss / 1024);
+#endif
+}
+
+// Runs the benchmark on a new buffer and returns its text.
+static char *run(int mode, const char *file, int edits, bool memory) {
+  const char *name = names[mode];
+  Fl_Text_Buffer *buf = new Fl_Text_Buffer;
+  buf->canUndo(0);
+  if (mode == PIECES)
+    buf->storage(Fl_Text_Buffer::PIECE_TABLE);
+
+  clock_t t = clock();
+  if (mode == MAPPED ? buf->mapfile(file) : buf->loadfile(file)) {
+    perror(file);
+    exit(1);
+  }
+  report("load file", name, t);
+  if (memory)
+    report_memory(name);
+
+  srand(1);
+  t = clock();
+  for (int i = 0; i < edits; i++) {
+    int pos = rand() % buf->length();
+    int len = rand() % 16;
+    if (len > buf->length() - pos) len = buf->length() - pos;
+    if (i & 1)
+      buf->remove(pos, pos + len);
+    else
+      buf->insert(pos, "edit at a random position\n");
+  }
+  report("random edits", name, t);
+
+  t = clock();
+  int lines = buf->count_lines(0, buf->length());
+  report("count lines", name, t);
+
+  t = clock();
+  int pos = 0, n = 0;
+  while (pos < buf->length()) {
+    pos = buf->skip_lines(pos, 1);
+    n++;
+  }
+  report("skip lines", name, t);
+  if (n < lines) printf("error: %d lines skipped, %d counted\n", n, lines);
+
+  // find the line of a position and the position of a line, as
+  // Fl_Text_Display does for line numbers and when scrolling
+  t = clock();
+  for (int i = 0; i < edits; i++) {
+    int line = rand() % lines;
+    pos = buf->skip_lines(0, line);
+    if (buf->count_lines(0, pos) != line)
+      printf("error: line %d not found\n", line);
+  }
+  report("go to line", name, t);
+
+  char *text = buf->text();
+  delete buf;
+  return text;
+}
+
+int main(int argc, char **argv) {
+  int mb = argc > 1 ? atoi(argv[1]) : 16;
+  int edits = argc > 2 ? atoi(argv[2]) : 10000;
+  if (mb < 1) mb = 1;
+
+  char file[] = "/tmp/bench_text_buffer.txt";
+  FILE *f = fopen(file, "wb");
+  if (!f) {
+    perror(file);
+    return 1;
+  }
+  char line[100];
+  for (long size = 0, i = 0; size < mb * 1024L * 1024L; i++) {
+    int len = snprintf(line, sizeof(line),
+                       "%08ld The quick brown fox jumps over the lazy dog %ld\n",
+                       i, i * 7919 % 100003);
+    fwrite(line, 1, len, f);
+    size += len;
+  }
+  fclose(f);
+
+  printf("%d MB, %d edits\n", mb, edits);
+  int ret = 0;
+  if (argc > 3) {
+    int mode;
+    for (mode = GAP; mode <= MAPPED; mode++)
+      if (!strcmp(argv[3], modes[mode])) break;
+    if (mode > MAPPED) {
+      fprintf(stderr, "unknown mode %s\n", argv[3]);
+      ret = 1;
+    } else {
+      free(run(mode, file, edits, true));
+    }
+  } else {
+    char *a = run(GAP, file, edits, false);
+    for (int mode = PIECES; mode <= MAPPED; mode++) {
+      char *b = run(mode, file, edits, false);
+      if (strcmp(a, b)) {
+        printf("error: the texts of the %s and the %s are different\n",
+               names[GAP], names[mode]);
+        ret = 1;
+      }
+      free(b);
+    }
+    free(a);
+  }
+  remove(file);
+  return ret;
+}
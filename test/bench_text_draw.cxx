@@ -0,0 +1,133 @@
+//
+// Text drawing benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Measures drawing and measuring text in Fl_Text_Display with a style
+// table of monospace fonts and with one of proportional fonts: scrolls
+// page by page through the text until the given number of lines was
+// drawn, and finds the text position of several points on every line
+// that was drawn.
+//
+// Usage: bench_text_draw [number of lines]
+//
+// This needs a display, it shows a window.
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Text_Display.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static Fl_Text_Display::Style_Table_Entry mono[] = {
+  { FL_BLACK,      FL_COURIER,        14 },  // A - plain
+  { FL_DARK_GREEN, FL_COURIER_ITALIC, 14 },  // B - comments
+  { FL_BLUE,       FL_COURIER_BOLD,   14 }   // C - keywords
+};
+
+static Fl_Text_Display::Style_Table_Entry prop[] = {
+  { FL_BLACK,      FL_HELVETICA,        14 },
+  { FL_DARK_GREEN, FL_HELVETICA_ITALIC, 14 },
+  { FL_BLUE,       FL_HELVETICA_BOLD,   14 }
+};
+
+// gives access to the number of visible lines and to xy_to_position()
+class Bench_Display : public Fl_Text_Display {
+public:
+  Bench_Display(int X, int Y, int W, int H) : Fl_Text_Display(X, Y, W, H) {}
+  int visible_lines() const { return mNVisibleLines; }
+  int find(int X, int Y) const { return xy_to_position(X, Y); }
+};
+
+static void run(Fl_Window *win, Bench_Display *d, int lines,
+                Fl_Text_Display::Style_Table_Entry *styles, const char *name) {
+  d->highlight_data(d->style_buffer(), styles, 3, 'A', 0, 0);
+  d->scroll(1, 0);
+  win->redraw();
+  Fl::flush();
+
+  clock_t t = clock();
+  int top = 1, drawn = 0, page = d->visible_lines();
+  while (drawn < lines) {
+    d->scroll(top, 0);
+    d->redraw();
+    Fl::flush();
+    drawn += page;
+    top += page;
+    if (top + page > d->buffer()->count_lines(0, d->buffer()->length()))
+      top = 1;
+  }
+  double s = (double)(clock() - t) / CLOCKS_PER_SEC;
+  printf("%-12s draw     %6d lines %8.3f s %10.0f lines/s\n", name, drawn, s,
+         s > 0 ? drawn / s : 0.0);
+
+  int found = 0, h = d->textsize() + 2;
+  t = clock();
+  for (top = 1, drawn = 0; drawn < lines; drawn += page, top += page) {
+    if (top + page > d->buffer()->count_lines(0, d->buffer()->length()))
+      top = 1;
+    d->scroll(top, 0);
+    for (int i = 0; i < page; i++)
+      for (int x = 10; x < d->w(); x += 50)
+        found += d->find(d->x() + x, d->y() + i * h + h / 2) > 0;
+  }
+  s = (double)(clock() - t) / CLOCKS_PER_SEC;
+  printf("%-12s position %6d lines %8.3f s %10.0f lines/s\n", name, drawn, s,
+         s > 0 ? drawn / s : 0.0);
+}
+
+int main(int argc, char **argv) {
+  int lines = argc > 1 ? atoi(argv[1]) : 10000;
+  if (lines < 1) lines = 1;
+
+  // program-like text with a comment and a keyword on every line
+  Fl_Text_Buffer *text = new Fl_Text_Buffer;
+  Fl_Text_Buffer *style = new Fl_Text_Buffer;
+  text->canUndo(0);
+  const char *line = "  int value = compute(first, second) + 42; // a comment\n";
+  int len = (int)strlen(line);
+  char *styles = new char[len];
+  memset(styles, 'A', len);
+  memset(styles + 2, 'C', 3);
+  memset(styles + (strstr(line, "//") - line), 'B', len - (strstr(line, "//") - line));
+  char *t = new char[len * 1000 + 1], *s = new char[len * 1000 + 1];
+  for (int i = 0; i < 1000; i++) {
+    memcpy(t + i * len, line, len);
+    memcpy(s + i * len, styles, len);
+  }
+  delete[] styles;
+  t[len * 1000] = s[len * 1000] = 0;
+  text->text(t);
+  style->text(s);
+  delete[] t;
+  delete[] s;
+
+  Fl_Double_Window *win = new Fl_Double_Window(800, 600, "bench_text_draw");
+  Bench_Display *d = new Bench_Display(0, 0, 800, 600);
+  d->buffer(text);
+  d->highlight_data(style, mono, 3, 'A', 0, 0);
+  win->end();
+  win->show();
+  Fl::wait(0.5);
+
+  run(win, d, lines, mono, "monospace");
+  run(win, d, lines, prop, "proportional");
+
+  delete win;
+  delete style;
+  delete text;
+  return 0;
+}
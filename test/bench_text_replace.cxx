@@ -0,0 +1,124 @@
+//
+// Text transaction benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Measures bulk edits of a text shown in an Fl_Text_Display, once with a
+// modify callback for every edit and once in one transaction: replaces a
+// word in every line, and appends lines to the end of the text like a log
+// window. Prints the time and the number of modify callbacks.
+//
+// Usage: bench_text_replace [number of lines] [wrap]
+//
+// "wrap" turns on continuous wrap mode in the display.
+// This needs a display, it shows a window.
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Text_Display.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int callbacks;
+
+static void count_cb(int, int, int, int, const char *, void *) {
+  callbacks++;
+}
+
+static void report(const char *what, const char *how, clock_t t, int n) {
+  double s = (double)(clock() - t) / CLOCKS_PER_SEC;
+  printf("%-8s %-12s %8.3f s %8d edits %8d callbacks\n", what, how, s, n,
+         callbacks);
+}
+
+static void fill(Fl_Text_Buffer *buf, int lines) {
+  const char *line = "  int value = old_name(first, second) + 42; // a comment\n";
+  int len = (int)strlen(line);
+  char *t = new char[len * lines + 1];
+  for (int i = 0; i < lines; i++)
+    memcpy(t + i * len, line, len);
+  t[len * lines] = 0;
+  buf->text(t);
+  delete[] t;
+}
+
+// replaces old_name with new_name in every line, like test/editor used to
+static int replace_each(Fl_Text_Buffer *buf) {
+  int n = 0, pos = 0;
+  while (buf->search_forward(pos, "old_name", &pos)) {
+    buf->replace(pos, pos + 8, "new_name");
+    pos += 8;
+    n++;
+  }
+  return n;
+}
+
+static void append_lines(Fl_Text_Buffer *buf, int lines) {
+  for (int i = 0; i < lines; i++)
+    buf->printf("log line %d: the quick brown fox jumps over the lazy dog\n", i);
+}
+
+int main(int argc, char **argv) {
+  int lines = argc > 1 ? atoi(argv[1]) : 20000;
+  if (lines < 1) lines = 1;
+  bool wrap = argc > 2 && !strcmp(argv[2], "wrap");
+
+  Fl_Text_Buffer *buf = new Fl_Text_Buffer;
+  buf->add_modify_callback(count_cb, 0);
+
+  Fl_Double_Window *win = new Fl_Double_Window(800, 600, "bench_text_replace");
+  Fl_Text_Display *d = new Fl_Text_Display(0, 0, 800, 600);
+  d->buffer(buf);
+  if (wrap) d->wrap_mode(Fl_Text_Display::WRAP_AT_BOUNDS, 0);
+  win->end();
+  win->show();
+  Fl::wait(0.5);
+  printf("%d lines%s\n", lines, wrap ? ", wrapped" : "");
+
+  fill(buf, lines);
+  callbacks = 0;
+  clock_t t = clock();
+  int n = replace_each(buf);
+  report("replace", "each edit", t, n);
+  Fl::flush();
+
+  fill(buf, lines);
+  callbacks = 0;
+  t = clock();
+  n = buf->replace_all("old_name", "new_name");
+  report("replace", "replace_all", t, n);
+  Fl::flush();
+
+  buf->text("");
+  callbacks = 0;
+  t = clock();
+  append_lines(buf, lines);
+  report("append", "each edit", t, lines);
+  Fl::flush();
+
+  buf->text("");
+  callbacks = 0;
+  t = clock();
+  buf->begin_transaction();
+  append_lines(buf, lines);
+  buf->end_transaction();
+  report("append", "transaction", t, lines);
+  Fl::flush();
+
+  delete win;
+  delete buf;
+  return 0;
+}
@@ -0,0 +1,117 @@
+//
+// Text scanning benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Measures the methods of Fl_Text_Buffer that scan the text for a
+// character, a string or newlines, on a large text with the gap in the
+// middle, so that both parts of the text are scanned.
+//
+// Usage: bench_text_scan [size of the text in MB] [pieces]
+//
+// "pieces" uses the PIECE_TABLE storage instead of the gap buffer.
+// No window is shown, so this runs without a display.
+
+#include <FL/Fl.H>
+#include <FL/Fl_Text_Buffer.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double mb;
+
+static void report(const char *what, clock_t t, int result) {
+  double s = (double)(clock() - t) / CLOCKS_PER_SEC;
+  printf("%-20s %8.3f s %8.0f MB/s   (%d)\n", what, s,
+         s > 0 ? mb / s : 0.0, result);
+}
+
+int main(int argc, char **argv) {
+  int size = (argc > 1 ? atoi(argv[1]) : 1024);
+  if (size < 1) size = 1;
+  if (size > 2000) size = 2000;
+  mb = size;
+  size *= 1024 * 1024;
+  bool pieces = argc > 2 && !strcmp(argv[2], "pieces");
+
+  // lines of 40 to 80 characters, built in chunks of 1 MB
+  Fl_Text_Buffer *buf = new Fl_Text_Buffer(pieces ? 0 : size);
+  if (pieces) buf->storage(Fl_Text_Buffer::PIECE_TABLE);
+  buf->canUndo(0);
+  const int chunk = 1024 * 1024;
+  char *text = new char[chunk + 100];
+  srand(1);
+  while (buf->length() < size) {
+    int n = 0;
+    while (n < chunk) {
+      int len = 40 + rand() % 40;
+      for (int i = 0; i < len; i++)
+        text[n + i] = i % 6 == 5 ? ' ' : 'a' + rand() % 26;
+      text[n + len] = '\n';
+      n += len + 1;
+    }
+    text[n] = 0;
+    buf->append(text);
+  }
+  delete[] text;
+  // move the gap to the middle
+  int middle = buf->line_start(buf->length() / 2);
+  buf->insert(middle, "\n");
+  int end = buf->length();
+  printf("%s, %d MB, %d lines\n", pieces ? "piece table" : "gap buffer",
+         end >> 20, buf->count_lines(0, end));
+
+  int pos, n;
+  clock_t t = clock();
+  n = 0;
+  for (pos = 0; pos < end; pos += 4000)
+    n += buf->count_lines(pos, pos + 4000 < end ? pos + 4000 : end);
+  report("count_lines", t, n);
+
+  t = clock();
+  for (pos = 0, n = 0; pos < end; n++)
+    pos = buf->skip_lines(pos, 1);
+  report("skip_lines", t, n);
+
+  t = clock();
+  for (pos = end, n = 0; pos > 0; n++)
+    pos = buf->rewind_lines(pos, 1);
+  report("rewind_lines", t, n);
+
+  t = clock();
+  for (pos = 0, n = 0; pos < end; n++)
+    pos = buf->line_end(pos) + 1;
+  report("line_end", t, n);
+
+  t = clock();
+  buf->findchar_forward(0, '\t', &pos);
+  report("findchar_forward", t, pos);
+
+  t = clock();
+  buf->findchar_backward(end, '\t', &pos);
+  report("findchar_backward", t, pos);
+
+  // the words are random, so this string is not found
+  t = clock();
+  n = buf->search_forward(0, "abcde fghij", &pos, 1);
+  report("search_forward", t, n);
+
+  t = clock();
+  n = buf->search_backward(end, "abcde fghij", &pos, 1);
+  report("search_backward", t, n);
+
+  delete buf;
+  return 0;
+}
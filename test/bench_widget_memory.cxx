@@ -0,0 +1,147 @@
+//
+// Widget memory benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Creates many widgets of the common widget classes and reports how many
+// bytes each widget takes. The bytes are counted by replacing the global
+// operator new, so memory that widgets allocate with malloc() (e.g. the
+// array of children of a group, 8 bytes per child on 64-bit systems) is
+// not included.
+//
+// Usage: bench_widget_memory [number of widgets]
+//
+// No window is shown, so this runs without a display.
+
+#include <FL/Fl.H>
+#include <FL/Fl_Box.H>
+#include <FL/Fl_Button.H>
+#include <FL/Fl_Check_Button.H>
+#include <FL/Fl_Light_Button.H>
+#include <FL/Fl_Input.H>
+#include <FL/Fl_Slider.H>
+#include <FL/Fl_Value_Slider.H>
+#include <FL/Fl_Choice.H>
+#include <FL/Fl_Group.H>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if __cplusplus >= 201103L
+#  define NOTHROW noexcept
+#else
+#  define NOTHROW throw()
+#endif
+
+// keep the compiler from pairing the inlined malloc() and free() calls
+// with new and delete expressions, which some versions warn about
+#if defined(__GNUC__)
+#  define NOINLINE __attribute__((noinline))
+#else
+#  define NOINLINE
+#endif
+
+static size_t allocated = 0; // bytes allocated with operator new
+
+NOINLINE void *operator new(size_t size) {
+  allocated += size;
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+NOINLINE void operator delete(void *p) NOTHROW {
+  free(p);
+}
+
+#if __cplusplus >= 201402L
+NOINLINE void operator delete(void *p, size_t) NOTHROW {
+  free(p);
+}
+#endif
+
+static int n = 10000;
+static Fl_Widget **widgets;
+
+// Creates n widgets with make(), reports their size and deletes them.
+static void report(const char *name, size_t size, Fl_Widget *(*make)()) {
+  size_t before = allocated;
+  for (int i = 0; i < n; i++) widgets[i] = make();
+  printf("%-26s %6d %9.1f\n", name, (int)size,
+         (double)(allocated - before) / n);
+  for (int i = 0; i < n; i++) delete widgets[i];
+}
+
+#define MAKE(expr) static Fl_Widget *make_##expr() { return new expr(0, 0, 100, 25); }
+MAKE(Fl_Box)
+MAKE(Fl_Button)
+MAKE(Fl_Check_Button)
+MAKE(Fl_Light_Button)
+MAKE(Fl_Input)
+MAKE(Fl_Slider)
+MAKE(Fl_Value_Slider)
+MAKE(Fl_Choice)
+
+static Fl_Widget *make_Fl_Group() {
+  Fl_Group *o = new Fl_Group(0, 0, 100, 25);
+  o->end();
+  return o;
+}
+
+static Fl_Image image(16, 16, 3);
+
+static Fl_Widget *make_image_box() {
+  Fl_Box *o = new Fl_Box(0, 0, 100, 25, "label");
+  o->image(image);
+  return o;
+}
+
+static Fl_Widget *make_tooltip_box() {
+  Fl_Box *o = new Fl_Box(0, 0, 100, 25, "label");
+  o->tooltip("tooltip");
+  return o;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) n = atoi(argv[1]);
+  if (n < 100) n = 100;
+  widgets = new Fl_Widget*[n];
+  Fl_Group::current(0);
+
+  printf("%-26s %6s %9s\n", "widget", "sizeof", "bytes");
+  report("Fl_Box", sizeof(Fl_Box), make_Fl_Box);
+  report("Fl_Box with image", sizeof(Fl_Box), make_image_box);
+  report("Fl_Box with tooltip", sizeof(Fl_Box), make_tooltip_box);
+  report("Fl_Button", sizeof(Fl_Button), make_Fl_Button);
+  report("Fl_Check_Button", sizeof(Fl_Check_Button), make_Fl_Check_Button);
+  report("Fl_Light_Button", sizeof(Fl_Light_Button), make_Fl_Light_Button);
+  report("Fl_Input", sizeof(Fl_Input), make_Fl_Input);
+  report("Fl_Slider", sizeof(Fl_Slider), make_Fl_Slider);
+  report("Fl_Value_Slider", sizeof(Fl_Value_Slider), make_Fl_Value_Slider);
+  report("Fl_Choice", sizeof(Fl_Choice), make_Fl_Choice);
+  report("Fl_Group", sizeof(Fl_Group), make_Fl_Group);
+
+  // children of a group that has been resized, which allocates bounds()
+  size_t before = allocated;
+  Fl_Group *group = new Fl_Group(0, 0, 100, 100);
+  for (int i = 0; i < n; i++) new Fl_Box(0, 0, 10, 10);
+  group->end();
+  group->resize(0, 0, 200, 200);
+  printf("%-26s %6d %9.1f\n", "Fl_Box in a resized group", (int)sizeof(Fl_Box),
+         (double)(allocated - before) / n);
+  delete group;
+
+  delete[] widgets;
+  return 0;
+}
@@ -0,0 +1,74 @@
+//
+// Widget watch list benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Creates many widgets, watches each of them with an Fl_Widget_Tracker,
+// and measures how long it takes to delete the widgets and to release
+// the trackers. Every widget destructor calls Fl::clear_widget_pointer(),
+// so this is dominated by the watch list lookups.
+//
+// Usage: bench_widget_watch [number of widgets]
+//
+// No window is shown, so this runs without a display.
+
+#include <FL/Fl.H>
+#include <FL/Fl_Box.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double seconds(clock_t t) {
+  return (double)(clock() - t) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 100000;
+  if (n < 1) n = 1;
+  Fl_Widget **widgets = new Fl_Widget*[n];
+  Fl_Widget_Tracker **trackers = new Fl_Widget_Tracker*[n];
+  int i, errors = 0;
+
+  clock_t t = clock();
+  for (i = 0; i < n; i++) {
+    widgets[i] = new Fl_Box(0, 0, 10, 10);
+    trackers[i] = new Fl_Widget_Tracker(widgets[i]);
+  }
+  printf("create and watch %d widgets:  %8.3f s\n", n, seconds(t));
+
+  // delete every other widget while all trackers exist ...
+  t = clock();
+  for (i = 0; i < n; i += 2)
+    delete widgets[i];
+  printf("delete %d tracked widgets:    %8.3f s\n", (n + 1) / 2, seconds(t));
+
+  // ... release the trackers ...
+  t = clock();
+  for (i = 0; i < n; i++) {
+    if (trackers[i]->deleted() != !(i & 1)) errors++;
+    delete trackers[i];
+  }
+  printf("release %d trackers:          %8.3f s\n", n, seconds(t));
+
+  // ... and delete the other widgets, which are no longer watched
+  t = clock();
+  for (i = 1; i < n; i += 2)
+    delete widgets[i];
+  printf("delete %d untracked widgets:  %8.3f s\n", n / 2, seconds(t));
+
+  delete[] trackers;
+  delete[] widgets;
+  if (errors) printf("%d trackers have a wrong state!\n", errors);
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+//
+// Wrapped line layout check for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Checks the cached line layout of Fl_Text_Display in continuous wrap mode:
+// makes random edits to a text with a style table of two fonts of
+// different sizes, and restyles random ranges the way applications do it
+// without highlight_incremental(), i.e. by changing the style buffer in a
+// modify callback of the text buffer and calling redisplay_range(). After
+// every change, line counting and skipping with the layout must give the
+// same results as measuring the text with wrapped_line_counter().
+//
+// Usage: check_text_layout [number of edits]
+//
+// Prints the number of mismatches and returns 1 if there were any.
+// This needs a display, it shows a window.
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Text_Display.H>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static Fl_Text_Display::Style_Table_Entry styles[] = {
+  { FL_BLACK, FL_HELVETICA,      14 },  // A - plain
+  { FL_BLUE,  FL_HELVETICA_BOLD, 20 }   // B - wide
+};
+
+// gives access to the line counting without the layout
+class Check_Display : public Fl_Text_Display {
+public:
+  Check_Display(int X, int Y, int W, int H) : Fl_Text_Display(X, Y, W, H) {}
+  int ref_count(int start, int end, bool isLineStart) const {
+    int pos, lines, lineStart, lineEnd;
+    wrapped_line_counter(buffer(), start, end, INT_MAX, isLineStart, 0,
+                         &pos, &lines, &lineStart, &lineEnd);
+    return lines;
+  }
+  int ref_skip(int start, int n) const {
+    if (!n) return start;
+    int pos, lines, lineStart, lineEnd;
+    wrapped_line_counter(buffer(), start, buffer()->length(), n, false, 0,
+                         &pos, &lines, &lineStart, &lineEnd);
+    return pos;
+  }
+};
+
+static Fl_Text_Buffer *text, *style;
+static Check_Display *display;
+
+// fills the styles from start to end with random runs of A and B
+static void restyle(int start, int end) {
+  if (start >= end) return;
+  int n = end - start;
+  char *s = new char[n + 1];
+  for (int i = 0; i < n; ) {
+    int run = 1 + rand() % 12;
+    char c = (rand() & 1) ? 'A' : 'B';
+    for (; run > 0 && i < n; run--) s[i++] = c;
+  }
+  s[n] = 0;
+  style->replace(start, end, s);
+  delete[] s;
+  display->redisplay_range(start, end);
+}
+
+// keeps the style buffer in step with the text, like test/editor used to
+static void style_update(int pos, int nInserted, int nDeleted, int, const char *, void *) {
+  if (!nInserted && !nDeleted) return;
+  if (nDeleted) style->remove(pos, pos + nDeleted);
+  if (nInserted) {
+    char *s = new char[nInserted + 1];
+    memset(s, 'A', nInserted);
+    s[nInserted] = 0;
+    style->insert(pos, s);
+    delete[] s;
+    // restyle the rest of the line, like a comment that was started
+    restyle(pos, text->line_end(pos + nInserted));
+  }
+}
+
+int main(int argc, char **argv) {
+  int edits = argc > 1 ? atoi(argv[1]) : 2000;
+
+  text = new Fl_Text_Buffer;
+  style = new Fl_Text_Buffer;
+  Fl_Double_Window *win = new Fl_Double_Window(400, 300, "check_text_layout");
+  display = new Check_Display(0, 0, 400, 300);
+  display->buffer(text);
+  display->highlight_data(style, styles, 2, 'A', 0, 0);
+  display->wrap_mode(Fl_Text_Display::WRAP_AT_BOUNDS, 0);
+  win->end();
+  win->show();
+  Fl::wait(0.1);
+  text->add_modify_callback(style_update, 0);
+
+  const char *words[] = { "word ", "wide words ", "\n", "a long line of text that wraps ",
+                          "\t", "x", "\n\n", "mmmmmmmmmmmmmmmmmmmm " };
+  srand(1);
+  int errors = 0;
+  for (int i = 0; i < edits; i++) {
+    int len = text->length();
+    int pos = len ? text->utf8_align(rand() % (len + 1)) : 0;
+    switch (rand() % 4) {
+      case 0:
+        if (len) {
+          int end = pos + rand() % 30;
+          text->remove(pos, end > len ? len : end);
+          break;
+        }
+        // fall through
+      case 1:
+      case 2:
+        text->insert(pos, words[rand() % 8]);
+        break;
+      case 3: {
+        // restyle without a text change
+        int end = pos + rand() % 200;
+        restyle(pos, end > len ? len : end);
+        break;
+      }
+    }
+    if (i % 50 == 0) Fl::check();
+
+    len = text->length();
+    for (int k = 0; k < 5; k++) {
+      int a = len ? rand() % (len + 1) : 0, b = len ? rand() % (len + 1) : 0;
+      if (a > b) { int t = a; a = b; b = t; }
+      bool isLineStart = false;
+      if (rand() & 1) { a = text->line_start(a); isLineStart = true; }
+      int c1 = display->count_lines(a, b, isLineStart), c2 = display->ref_count(a, b, isLineStart);
+      if (c1 != c2 && errors++ < 10)
+        printf("edit %d: count_lines(%d, %d) = %d, measured %d\n", i, a, b, c1, c2);
+      int n = rand() % 30;
+      c1 = display->skip_lines(a, n, false);
+      c2 = display->ref_skip(a, n);
+      if (c1 != c2 && errors++ < 10)
+        printf("edit %d: skip_lines(%d, %d) = %d, measured %d\n", i, a, n, c1, c2);
+    }
+  }
+  printf("%d edits, %d mismatches\n", edits, errors);
+
+  delete win;
+  delete style;
+  delete text;
+  return errors ? 1 : 0;
+}
@@ -291,124 +291,39 @@ style_parse(const char *text,
 
 
 //
-// 'style_init()' - Initialize the style buffer...
+// 'style_restyle_cb()' - Restyle a part of the style buffer...
 //
 
-void
-style_init(void) {
-  char *style = new char[textbuf->length() + 1];
-  char *text = textbuf->text();
-
-  memset(style, 'A', textbuf->length());
-  style[textbuf->length()] = '\0';
-
-  if (!stylebuf) stylebuf = new Fl_Text_Buffer(textbuf->length());
-
-  style_parse(text, style, textbuf->length());
-
-  stylebuf->text(style);
-  delete[] style;
-  free(text);
-}
-
-
-//
-// 'style_unfinished_cb()' - Update unfinished styles.
-//
-
-void
-style_unfinished_cb(int, void*) {
-}
-
-
-//
-// 'style_update()' - Update the style buffer...
-//
-
-void
-style_update(int        pos,            // I - Position of update
-             int        nInserted,      // I - Number of inserted chars
-             int        nDeleted,       // I - Number of deleted chars
-             int        /*nRestyled*/,  // I - Number of restyled chars
-             const char * /*deletedText*/,// I - Text that was deleted
-             void       *cbArg) {       // I - Callback data
-  int   start,                          // Start of text
-        end;                            // End of text
-  char  last,                           // Last style on line
+int
+style_restyle_cb(int start,             // I - Start of text, a line start
+                 int end,               // I - End of text
+                 void *cbArg) {         // I - Callback data
+  char  last,                           // Last style of the text
         *style,                         // Style data
         *text;                          // Text data
 
-
-  // If this is just a selection change, just unselect the style buffer...
-  if (nInserted == 0 && nDeleted == 0) {
-    stylebuf->unselect();
-    return;
-  }
-
-  // Track changes in the text buffer...
-  if (nInserted > 0) {
-    // Insert characters into the style buffer...
-    style = new char[nInserted + 1];
-    memset(style, 'A', nInserted);
-    style[nInserted] = '\0';
-
-    stylebuf->replace(pos, pos + nDeleted, style);
-    delete[] style;
-  } else {
-    // Just delete characters in the style buffer...
-    stylebuf->remove(pos, pos + nDeleted);
-  }
-
-  // Select the area that was just updated to avoid unnecessary
-  // callbacks...
-  stylebuf->select(pos, pos + nInserted - nDeleted);
-
-  // Re-parse the changed region; we do this by parsing from the
-  // beginning of the previous line of the changed region to the end of
-  // the line of the changed region...  Then we check the last
-  // style character and keep updating if we have a multi-line
-  // comment character...
-  start = textbuf->line_start(pos);
-//  if (start > 0) start = textbuf->line_start(start - 1);
-  end   = textbuf->line_end(pos + nInserted);
+  // Parse whole lines, starting with the state at the end of the
+  // previous line...
+  end = textbuf->line_end(end);
+  if (end < textbuf->length()) end ++;
   text  = textbuf->text_range(start, end);
   style = stylebuf->text_range(start, end);
-  if (start==end)
-    last = 0;
-  else
-    last  = style[end - start - 1];
-
-//  printf("start = %d, end = %d, text = \"%s\", style = \"%s\", last='%c'...\n",
-//         start, end, text, style, last);
+  last  = style[end - start - 1];
 
+  style[0] = start > 0 ? stylebuf->byte_at(start - 1) : 'A';
+  if (style[0] == 'B' || style[0] == 'E') style[0] = 'A';
   style_parse(text, style, end - start);
 
-//  printf("new style = \"%s\", new last='%c'...\n",
-//         style, style[end - start - 1]);
-
   stylebuf->replace(start, end, style);
-  ((Fl_Text_Editor *)cbArg)->redisplay_range(start, end);
-
-  if (start==end || last != style[end - start - 1]) {
-//    printf("Recalculate the rest of the buffer style\n");
-    // Either the user deleted some text, or the last character
-    // on the line changed styles, so reparse the
-    // remainder of the buffer...
-    free(text);
-    free(style);
-
-    end   = textbuf->length();
-    text  = textbuf->text_range(start, end);
-    style = stylebuf->text_range(start, end);
 
-    style_parse(text, style, end - start);
-
-    stylebuf->replace(start, end, style);
-    ((Fl_Text_Editor *)cbArg)->redisplay_range(start, end);
-  }
+  // If the last style changed (a block comment was opened or closed),
+  // restyle the following text as well...
+  if (last != style[end - start - 1] && end < textbuf->length())
+    ((Fl_Text_Editor *)cbArg)->restyle(end, end + 1);
 
   free(text);
   free(style);
+  return end;
 }
 
 // Editor window functions and class...
@@ -735,7 +650,6 @@ void close_cb(Fl_Widget*, void* v) {
 
   w->hide();
   w->editor->buffer(0);
-  textbuf->remove_modify_callback(style_update, w->editor);
   textbuf->remove_modify_callback(changed_cb, w);
   Fl::delete_widget(w);
 
@@ -797,24 +711,8 @@ void replall_cb(Fl_Widget*, void* v) {
 
   e->replace_dlg->hide();
 
-  e->editor->insert_position(0);
-  int times = 0;
-
-  // Loop through the whole string
-  for (int found = 1; found;) {
-    int pos = e->editor->insert_position();
-    found = textbuf->search_forward(pos, find, &pos);
-
-    if (found) {
-      // Found a match; update the position and replace text...
-      textbuf->select(pos, pos + (int)strlen(find));
-      textbuf->remove_selection();
-      textbuf->insert(pos, replace);
-      e->editor->insert_position(pos + (int)strlen(replace));
-      e->editor->show_insert_position();
-      times++;
-    }
-  }
+  // Replace all in one transaction, so the editor is updated only once
+  int times = textbuf->replace_all(find, replace);
 
   if (times) fl_message("Replaced %d occurrences.", times);
   else fl_alert("No occurrences of \'%s\' found!", find);
@@ -903,7 +801,8 @@ Fl_Window* new_view() {
     w->editor->buffer(textbuf);
     w->editor->highlight_data(stylebuf, styletable,
                               sizeof(styletable) / sizeof(styletable[0]),
-                              'A', style_unfinished_cb, 0);
+                              'A', 0, 0);
+    w->editor->highlight_incremental(style_restyle_cb, w->editor);
 
 #ifdef DEV_TEST
 
@@ -940,7 +839,6 @@ Fl_Window* new_view() {
   w->size_range(300,200);
   w->callback((Fl_Callback *)close_cb, w);
 
-  textbuf->add_modify_callback(style_update, w->editor);
   textbuf->add_modify_callback(changed_cb, w);
   textbuf->call_modify_callbacks();
   num_windows++;
@@ -954,7 +852,7 @@ void cb(const char *fname) {
 int main(int argc, char **argv) {
   textbuf = new Fl_Text_Buffer;
 //textbuf->transcoding_warning_action = NULL;
-  style_init();
+  stylebuf = new Fl_Text_Buffer;
   fl_open_callback(cb);
 
   Fl_Window* window = new_view();
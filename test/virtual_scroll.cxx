@@ -0,0 +1,120 @@
+//
+// Fl_Virtual_Scroll test program for the Fast Light Tool Kit (FLTK).
+//
+// Shows a list of 50000 rows, each with a label, an input field and a
+// check button, of which only the visible rows have widgets.
+//
+// Copyright 2021 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Virtual_Scroll.H>
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Box.H>
+#include <FL/Fl_Input.H>
+#include <FL/Fl_Check_Button.H>
+#include <FL/Fl_Light_Button.H>
+#include <FL/Fl_Int_Input.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROWS 50000
+
+// the data of the list
+static char names[ROWS][32];
+static char done[ROWS];
+
+// A row widget: shows the data of the row that is stored in row().
+class Row : public Fl_Group {
+  int row_;
+  char label_[16];
+  static void name_cb(Fl_Widget *o, void *) {
+    Row *r = (Row*)o->parent();
+    strncpy(names[r->row_], ((Fl_Input*)o)->value(), 31);
+  }
+  static void done_cb(Fl_Widget *o, void *) {
+    Row *r = (Row*)o->parent();
+    done[r->row_] = ((Fl_Check_Button*)o)->value();
+  }
+public:
+  Fl_Box *number;
+  Fl_Input *name;
+  Fl_Check_Button *check;
+  Row() : Fl_Group(0, 0, 400, 25) {
+    row_ = 0;
+    box(FL_THIN_DOWN_BOX);
+    number = new Fl_Box(0, 0, 80, 25);
+    number->align(FL_ALIGN_LEFT | FL_ALIGN_INSIDE);
+    name = new Fl_Input(80, 2, 220, 21);
+    name->when(FL_WHEN_CHANGED);
+    name->callback(name_cb);
+    check = new Fl_Check_Button(310, 2, 80, 21, "done");
+    check->callback(done_cb);
+    resizable(name);
+    end();
+  }
+  void row(int r) {
+    row_ = r;
+    snprintf(label_, sizeof(label_), " row %d", r);
+    number->label(label_);
+    name->value(names[r]);
+    check->value(done[r]);
+    color(r & 1 ? FL_BACKGROUND_COLOR : fl_lighter(FL_BACKGROUND_COLOR));
+  }
+};
+
+class List : public Fl_Virtual_Scroll {
+protected:
+  Fl_Widget *create_row() { return new Row(); }
+  void update_row(Fl_Widget *w, int row) { ((Row*)w)->row(row); }
+  int row_height(int row) const {
+    return variable_heights && row % 10 == 0 ? 40 : default_row_height();
+  }
+public:
+  int variable_heights;
+  List(int X, int Y, int W, int H) : Fl_Virtual_Scroll(X, Y, W, H) {
+    variable_heights = 0;
+  }
+};
+
+List *list;
+
+void heights_cb(Fl_Widget *o, void *) {
+  list->variable_heights = ((Fl_Light_Button*)o)->value();
+  list->rows_changed();
+}
+
+void goto_cb(Fl_Widget *o, void *) {
+  list->show_row(atoi(((Fl_Int_Input*)o)->value()));
+}
+
+int main(int argc, char **argv) {
+  for (int i = 0; i < ROWS; i++)
+    snprintf(names[i], sizeof(names[i]), "item %d", i);
+  Fl_Double_Window window(420, 460, "Fl_Virtual_Scroll");
+  list = new List(0, 0, 420, 420);
+  list->box(FL_DOWN_FRAME);
+  list->end();
+  list->rows(ROWS);
+  Fl_Light_Button heights(10, 430, 150, 25, "variable heights");
+  heights.callback(heights_cb);
+  Fl_Int_Input go(260, 430, 150, 25, "go to row:");
+  go.when(FL_WHEN_ENTER_KEY);
+  go.callback(goto_cb);
+  window.resizable(list);
+  window.end();
+  window.show(argc, argv);
+  return Fl::run();
+}